@@ -47,6 +47,7 @@ parser.add_option('-i', '--input', help='name of input bundle file', dest='input
 parser.add_option('-s', '--strings', help='include these strings at head of bundle', dest='strings', default=None)
 parser.add_option('-t', '--test', help='On input: list contents of input bundle. On output: Don\'t actually write to disk', dest='test_bundle', action='store_true', default=False)
 parser.add_option('-5', '--md5', help='Print md5sum of bundle and each file', dest='show_md5', action='store_true', default=False)
+parser.add_option('-n', '--native', help='Store full width bitmaps in the frame buffer layout (firmware built with MINI_FEATURE_NATIVE_BITMAPS)', dest='native', action='store_true', default=False)
 
 (options, args) = parser.parse_args()
 
@@ -57,6 +58,10 @@ MEDIA_BITMAP = 1
 MEDIA_FONT   = 2
 RESERVED_IDS = 128
 
+BITMAP_HEADER = '=HBBBH'          # width, height, depth, flags, data size
+BITMAP_FLAG_NATIVE = 0x80         # pixel data stored page by page, one byte per column
+SCREEN_WIDTH = 128
+
 MEDIA_TYPE_NAMES = {
     MEDIA_BITMAP: 'bmap',
     MEDIA_FONT: 'font',
@@ -68,7 +73,23 @@ def imageTypeToString(imageType):
     else:
         return "unkn"
 
-def buildBundle(bundlename, stringFile, files, test_bundle=False, show_md5=False):
+def toNativeBitmap(image):
+    ''' Convert a full width bitmap to the frame buffer layout, return it unchanged otherwise
+        Bitmaps are stored column by column, bottom page first. In the frame buffer
+        layout they are stored page by page, top page first, so the firmware can copy
+        each page to its frame buffer without decoding it.
+    '''
+    if len(image) < calcsize(BITMAP_HEADER):
+        return image
+    width, height, depth, flags, dataSize = unpack(BITMAP_HEADER, image[:calcsize(BITMAP_HEADER)])
+    pages = height / 8
+    if width != SCREEN_WIDTH or depth != 1 or flags != 0 or height % 8 != 0 or dataSize != width * pages or len(image) != calcsize(BITMAP_HEADER) + dataSize:
+        return image
+    data = image[calcsize(BITMAP_HEADER):]
+    native = ''.join(data[x*pages + pages-1-page] for page in range(pages) for x in range(width))
+    return pack(BITMAP_HEADER, width, height, depth, flags | BITMAP_FLAG_NATIVE, dataSize) + native
+
+def buildBundle(bundlename, stringFile, files, test_bundle=False, show_md5=False, native=False):
     strings = []
     if stringFile:
         with open(stringFile) as fd:
@@ -97,6 +118,8 @@ def buildBundle(bundlename, stringFile, files, test_bundle=False, show_md5=False
     for filename,index in zip(files,range(len(files))):
         fd = open(filename, 'rb')
         image = fd.read()
+        if native and 'font' not in filename:
+            image = toNativeBitmap(image)
 
         imageHash = ''
         if show_md5:
@@ -208,7 +231,7 @@ def sortObjects(a,b):
 def main():
     args = [f for f in listdir(".") if isfile(join(".", f)) and join(".", f).endswith(".img") and f != "bundle.img"]
     args.sort(cmp=sortObjects);
-    buildBundle(options.output, options.strings, args, test_bundle=options.test_bundle, show_md5=options.show_md5)
+    buildBundle(options.output, options.strings, args, test_bundle=options.test_bundle, show_md5=options.show_md5, native=options.native)
     return
     #old code
     args.sort(cmp=sortObjects);
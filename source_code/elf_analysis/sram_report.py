@@ -0,0 +1,163 @@
+#!/usr/bin/env python
+#
+# CDDL HEADER START
+#
+# The contents of this file are subject to the terms of the
+# Common Development and Distribution License (the "License").
+# You may not use this file except in compliance with the License.
+#
+# You can obtain a copy of the license at src/license_cddl-1.0.txt
+# or http://www.opensolaris.org/os/licensing.
+# See the License for the specific language governing permissions
+# and limitations under the License.
+#
+# When distributing Covered Code, include this CDDL HEADER in each
+# file and include the License file at src/license_cddl-1.0.txt
+# If applicable, add the following below this CDDL HEADER, with the
+# fields enclosed by brackets "[]" replaced with your own identifying
+# information: Portions Copyright [yyyy] [name of copyright owner]
+#
+# CDDL HEADER END
+#
+# SRAM usage report
+#
+# Static usage is read from the firmware ELF with avr-size / avr-nm (llvm-size /
+# llvm-nm are used if the avr tools aren't in the PATH). The avr-nm listing also
+# used by elf_analysis.r is still accepted instead of the ELF:
+#   avr-nm --size-sort -t decimal mooltipass.elf > data_usage.txt
+# Worst case stack usage comes from the call graphs written by gcc (>= 10)
+# when the firmware is compiled with -fcallgraph-info=su (one .ci file per
+# object). Calls through function pointers are not part of these graphs.
+# The script exits with 1 when the reported usage doesn't fit in the SRAM.
+#
+# usage: sram_report.py mooltipass.elf|data_usage.txt [ci_directory] [--sram 2560] [--top 25]
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+# atmega32u4
+SRAM_SIZE = 2560
+
+# SRAM sections reported by avr-size
+SRAM_SECTIONS = (".data", ".bss", ".noinit")
+
+def is_elf(filename):
+    """ Tell if filename is an ELF file rather than an avr-nm listing """
+    with open(filename, "rb") as f:
+        return f.read(4) == b"\x7fELF"
+
+def run_tool(names, arguments):
+    """ Return the output of the first tool of names found in the PATH """
+    for name in names:
+        try:
+            return subprocess.check_output([name] + arguments).decode("ascii", "replace")
+        except OSError:
+            continue
+    sys.exit("none of %s found in the PATH" % ", ".join(names))
+
+def elf_section_sizes(filename):
+    """ Return the size of the SRAM sections of the ELF, in bytes """
+    sizes = {}
+    for line in run_tool(["avr-size", "llvm-size"], ["-A", filename]).splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0] in SRAM_SECTIONS:
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+def parse_nm(lines):
+    """ Return a list of (size, name) for the symbols located in SRAM """
+    symbols = []
+    for line in lines:
+        fields = line.split()
+        if len(fields) != 3:
+            continue
+        # .bss and .data symbols, global or local
+        if fields[1] in "bBdD":
+            symbols.append((int(fields[0]), fields[2]))
+    return sorted(symbols, reverse=True)
+
+def parse_callgraphs(directory):
+    """ Return the stack frame sizes and the call edges found in the .ci files """
+    node_re = re.compile(r'node: \{ title: "([^"]+)" label: "[^\\]+\\n[^\\]*\\n(\d+) bytes \((\w+)')
+    edge_re = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+    frames = {}
+    calls = {}
+    for root, dirs, files in os.walk(directory):
+        for filename in files:
+            if not filename.endswith(".ci"):
+                continue
+            for line in open(os.path.join(root, filename)):
+                match = node_re.search(line)
+                if match:
+                    frames[match.group(1)] = max(frames.get(match.group(1), 0), int(match.group(2)))
+                    continue
+                match = edge_re.search(line)
+                if match:
+                    calls.setdefault(match.group(1), set()).add(match.group(2))
+    return frames, calls
+
+def worst_stack_path(function, frames, calls, cache, visiting):
+    """ Return (depth, path) of the deepest call chain starting at function """
+    if function in cache:
+        return cache[function]
+    if function in visiting:
+        # Recursion, the report only follows the first iteration
+        return (0, [])
+    visiting.add(function)
+    best = (0, [])
+    for callee in calls.get(function, ()):
+        candidate = worst_stack_path(callee, frames, calls, cache, visiting)
+        if candidate[0] > best[0]:
+            best = candidate
+    visiting.discard(function)
+    cache[function] = (frames.get(function, 0) + best[0], [function] + best[1])
+    return cache[function]
+
+def main():
+    parser = argparse.ArgumentParser(description="Mooltipass SRAM usage report")
+    parser.add_argument("firmware", help="firmware ELF, or avr-nm --size-sort -t decimal output")
+    parser.add_argument("ci_directory", nargs="?", help="directory containing the -fcallgraph-info=su files")
+    parser.add_argument("--sram", type=int, default=SRAM_SIZE, help="SRAM size in bytes")
+    parser.add_argument("--top", type=int, default=25, help="number of symbols listed")
+    parser.add_argument("--entry", action="append", help="stack entry points (default: main and the interrupt vectors)")
+    args = parser.parse_args()
+
+    if is_elf(args.firmware):
+        symbols = parse_nm(run_tool(["avr-nm", "llvm-nm"], ["--size-sort", "-t", "d", args.firmware]).splitlines())
+        sections = elf_section_sizes(args.firmware)
+        # Section sizes also count the alignment padding and the unnamed objects
+        static_total = sum(sections.values())
+        print("Static SRAM: %d bytes (%s)" % (static_total, ", ".join("%s %d" % (name, sections[name]) for name in SRAM_SECTIONS if name in sections)))
+    else:
+        symbols = parse_nm(open(args.firmware))
+        static_total = sum(size for size, name in symbols)
+        print("Static SRAM: %d bytes (%d symbols)" % (static_total, len(symbols)))
+    for size, name in symbols[:args.top]:
+        print("  %5d  %s" % (size, name))
+
+    if args.ci_directory is None:
+        print("Stack headroom: %d bytes (stack usage not measured)" % (args.sram - static_total))
+        return 1 if static_total > args.sram else 0
+
+    frames, calls = parse_callgraphs(args.ci_directory)
+    entries = args.entry or ["main"] + sorted(name for name in frames if name.startswith("__vector_"))
+    cache = {}
+    worst_isr = 0
+    for entry in entries:
+        depth, path = worst_stack_path(entry, frames, calls, cache, set())
+        print("Worst stack from %s: %d bytes" % (entry, depth))
+        print("  " + " > ".join("%s(%d)" % (name, frames.get(name, 0)) for name in path))
+        if entry != "main":
+            worst_isr = max(worst_isr, depth)
+    main_depth = cache.get("main", (0, []))[0]
+    worst_total = static_total + main_depth + worst_isr
+    print("Worst case SRAM: %d static + %d main stack + %d interrupt stack = %d / %d bytes" % (static_total, main_depth, worst_isr, worst_total, args.sram))
+    if worst_total > args.sram:
+        print("SRAM overflow: %d bytes over" % (worst_total - args.sram))
+        return 1
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -89,6 +89,44 @@ void invertedClockPulseSMC(void)
     #endif
 }
 
+/*! \fn     clockPulsesSMC(uint16_t nb_pulses)
+*   \brief  Send H->L clock pulses to advance the address counter, data low
+*   \param  nb_pulses   Number of clock pulses
+*   \note   Whole bytes are clocked by the SPI controller, the remaining pulses are bit banged.
+*           Must be called in bit banging mode with clock and data low, which is kept on return.
+*/
+static void clockPulsesSMC(uint16_t nb_pulses)
+{
+    #if SPI_SMARTCARD == SPI_NATIVE
+        uint16_t nb_bytes = nb_pulses >> 3;
+
+        if (nb_bytes != 0)
+        {
+            /* SPI master mode 0 at 250kbits/s: each bit is a 4us L->H->L pulse, same as clockPulseSMC() */
+            SPCR = (1 << SPE) | (1 << MSTR) | (1 << SPR1);
+            while(nb_bytes--)
+            {
+                /* Dummy byte, data stays low */
+                SPDR = 0x00;
+                while(!(SPSR & (1<<SPIF)));
+            }
+            SPDR;
+
+            /* Back to bit banging */
+            SPCR = 0;
+        }
+
+        /* Remaining pulses */
+        nb_pulses &= 0x07;
+        while(nb_pulses--)
+        {
+            clockPulseSMC();
+        }
+    #else
+        #error "SPI not supported"
+    #endif
+}
+
 /*! \fn     clearPgmRstSignals(void)
 *   \brief  Clear PGM / RST signal for normal operation mode
 */
@@ -215,7 +253,7 @@ void blowFuse(uint8_t fuse_name)
     setBBModeAndPgmRstSMC();
 
     /* Get to the good index */
-    while(i--)clockPulseSMC();
+    clockPulsesSMC(i);
 
     /* Set RST signal */
     PORT_SC_RST |= (1 << PORTID_SC_RST);
@@ -323,8 +361,9 @@ void eraseApplicationZone1NZone2SMC(uint8_t zone1_nzone2)
         /* Switch to bit banging */
         setBBModeAndPgmRstSMC();
 
-        /* Get to the good EZx */
-        while(i--) invertedClockPulseSMC();
+        /* Get to the good EZx: i inverted pulses are i-1 full pulses followed by a rising edge */
+        clockPulsesSMC(i - 1);
+        invertedClockPulseSMC();
 
         /* How many bits to compare */
         if (zone1_nzone2 == FALSE)
@@ -413,9 +452,9 @@ RET_TYPE securityValidationSMC(volatile uint16_t* code)
         /* Switch to bit banging */
         setBBModeAndPgmRstSMC();
 
-        /* Get to the SC */
-        for(i = 0; i < 80; i++)
-            invertedClockPulseSMC();
+        /* Get to the SC: 80 inverted pulses are 79 full pulses followed by a rising edge */
+        clockPulsesSMC(79);
+        invertedClockPulseSMC();
 
         /* Clock is at high level now, as input must be switched during this time */
         /* Enter the SC */
@@ -528,7 +567,6 @@ void writeSMC(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write
 {
     uint16_t current_written_bit = 0;
     uint8_t masked_bit_to_write = 0;
-    uint16_t i;
 
     #if SPI_SMARTCARD == SPI_NATIVE
         /* Switch to bit banging */
@@ -538,26 +576,17 @@ void writeSMC(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write
         if (start_index_bit >= SMARTCARD_AZ2_BIT_START)
         {
             /* Clock pulses until AZ2 start - 1 */
-            for(i = 0; i < SMARTCARD_AZ2_BIT_START - 1; i++)
-            {
-                clockPulseSMC();            
-            }                
+            clockPulsesSMC(SMARTCARD_AZ2_BIT_START - 1);
             PORT_SPI_NATIVE |= (1 << MOSI_SPI_NATIVE);
             clockPulseSMC();
             PORT_SPI_NATIVE &= ~(1 << MOSI_SPI_NATIVE);
             /* Clock for the rest */
-            for(i = 0; i < (start_index_bit - SMARTCARD_AZ2_BIT_START); i++)
-            {
-                clockPulseSMC();            
-            }                
+            clockPulsesSMC(start_index_bit - SMARTCARD_AZ2_BIT_START);
         }
         else
         {
             /* Get to the good index, clock pulses */
-            for(i = 0; i < start_index_bit; i++)
-            {
-                clockPulseSMC();
-            }                
+            clockPulsesSMC(start_index_bit);
         }
 
         /* Start writing */
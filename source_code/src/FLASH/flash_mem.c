@@ -28,6 +28,7 @@
 #include "flash_mem.h"
 #include "defines.h"
 #include "usb.h"
+#include <util/delay.h>
 #include <avr/io.h>
 #include <stdint.h>
 #include <spi.h>
@@ -35,6 +36,11 @@
     #error "SPI not implemented"
 #endif
 
+#ifdef NODE_FEATURE_CHANGE_TRACKING
+// Set when flash pages are erased or programmed from the internal buffer
+static uint8_t flashPagesModified = FALSE;
+#endif
+
 
 /*! \fn     memoryBoundaryErrorCallback(void)
 *   \brief  Function called when a memory boundary issue occurs
@@ -177,6 +183,9 @@ void sectorZeroErase(uint8_t sectorNumber)
     opcode[2] = (uint8_t)temp_uint;
     opcode[3] = 0;    
     sendDataToFlashWithFourBytesOpcode(opcode, opcode, 0);
+    #ifdef NODE_FEATURE_CHANGE_TRACKING
+        flashPagesModified = TRUE;
+    #endif
     
     /* Wait until memory is ready */
     waitForFlash();
@@ -205,6 +214,9 @@ void sectorErase(uint8_t sectorNumber)
     opcode[2] = (uint8_t)temp_uint;
     opcode[3] = 0;    
     sendDataToFlashWithFourBytesOpcode(opcode, opcode, 0);
+    #ifdef NODE_FEATURE_CHANGE_TRACKING
+        flashPagesModified = TRUE;
+    #endif
     
     /* Wait until memory is ready */
     waitForFlash();   
@@ -217,6 +229,9 @@ void chipErase(void)
 {
     uint8_t opcode[4] = {0xC7, 0x94, 0x80, 0x9A};
     sendDataToFlashWithFourBytesOpcode(opcode, opcode, 0);
+    #ifdef NODE_FEATURE_CHANGE_TRACKING
+        flashPagesModified = TRUE;
+    #endif
     
     /* Wait until memory is ready */
     waitForFlash();   
@@ -246,6 +261,9 @@ void blockErase(uint16_t blockNumber)
     opcode[2] = (uint8_t)temp_uint;
     opcode[3] = 0;
     sendDataToFlashWithFourBytesOpcode(opcode, opcode, 0);
+    #ifdef NODE_FEATURE_CHANGE_TRACKING
+        flashPagesModified = TRUE;
+    #endif
     
     /* Wait until memory is ready */
     waitForFlash();
@@ -272,6 +290,9 @@ void pageErase(uint16_t pageNumber)
     opcode[0] = FLASH_OPCODE_PAGE_ERASE;
     fillPageReadWriteEraseOpcodeFromAddress(pageNumber, 0, &opcode[1]);    // We can add the offset as they're "don't care" in the datasheet
     sendDataToFlashWithFourBytesOpcode(opcode, opcode, 0);
+    #ifdef NODE_FEATURE_CHANGE_TRACKING
+        flashPagesModified = TRUE;
+    #endif
     
     /* Wait until memory is ready */
     waitForFlash();
@@ -433,5 +454,91 @@ void flashWriteBufferToPage(uint16_t page)
     op[0] = FLASH_OPCODE_BUF_TO_PAGE;
     fillPageReadWriteEraseOpcodeFromAddress(page, 0, &op[1]);
     sendDataToFlashWithFourBytesOpcode(op, op, 0);
+    #ifdef NODE_FEATURE_CHANGE_TRACKING
+        flashPagesModified = TRUE;
+    #endif
     waitForFlash();
-}
\ No newline at end of file
+}
+
+#ifdef MINI_FEATURE_FAST_FUNCTIONAL_TEST
+/**
+ * Start writing the contents of the internal memory buffer to a page in flash, without waiting for completion
+ * @param   page the page to store the buffer in
+ * @note    isFlashReady() tells when the write is done
+ */
+void flashStartWriteBufferToPage(uint16_t page)
+{
+    uint8_t op[4];
+    
+    op[0] = FLASH_OPCODE_BUF_TO_PAGE;
+    fillPageReadWriteEraseOpcodeFromAddress(page, 0, &op[1]);
+    sendDataToFlashWithFourBytesOpcode(op, op, 0);
+    #ifdef NODE_FEATURE_CHANGE_TRACKING
+        flashPagesModified = TRUE;
+    #endif
+}
+
+/**
+ * Reads the flash chip status register once
+ * @return  RETURN_OK if the flash isn't busy
+ */
+RET_TYPE isFlashReady(void)
+{
+    uint8_t status;
+    
+    /* Assert chip select */
+    PORT_FLASH_nS &= ~(1 << PORTID_FLASH_nS);
+    spiUsartTransfer(FLASH_OPCODE_READ_STAT_REG);
+    status = spiUsartTransfer(0);
+    /* Deassert chip select */
+    PORT_FLASH_nS |= (1 << PORTID_FLASH_nS);
+    
+    if (status & FLASH_READY_BITMASK)
+    {
+        return RETURN_OK;
+    }
+    else
+    {
+        return RETURN_NOK;
+    }
+}
+#endif
+
+#ifdef NODE_FEATURE_CHANGE_TRACKING
+/**
+ * Tells if flash pages were erased or programmed from the internal buffer since the last call
+ * @return  TRUE or FALSE
+ * @note    Partial page writes done by writeDataToFlash() aren't reported
+ */
+uint8_t haveFlashPagesBeenModified(void)
+{
+    uint8_t return_val = flashPagesModified;
+    
+    flashPagesModified = FALSE;
+    return return_val;
+}
+#endif
+
+#ifdef USB_FEATURE_SUSPEND_POWER_DOWN
+/**
+ * Put the flash in deep power-down mode (only the resume command is then accepted)
+ */
+void flashDeepPowerDown(void)
+{
+    // Bytes clocked after the opcode are ignored by the chip
+    uint8_t op[4] = {FLASH_OPCODE_DEEP_PDOWN, 0, 0, 0};
+    sendDataToFlashWithFourBytesOpcode(op, op, 0);
+}
+
+/**
+ * Resume the flash from deep power-down mode
+ */
+void flashResumeFromDeepPowerDown(void)
+{
+    uint8_t op[4] = {FLASH_OPCODE_RES_DEEP_PDOWN, 0, 0, 0};
+    sendDataToFlashWithFourBytesOpcode(op, op, 0);
+    
+    // tRDPD: time for the chip to be ready for new commands
+    _delay_us(FLASH_RES_DEEP_PDOWN_DELAY_US);
+}
+#endif
\ No newline at end of file
@@ -48,6 +48,11 @@ void flashRawRead(uint8_t* datap, uint16_t addr, uint16_t size);
 void flashWriteBuffer(uint8_t* datap, uint16_t offset, uint16_t size);
 void writeDataToFlash(uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data);
 void readDataFromFlash(uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data);
+void flashDeepPowerDown(void);
+void flashResumeFromDeepPowerDown(void);
+void flashStartWriteBufferToPage(uint16_t page);
+RET_TYPE isFlashReady(void);
+uint8_t haveFlashPagesBeenModified(void);
 
 // Defines
 /** DEFINES FLASH **/
@@ -273,6 +278,9 @@ void readDataFromFlash(uint16_t pageNumber, uint16_t offset, uint16_t dataSize,
 #define FLASH_OPCODE_BUF_WRITE        0x84  // Opcode to write into buffer
 #define FLASH_OPCODE_BUF_TO_PAGE      0x83  // Opcode to write buffer to given page
 #define FLASH_OPCODE_READ_DEV_INFO    0x9F  // Opcode to perform a Manufacturer and Device ID Read
+#define FLASH_OPCODE_DEEP_PDOWN       0xB9  // Opcode to enter deep power-down
+#define FLASH_OPCODE_RES_DEEP_PDOWN   0xAB  // Opcode to resume from deep power-down
+#define FLASH_RES_DEEP_PDOWN_DELAY_US 35    // Delay to resume from deep power-down (tRDPD)
 #define FLASH_READY_BITMASK           0x80  // Bitmask used to determine if the chip is ready (poll status register). Used with FLASH_OPCODE_READ_STAT_REG.
 #define FLASH_SECTOR_ZER0_A_PAGES     8
 #define FLASH_SECTOR_ZERO_A_CODE      0
@@ -34,6 +34,13 @@
 #define MIN_USER_INTER_DEL              7000
 // Maximum interaction delay for a prompt
 #define MAX_USER_INTER_DEL              25000
+// Display time for a non blocking information screen
+#define TOAST_SCREEN_DEL                2000
+
+// Actions once a non blocking information screen times out
+#define TOAST_ACTION_NONE               0
+#define TOAST_ACTION_BACK_TO_SCREEN     1
+#define TOAST_ACTION_SWITCH_OFF         2
 
 // Screen defines
 #if defined(HARDWARE_OLIVIER_V1)
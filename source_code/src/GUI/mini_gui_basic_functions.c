@@ -28,8 +28,10 @@
 #include "gui_screen_functions.h"
 #include "gui_basic_functions.h"
 #include "timer_manager.h"
+#include "logic_aes_and_comms.h"
 #include "logic_eeprom.h"
 #include "mini_inputs.h"
+#include "node_mgmt.h"
 #include "oledmini.h"
 #include "defines.h"
 #include "delays.h"
@@ -40,6 +42,12 @@
 
 // Screen saver on bool
 uint8_t screenSaverOn = FALSE;
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+// Set when miniTextEntry() is used to find one of the user services
+static uint8_t entry_predictive_mode = FALSE;
+// Parent node uniquely matching the current predictive entry
+static uint16_t entry_predicted_parent_addr = NODE_ADDR_NULL;
+#endif
 
 
 /*! \fn     isScreenSaverOn(void)
@@ -75,6 +83,38 @@ void activityDetectedRoutine(void)
     }
 }
 
+/*! \fn     guiSuspendUserInterface(void)
+*   \brief  Switch off the screen, the screen controller keeps its contents
+*   \note   activityDetectedRoutine() switches it back on
+*/
+void guiSuspendUserInterface(void)
+{
+    if (miniOledIsScreenOn() == TRUE)
+    {
+        miniOledOff();
+    }
+}
+
+/*! \fn     guiScreenTimeoutRoutine(void)
+*   \brief  Start the screen saver or switch off the screen after the going to sleep screen
+*/
+static void guiScreenTimeoutRoutine(void)
+{
+    #if !defined(DISABLE_SCREENSAVER)
+    if (getMooltipassParameterInEeprom(SCREENSAVER_PARAM) != FALSE)
+    {
+        screenSaverOn = TRUE;
+    }
+    else
+    {
+    #endif
+        miniOledOff();
+        guiGetBackToCurrentScreen();
+    #if !defined(DISABLE_SCREENSAVER)
+    }
+    #endif
+}
+
 /*! \fn     guiMainLoop(void)
 *   \brief  Main user interface loop
 */
@@ -83,6 +123,9 @@ void guiMainLoop(void)
     RET_TYPE input_interface_result;
     uint8_t screenSaverOnCopy;
     uint8_t isScreenOnCopy;
+    #ifdef GUI_FEATURE_TOAST_SCREENS
+    uint8_t toast_action;
+    #endif
     
     // Make a copy of the screen on & screensaver on bools
     screenSaverOnCopy = screenSaverOn;
@@ -110,24 +153,36 @@ void guiMainLoop(void)
     {
         #ifndef MINI_DEMO_VIDEO
             guiDisplayGoingToSleep();
-            userViewDelay();
-            #if !defined(DISABLE_SCREENSAVER)
-            if (getMooltipassParameterInEeprom(SCREENSAVER_PARAM) != FALSE)
-            {
-                screenSaverOn = TRUE;
-            }
-            else
-            {
-            #endif
-                miniOledOff();
-                guiGetBackToCurrentScreen();
-            #if !defined(DISABLE_SCREENSAVER)
-            }
+            #ifdef GUI_FEATURE_TOAST_SCREENS
+                guiStartToast(TOAST_ACTION_SWITCH_OFF);
+            #else
+                userViewDelay();
+                guiScreenTimeoutRoutine();
             #endif
         #else
             miniOledBitmapDrawFlash(0, 0, BITMAP_MOOLTIPASS, OLED_SCROLL_UP);
         #endif
     }
+    
+    #ifdef GUI_FEATURE_TOAST_SCREENS
+    // Any user action dismisses a displayed toast and is not passed to the screen loop
+    if ((input_interface_result != WHEEL_ACTION_NONE) && (guiIsToastDisplayed() == TRUE))
+    {
+        guiGetBackToCurrentScreen();
+        input_interface_result = WHEEL_ACTION_NONE;
+    }
+    
+    // Toast timeout
+    toast_action = guiGetExpiredToastAction();
+    if (toast_action == TOAST_ACTION_BACK_TO_SCREEN)
+    {
+        guiGetBackToCurrentScreen();
+    }
+    else if (toast_action == TOAST_ACTION_SWITCH_OFF)
+    {
+        guiScreenTimeoutRoutine();
+    }
+    #endif
 
     // If there was some activity and we are showing the screen saver
     if ((input_interface_result != WHEEL_ACTION_NONE) && (screenSaverOnCopy == TRUE))
@@ -142,6 +197,26 @@ void guiMainLoop(void)
     }
 }
 
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+/*! \fn     miniTextEntryIsOffsetSelectable(uint8_t offset, uint8_t* char_bitmap)
+*   \brief  Check if a text entry charset offset can be selected
+*   \param  offset      Charset offset, including special characters
+*   \param  char_bitmap Bitmap of the characters following the current service name prefix
+*   \return TRUE if the offset can be selected
+*/
+static inline uint8_t miniTextEntryIsOffsetSelectable(uint8_t offset, uint8_t* char_bitmap)
+{
+    char c = '\x20' + ((ENTRY_FIRST_CHAR + offset - ENTRY_NB_SPECIAL_CHAR) % ENTRY_CHARSET_LENGTH);
+
+    /* special characters are always available */
+    if ((entry_predictive_mode == FALSE) || (offset > ENTRY_CHARSET_MAX))
+    {
+        return TRUE;
+    }
+    return (IS_SERVICE_CHAR_IN_BITMAP(char_bitmap, c)) ? TRUE : FALSE;
+}
+#endif
+
 /*! \fn     miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t min, uint8_t max, char * question)
 *   \brief  Text-input GUI
 *
@@ -167,6 +242,8 @@ void guiMainLoop(void)
 *   Selectable charset is:
 *   ABCDEFGHIJKLMNOPQRSTUVWXYZ[\]^_`abcdefghijklmnopqrstuvwxyz{|}~° !"#$%&'()*+,-./0123456789:;<=>?@
 *   Special characters are appended at the end of the selectable charset.
+*   When called through miniServiceSearchEntry(), only the characters following the current
+*   prefix in the user service names can be selected, and a unique prefix is auto-completed.
 *
 *   \param  dst                   Pointer to string to be filled with user-submitted text.
 *                                 Can be pre-filled with a null-terminated string.
@@ -192,6 +269,10 @@ RET_TYPE miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t m
     uint8_t pos;            /* cursor position in destination string */
     uint8_t long_click_ctr; /* long-click tracker to detect successive long clicks */
     RET_TYPE wheel_action;  /* detected wheel action */
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+    uint8_t char_bitmap[SERVICE_CHAR_BITMAP_SIZE];  /* characters following the current prefix */
+    uint8_t prediction_needed = ENTRY_PREDICTION_ERASED;
+#endif
 
     if(filled_len) /* truncate destination string if pre-filled */
     {
@@ -236,6 +317,40 @@ RET_TYPE miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t m
 
     while(TRUE) /* rendering loop */
     {
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+        /* refresh the selectable characters when the prefix changed */
+        if ((entry_predictive_mode != FALSE) && (prediction_needed != ENTRY_PREDICTION_NONE))
+        {
+            /* only auto-complete when the user typed a character, not when erasing */
+            entry_predicted_parent_addr = getServiceNextCharacters((uint8_t*)dst, pos, (prediction_needed == ENTRY_PREDICTION_TYPED) ? buflen : 0, char_bitmap);
+
+            /* no known character after this prefix: allow all of them */
+            for (i = 0; (i < sizeof(char_bitmap)) && (char_bitmap[i] == 0); i++);
+            if (i == sizeof(char_bitmap))
+            {
+                memset(char_bitmap, 0xFF, sizeof(char_bitmap));
+            }
+
+            if ((entry_predicted_parent_addr != NODE_ADDR_NULL) && (prediction_needed == ENTRY_PREDICTION_TYPED))
+            {
+                /* unique service: prefix was completed, preselect "OK" */
+                pos = strlen(dst);
+                offset = ENTRY_CHAR_OK;
+            }
+            else
+            {
+                /* preselect the first selectable character */
+                offset = min;
+                while (miniTextEntryIsOffsetSelectable(offset, char_bitmap) == FALSE)
+                {
+                    offset++;
+                }
+            }
+            sel[0] = '\x20' + ((ENTRY_FIRST_CHAR + offset - ENTRY_NB_SPECIAL_CHAR) % ENTRY_CHARSET_LENGTH);
+            prediction_needed = ENTRY_PREDICTION_NONE;
+        }
+#endif
+
         /* compute ASCII representation of "offset" */
         ctr[0] = ((offset/100)%10 == 0 ? ' ' : '0' + (offset/100)%10);
         ctr[1] = ((((offset/10 )%10 == 0) && (ctr[0] == ' ')) ? ' ' : '0' + (offset/10 )%10);
@@ -347,6 +462,9 @@ RET_TYPE miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t m
                         pos--;
                         dst[pos] = '\0';
                         long_click_ctr=0;
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+                        prediction_needed = ENTRY_PREDICTION_ERASED;
+#endif
 
                         /* flash screen for 50 ms */
                         miniOledInvertedDisplay();
@@ -366,6 +484,9 @@ RET_TYPE miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t m
                 pos++;
                 dst[pos] = '\0';
                 long_click_ctr=0;
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+                prediction_needed = ENTRY_PREDICTION_TYPED;
+#endif
 
                 /* flash screen for 50 ms */
                 miniOledInvertedDisplay();
@@ -397,6 +518,9 @@ RET_TYPE miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t m
                     }
                     pos = 0;
                 }
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+                prediction_needed = ENTRY_PREDICTION_ERASED;
+#endif
 
                 /* flash screen for 50 ms */
                 miniOledInvertedDisplay();
@@ -405,6 +529,10 @@ RET_TYPE miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t m
                 continue;
             case WHEEL_ACTION_UP:
                 /* handle offset increment */
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+                do
+                {
+#endif
                 if((max == 0 && offset >= ENTRY_LAST_CHAR) || (max > 0 && offset >= max)) /* wrap around */
                 {
                     offset = min;
@@ -413,6 +541,9 @@ RET_TYPE miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t m
                 {
                     offset++;
                 }
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+                } while ((max == 0) && (miniTextEntryIsOffsetSelectable(offset, char_bitmap) == FALSE)); /* skip characters leading to no service */
+#endif
 
                 /* render new selected character */
                 sel[0] = '\x20' + ((ENTRY_FIRST_CHAR + offset - ENTRY_NB_SPECIAL_CHAR) % ENTRY_CHARSET_LENGTH);
@@ -420,6 +551,10 @@ RET_TYPE miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t m
                 continue;
             case WHEEL_ACTION_DOWN:
                 /* handle offset decrement */
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+                do
+                {
+#endif
                 if(offset == min) /* wrap around */
                 {
                     offset = (max > 0) ? max : ENTRY_LAST_CHAR;
@@ -428,6 +563,9 @@ RET_TYPE miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t m
                 {
                     offset--;
                 }
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+                } while ((max == 0) && (miniTextEntryIsOffsetSelectable(offset, char_bitmap) == FALSE)); /* skip characters leading to no service */
+#endif
 
                 /* render new selected character */
                 sel[0] = '\x20' + ((ENTRY_FIRST_CHAR + offset - ENTRY_NB_SPECIAL_CHAR) % ENTRY_CHARSET_LENGTH);
@@ -440,4 +578,37 @@ RET_TYPE miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t m
         } /* end switch: wheel action handling */
     } /* end while: rendering loop */
 }
+
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+/*! \fn     miniServiceSearchEntry(char * dst, uint8_t buflen, char * question)
+*   \brief  Let the user type the name of one of the user services, see miniTextEntry()
+*   \param  dst         Pointer to the buffer to be filled with the service name
+*   \param  buflen      dst buffer size, including NULL terminator
+*   \param  question    Pointer to string representing the question asked to the user
+*   \return Address of the parent node uniquely matching the typed name, or of the first service
+*           after it. NODE_ADDR_NULL if the entry was cancelled
+*/
+uint16_t miniServiceSearchEntry(char * dst, uint8_t buflen, char * question)
+{
+    RET_TYPE temp_rettype;
+
+    entry_predictive_mode = TRUE;
+    entry_predicted_parent_addr = NODE_ADDR_NULL;
+    temp_rettype = miniTextEntry(dst, buflen, 0, 0, 0, question);
+    entry_predictive_mode = FALSE;
+
+    if (temp_rettype != RETURN_OK)
+    {
+        return NODE_ADDR_NULL;
+    }
+    else if (entry_predicted_parent_addr != NODE_ADDR_NULL)
+    {
+        return entry_predicted_parent_addr;
+    }
+    else
+    {
+        return searchForServiceName((uint8_t*)dst, COMPARE_MODE_COMPARE, SERVICE_CRED_TYPE);
+    }
+}
+#endif
 #endif
\ No newline at end of file
@@ -56,8 +56,15 @@
 #define ENTRY_CHAR_CANCEL_STR    "XX"   /* special character string used for display */
 #define ENTRY_CHAR_BACKSPACE_STR "<-"   /* special character string used for display */
 
+/* Predictive service search: reason for refreshing the selectable characters */
+#define ENTRY_PREDICTION_NONE    0      /* prefix unchanged */
+#define ENTRY_PREDICTION_TYPED   1      /* a character was typed: a unique prefix gets auto-completed */
+#define ENTRY_PREDICTION_ERASED  2      /* characters were erased */
+
 RET_TYPE miniTextEntry(char * dst, uint8_t buflen, uint8_t filled_len, uint8_t min, uint8_t max, char * question);
+uint16_t miniServiceSearchEntry(char * dst, uint8_t buflen, char * question);
 void activityDetectedRoutine(void);
+void guiSuspendUserInterface(void);
 uint8_t isScreenSaverOn(void);
 void guiMainLoop(void);
 
@@ -29,6 +29,7 @@
 #include "gui_screen_functions.h"
 #include "gui_basic_functions.h"
 #include "logic_aes_and_comms.h"
+#include "scratch_arena.h"
 #include "timer_manager.h"
 #include "mini_inputs.h"
 #include "node_mgmt.h"
@@ -122,13 +123,23 @@ uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, ui
         return NODE_ADDR_NULL;
     }
 
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    // Check if there's only one child (count cached in the parent), that's a confirmation screen
+    if (getParentNodeChildCount(p) == 1)
+    #else
     // Read child node
     readChildNode(c, first_child_address);
 
     // Check if there's only one child, that's a confirmation screen
     if (c->nextChildAddress == NODE_ADDR_NULL)
+    #endif
     {
         confirmationText_t temp_conf_text;
+        
+        #ifdef NODE_FEATURE_PARENT_SUMMARY
+        // Read child node
+        readChildNode(c, first_child_address);
+        #endif
 
         // Prepare asking confirmation screen
         temp_conf_text.lines[0] = (char*)p->service;
@@ -152,12 +163,34 @@ uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, ui
         uint8_t cur_children_nb = 1;
         uint8_t nb_children = 0;
         RET_TYPE wheel_action;
-
+        #ifdef NODE_FEATURE_PARENT_SUMMARY
+        uint16_t mru_child_address = getParentNodeMruChild(p, parentNodeAddress);
+        #endif
+        #ifdef NODE_FEATURE_LOGIN_USAGE_ORDER
+        uint16_t* login_order;
+        uint8_t nb_ordered_children = getParentNodeLoginOrder(p, parentNodeAddress, &login_order);
+
+        // Credentials listed by last use, the selection starts on the most recent one
+        if (nb_ordered_children != 0)
+        {
+            nb_children = nb_ordered_children;
+            picked_child = login_order[0];
+        }
+        else
+        #endif
         // Get number of children
         while(temp_child_address != NODE_ADDR_NULL)
         {
             nb_children++;
-            readChildNode(c, temp_child_address);
+            #ifdef NODE_FEATURE_PARENT_SUMMARY
+            // Start the selection on the most recently used credential
+            if (temp_child_address == mru_child_address)
+            {
+                picked_child = temp_child_address;
+                cur_children_nb = nb_children;
+            }
+            #endif
+            readChildNodeNoDateUpdate(c, temp_child_address);
             last_child_address = temp_child_address;
             temp_child_address = c->nextChildAddress;
         }
@@ -205,7 +238,7 @@ uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, ui
                 miniOledPutCenteredString(THREE_LINE_TEXT_SECOND_POS, select_cred_line);
 
                 // Third line: chosen credential
-                readChildNode(c, picked_child);
+                readChildNodeNoDateUpdate(c, picked_child);
                 string_extra_chars[1] = strlen((char*)c->login) - miniOledPutCenteredString(THREE_LINE_TEXT_THIRD_POS, (char*)c->login + string_offset_cntrs[1]);
 
                 // Flush to display
@@ -242,6 +275,12 @@ uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, ui
                 {
                     cur_children_nb--;
                 }
+                #ifdef NODE_FEATURE_LOGIN_USAGE_ORDER
+                if (nb_ordered_children != 0)
+                {
+                    picked_child = login_order[cur_children_nb - 1];
+                }
+                #endif
             }
             else if (wheel_action == WHEEL_ACTION_UP)
             {
@@ -264,6 +303,12 @@ uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, ui
                 {
                     cur_children_nb++;
                 }
+                #ifdef NODE_FEATURE_LOGIN_USAGE_ORDER
+                if (nb_ordered_children != 0)
+                {
+                    picked_child = login_order[cur_children_nb - 1];
+                }
+                #endif
             }
             else if (wheel_action == WHEEL_ACTION_LONG_CLICK)
             {
@@ -471,11 +516,12 @@ uint16_t favoriteSelectionScreen(pNode* p, cNode* c)
     }
 }
 
-/*! \fn     loginSelectionScreen(void)
+/*! \fn     loginSelectionScreenLoop(pNode* temp_pnode_ptr)
 *   \brief  Screen displayed to let the user choose/find a login
+*   \param  temp_pnode_ptr  Buffer for the displayed parent nodes
 *   \return Valid parent node address or 0 otherwise
 */
-uint16_t loginSelectionScreen(void)
+static uint16_t loginSelectionScreenLoop(pNode* temp_pnode_ptr)
 {
     uint16_t first_address = getLastParentAddress();
     uint16_t cur_address_selected = NODE_ADDR_NULL;
@@ -486,16 +532,15 @@ uint16_t loginSelectionScreen(void)
     char current_fchar = 0;
     RET_TYPE wheel_action;
     char fchar_array[3];
-    pNode temp_pnode;
     uint8_t i;
 
     // Read first parent node, see if there's more than 2 credentials
-    readParentNode(&temp_pnode, getStartingParentAddress());
+    readParentNode(temp_pnode_ptr, getStartingParentAddress());
     if (getLastParentAddress() == getStartingParentAddress())
     {
         nb_parent_nodes = 1;
     }
-    else if (temp_pnode.nextParentAddress == getLastParentAddress())
+    else if (temp_pnode_ptr->nextParentAddress == getLastParentAddress())
     {
         first_address = getStartingParentAddress();
         nb_parent_nodes = 2;
@@ -554,20 +599,20 @@ uint16_t loginSelectionScreen(void)
             for (; (i < 3); i++)
             {
                 // Read child node to get login
-                readParentNode(&temp_pnode, temp_parent_address);
+                readParentNode(temp_pnode_ptr, temp_parent_address);
 
                 // Print Login at the correct slot
-                miniDisplayCredentialAtPosition(i, (char*)temp_pnode.service);
+                miniDisplayCredentialAtPosition(i, (char*)temp_pnode_ptr->service);
 
                 // Second child displayed is the chosen one
                 if (i == 1)
                 {
                     cur_address_selected = temp_parent_address;
-                    current_fchar = temp_pnode.service[0];
+                    current_fchar = temp_pnode_ptr->service[0];
                 }
 
                 // Fetch next address
-                temp_parent_address = temp_pnode.nextParentAddress;
+                temp_parent_address = temp_pnode_ptr->nextParentAddress;
                 if (temp_parent_address == NODE_ADDR_NULL)
                 {
                     temp_parent_address = getStartingParentAddress();
@@ -629,8 +674,8 @@ uint16_t loginSelectionScreen(void)
             }
             else
             {
-                readParentNode(&temp_pnode, first_address);
-                first_address = temp_pnode.prevParentAddress;
+                readParentNode(temp_pnode_ptr, first_address);
+                first_address = temp_pnode_ptr->prevParentAddress;
             }
         }
         else if (wheel_action == WHEEL_ACTION_CLICK_UP)
@@ -641,10 +686,10 @@ uint16_t loginSelectionScreen(void)
                 string_refresh_needed = TRUE;
 
                 // Read previous letter first node, first displayed parent is the previous node
-                readParentNode(&temp_pnode, prev_next_fletter_parents_addr[0]);
-                if (temp_pnode.prevParentAddress != NODE_ADDR_NULL)
+                readParentNode(temp_pnode_ptr, prev_next_fletter_parents_addr[0]);
+                if (temp_pnode_ptr->prevParentAddress != NODE_ADDR_NULL)
                 {
-                    first_address = temp_pnode.prevParentAddress;
+                    first_address = temp_pnode_ptr->prevParentAddress;
                 } 
                 else
                 {
@@ -660,12 +705,39 @@ uint16_t loginSelectionScreen(void)
                 string_refresh_needed = TRUE;
 
                 // Read next letter first node, first displayed parent is the previous node
-                readParentNode(&temp_pnode, prev_next_fletter_parents_addr[2]);
-                first_address = temp_pnode.prevParentAddress;
+                readParentNode(temp_pnode_ptr, prev_next_fletter_parents_addr[2]);
+                first_address = temp_pnode_ptr->prevParentAddress;
             }
         }
         else if (wheel_action == WHEEL_ACTION_LONG_CLICK)
         {
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+            // Enough services: let the user type the service name, cancelling the search leaves the screen
+            if (nb_parent_nodes >= 3)
+            {
+                char search_text[SERVICE_PREDICTION_MAX_PREFIX+1];
+
+                temp_parent_address = miniServiceSearchEntry(search_text, sizeof(search_text), ENTRY_SEARCH_QUESTION);
+                if (temp_parent_address == NODE_ADDR_NULL)
+                {
+                    return NODE_ADDR_NULL;
+                }
+
+                // Select the found service, first displayed parent is the previous node
+                string_refresh_needed = TRUE;
+                readParentNode(temp_pnode_ptr, temp_parent_address);
+                if (temp_pnode_ptr->prevParentAddress != NODE_ADDR_NULL)
+                {
+                    first_address = temp_pnode_ptr->prevParentAddress;
+                }
+                else
+                {
+                    first_address = getLastParentAddress();
+                }
+                miniWheelClearDetections();
+                continue;
+            }
+#endif
             return NODE_ADDR_NULL;
         }
 
@@ -676,6 +748,22 @@ uint16_t loginSelectionScreen(void)
     }
 }
 
+/*! \fn     loginSelectionScreen(void)
+*   \brief  Screen displayed to let the user choose/find a login
+*   \return Valid parent node address or 0 otherwise
+*/
+uint16_t loginSelectionScreen(void)
+{
+    uint16_t chosen_address = loginSelectionScreenLoop(&scratchAcquire(SCRATCH_OWNER_LOGIN_SELECT)->loginSelect.pnode);
+    
+    scratchRelease(SCRATCH_OWNER_LOGIN_SELECT);
+    #ifdef NODE_FEATURE_SERVICE_ALIAS
+    // Aliases are listed under their own names, their credentials are in the canonical service
+    chosen_address = resolveServiceAlias(chosen_address);
+    #endif
+    return chosen_address;
+}
+
 #ifdef ENABLE_CREDENTIAL_MANAGEMENT
 /*! \fn     managementActionSelectionScreen(void)
 *   \brief  Screen displayed to let the user choose a management action
@@ -31,6 +31,11 @@
 #include "defines.h"
 
 #define SEARCHTEXT_MAX_LENGTH   4
+#ifdef ENABLE_CREDENTIAL_MANAGEMENT
+    #define ENTRY_SEARCH_QUESTION   readStoredStringToBuffer(ID_STRING_MGMT_TYPE_SVCNAME)
+#else
+    #define ENTRY_SEARCH_QUESTION   "Service?"
+#endif
 
 uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, uint8_t bypass_confirmation);
 uint16_t favoriteSelectionScreen(pNode* p, cNode* c);
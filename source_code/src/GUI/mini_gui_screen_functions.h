@@ -56,6 +56,12 @@ void guiDisplayProcessingScreen(void);
 void guiGetBackToCurrentScreen(void);
 void guiDisplayGoingToSleep(void);
 uint8_t getCurrentScreen(void);
+#ifdef GUI_FEATURE_TOAST_SCREENS
+void guiDisplayInformationOnScreenToast(uint8_t stringID);
+uint8_t guiGetExpiredToastAction(void);
+void guiStartToast(uint8_t action);
+uint8_t guiIsToastDisplayed(void);
+#endif
 
 
 #endif /* MINI_GUI_SCREEN_FUNCTIONS_H_ */
\ No newline at end of file
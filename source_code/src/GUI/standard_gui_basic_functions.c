@@ -97,6 +97,26 @@ void activityDetectedRoutine(void)
     #endif
 }
 
+/*! \fn     guiSuspendUserInterface(void)
+*   \brief  Switch off the screen & lights, the screen controller keeps its contents
+*   \note   activityDetectedRoutine() switches everything back on
+*/
+void guiSuspendUserInterface(void)
+{
+    #if defined(HARDWARE_OLIVIER_V1)
+        if (areLightsOn == TRUE)
+        {
+            setPwmDc(0x0000);
+            areLightsOn = FALSE;
+        }
+    #endif
+    
+    if (oledIsOn() == TRUE)
+    {
+        oledOff();
+    }
+}
+
 #if defined(HARDWARE_OLIVIER_V1)
 /*! \fn     getTouchedPositionAnswer(uint8_t led_mask)
 *   \brief  Use the capacitive interface to get quarter position
@@ -243,6 +263,32 @@ int8_t touchWheelIntefaceLogic(RET_TYPE touch_detection_result)
 }
 #endif
 
+/*! \fn     guiScreenTimeoutRoutine(void)
+*   \brief  Start the screen saver or switch off the screen after the going to sleep screen
+*/
+static void guiScreenTimeoutRoutine(void)
+{
+    if (getMooltipassParameterInEeprom(SCREENSAVER_PARAM) != FALSE)
+    {
+        screenSaverOn = TRUE;
+        #ifndef MINI_VERSION
+        oledWriteInactiveBuffer();
+        oledClear();
+        oledDisplayOtherBuffer();
+        oledClear();
+        #endif
+    }
+    else
+    {
+        oledOff();
+        #ifndef MINI_VERSION
+        oledDisplayOtherBuffer();
+        #else
+        guiGetBackToCurrentScreen();
+        #endif
+    }
+}
+
 /*! \fn     guiMainLoop(void)
 *   \brief  Main user interface loop
 */
@@ -251,6 +297,9 @@ void guiMainLoop(void)
     RET_TYPE input_interface_result;
     uint8_t screenSaverOnCopy;
     uint8_t isScreenOnCopy;
+    #ifdef GUI_FEATURE_TOAST_SCREENS
+    uint8_t toast_action;
+    #endif
     
     #if defined(HARDWARE_OLIVIER_V1)
         // Set led mask depending on our current screen
@@ -292,31 +341,41 @@ void guiMainLoop(void)
     {
         #ifndef MINI_DEMO_VIDEO
             guiDisplayGoingToSleep();
-            userViewDelay();
-            if (getMooltipassParameterInEeprom(SCREENSAVER_PARAM) != FALSE)
-            {
-                screenSaverOn = TRUE;
-                #ifndef MINI_VERSION
-                oledWriteInactiveBuffer();
-                oledClear();
-                oledDisplayOtherBuffer();
-                oledClear();
-                #endif
-            }
-            else
-            {
-                oledOff();
-                #ifndef MINI_VERSION
-                oledDisplayOtherBuffer();
-                #else
-                guiGetBackToCurrentScreen();
-                #endif
-            }
+            #ifdef GUI_FEATURE_TOAST_SCREENS
+                guiStartToast(TOAST_ACTION_SWITCH_OFF);
+            #else
+                userViewDelay();
+                guiScreenTimeoutRoutine();
+            #endif
         #else
             oledBitmapDrawFlash(0, 0, BITMAP_MOOLTIPASS, OLED_SCROLL_UP);
         #endif
     }
     
+    #ifdef GUI_FEATURE_TOAST_SCREENS
+    // Any user action dismisses a displayed toast and is not passed to the screen loop
+    #if defined(HARDWARE_OLIVIER_V1)
+    if ((input_interface_result & TOUCH_PRESS_MASK) && (guiIsToastDisplayed() == TRUE))
+    #elif defined(MINI_VERSION)
+    if ((input_interface_result != WHEEL_ACTION_NONE) && (guiIsToastDisplayed() == TRUE))
+    #endif
+    {
+        guiGetBackToCurrentScreen();
+        input_interface_result = 0;
+    }
+    
+    // Toast timeout
+    toast_action = guiGetExpiredToastAction();
+    if (toast_action == TOAST_ACTION_BACK_TO_SCREEN)
+    {
+        guiGetBackToCurrentScreen();
+    }
+    else if (toast_action == TOAST_ACTION_SWITCH_OFF)
+    {
+        guiScreenTimeoutRoutine();
+    }
+    #endif
+    
     #if defined(HARDWARE_OLIVIER_V1)
         // If there was some activity and we are showing the screen saver
         if ((input_interface_result & TOUCH_PRESS_MASK) && (screenSaverOnCopy == TRUE))
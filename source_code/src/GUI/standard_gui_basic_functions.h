@@ -33,6 +33,7 @@
 int8_t touchWheelIntefaceLogic(RET_TYPE touch_detection_result);
 int8_t getTouchedPositionAnswer(uint8_t led_mask);
 void activityDetectedRoutine(void);
+void guiSuspendUserInterface(void);
 uint8_t isScreenSaverOn(void);
 void guiMainLoop(void);
 
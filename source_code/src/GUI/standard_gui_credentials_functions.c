@@ -29,6 +29,7 @@
 #include "gui_screen_functions.h"
 #include "gui_basic_functions.h"
 #include "logic_aes_and_comms.h"
+#include "scratch_arena.h"
 #include "timer_manager.h"
 #include "oled_wrapper.h"
 #include "mini_inputs.h"
@@ -109,6 +110,113 @@ void miniDisplayCredentialAtPosition(uint8_t position, char* credential)
 }
 #endif
 
+#ifdef HARDWARE_OLIVIER_V1
+/*! \fn     loginWindowUpdateOrderLinks(loginWindow_t* window)
+*   \brief  Set the children before and after the login window when logins are listed by use
+*   \param  window      Pointer to the login window
+*/
+static void loginWindowUpdateOrderLinks(loginWindow_t* window)
+{
+    #ifdef NODE_FEATURE_LOGIN_USAGE_ORDER
+    uint16_t next_index = window->first_index + window->nb_logins;
+    
+    if (window->login_order != 0)
+    {
+        window->prev_address = (window->first_index != 0) ? window->login_order[window->first_index - 1] : NODE_ADDR_NULL;
+        window->next_address = (next_index < window->nb_ordered_children) ? window->login_order[next_index] : NODE_ADDR_NULL;
+    }
+    #else
+    (void)window;
+    #endif
+}
+
+/*! \fn     loginWindowAddLogin(loginWindow_t* window, cNode* c, uint8_t at_end)
+*   \brief  Read the child right after or right before the login window and add it to the window
+*   \param  window      Pointer to the login window
+*   \param  c           Pointer to a child node, used as read buffer
+*   \param  at_end      TRUE to add the child after the window, FALSE before it
+*   \note   When the window is full, the page at its other end is dropped
+*/
+static void loginWindowAddLogin(loginWindow_t* window, cNode* c, uint8_t at_end)
+{
+    uint8_t slot;
+    
+    if (at_end != FALSE)
+    {
+        readChildNodeNoDateUpdate(c, window->next_address);
+        
+        // Full window: forget its first page
+        if (window->nb_logins == LOGIN_WINDOW_SIZE)
+        {
+            window->prev_address = window->addresses[LOGIN_WINDOW_PAGE_SIZE-1];
+            window->first_index += LOGIN_WINDOW_PAGE_SIZE;
+            window->nb_logins -= LOGIN_WINDOW_PAGE_SIZE;
+            memmove(window->addresses, &window->addresses[LOGIN_WINDOW_PAGE_SIZE], window->nb_logins*sizeof(window->addresses[0]));
+            memmove(window->logins, window->logins[LOGIN_WINDOW_PAGE_SIZE], window->nb_logins*sizeof(window->logins[0]));
+        }
+        
+        slot = window->nb_logins;
+        window->addresses[slot] = window->next_address;
+        window->next_address = c->nextChildAddress;
+    }
+    else
+    {
+        readChildNodeNoDateUpdate(c, window->prev_address);
+        
+        // Full window: forget its last page
+        if (window->nb_logins == LOGIN_WINDOW_SIZE)
+        {
+            window->nb_logins -= LOGIN_WINDOW_PAGE_SIZE;
+            window->next_address = window->addresses[window->nb_logins];
+        }
+        
+        slot = 0;
+        memmove(&window->addresses[1], window->addresses, window->nb_logins*sizeof(window->addresses[0]));
+        memmove(window->logins[1], window->logins, window->nb_logins*sizeof(window->logins[0]));
+        window->addresses[slot] = window->prev_address;
+        window->prev_address = c->prevChildAddress;
+        window->first_index--;
+    }
+    
+    // Store the truncated login
+    memcpy(window->logins[slot], (char*)c->login, INDEX_TRUNCATE_LOGIN_FAV);
+    window->logins[slot][INDEX_TRUNCATE_LOGIN_FAV] = 0;
+    window->nb_logins++;
+    loginWindowUpdateOrderLinks(window);
+}
+
+/*! \fn     loginWindowSetPage(loginWindow_t* window, cNode* c, uint16_t page_index)
+*   \brief  Make sure the logins of a page are in the login window, reading only the missing ones
+*   \param  window      Pointer to the login window
+*   \param  c           Pointer to a child node, used as read buffer
+*   \param  page_index  Display index of the first login of the page
+*   \return Number of logins on the page
+*/
+static uint8_t loginWindowSetPage(loginWindow_t* window, cNode* c, uint16_t page_index)
+{
+    uint16_t window_end;
+    
+    // Walk back to the page start
+    while (page_index < window->first_index)
+    {
+        loginWindowAddLogin(window, c, FALSE);
+    }
+    
+    // Walk forward until the page is complete or there are no more children
+    while ((window->first_index + window->nb_logins < page_index + LOGIN_WINDOW_PAGE_SIZE) && (window->next_address != NODE_ADDR_NULL))
+    {
+        loginWindowAddLogin(window, c, TRUE);
+    }
+    
+    window_end = window->first_index + window->nb_logins;
+    if (window_end - page_index > LOGIN_WINDOW_PAGE_SIZE)
+    {
+        return LOGIN_WINDOW_PAGE_SIZE;
+    }
+    return (uint8_t)(window_end - page_index);
+}
+#endif
+
 /*! \fn     guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress)
 *   \brief  Ask for user login selection / approval
 *   \param  p                   Pointer to a parent node
@@ -116,10 +224,11 @@ void miniDisplayCredentialAtPosition(uint8_t position, char* credential)
 *   \param  parentNodeAddress   Address of the parent node
 *   \param  bypass_confirmation Bool to bypass authorisation request
 *   \return Valid child node address or 0 otherwise
+*   \note   p & c are expected to be the context nodes, the login window is stored right after them in the scratch arena
 */
 uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, uint8_t bypass_confirmation)
 {
-    uint16_t first_child_address, temp_child_address;
+    uint16_t first_child_address;
     uint16_t picked_child = NODE_ADDR_NULL;
     
     // Check parent node address
@@ -141,14 +250,24 @@ uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, ui
         return NODE_ADDR_NULL;
     }
     
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    // Check if there's only one child (count cached in the parent), that's a confirmation screen
+    if (getParentNodeChildCount(p) == 1)
+    #else
     // Read child node
     readChildNode(c, first_child_address);
     
     // Check if there's only one child, that's a confirmation screen
     if (c->nextChildAddress == NODE_ADDR_NULL)
+    #endif
     {
         confirmationText_t temp_conf_text;
         
+        #ifdef NODE_FEATURE_PARENT_SUMMARY
+        // Read child node
+        readChildNode(c, first_child_address);
+        #endif
+        
         // Prepare asking confirmation screen
         #if defined(HARDWARE_OLIVIER_V1)
             temp_conf_text.lines[0] = readStoredStringToBuffer(ID_STRING_CONFACCESSTO);
@@ -174,11 +293,28 @@ uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, ui
     else
     {
         #if defined(HARDWARE_OLIVIER_V1)
-            temp_child_address = first_child_address;
+            uint16_t first_displayed_child = 0;
             uint8_t action_chosen = FALSE;
-            uint16_t addresses[4];
+            // Login window in the scratch arena, after the context nodes our parent & child nodes belong to
+            loginWindow_t* login_window = &scratchAcquire(SCRATCH_OWNER_LOGIN_SELECT)->loginWindow.window;
+            uint8_t more_logins;
             uint8_t led_mask;
             int8_t i, j;
+            
+            // Empty login window, right before the first child
+            login_window->first_index = 0;
+            login_window->nb_logins = 0;
+            login_window->prev_address = NODE_ADDR_NULL;
+            login_window->next_address = first_child_address;
+            #ifdef NODE_FEATURE_LOGIN_USAGE_ORDER
+            // Most recently used logins first, child list order if the service has too many logins
+            login_window->nb_ordered_children = getParentNodeLoginOrder(p, parentNodeAddress, &login_window->login_order);
+            if (login_window->nb_ordered_children == 0)
+            {
+                login_window->login_order = 0;
+            }
+            loginWindowUpdateOrderLinks(login_window);
+            #endif
         
             while (action_chosen == FALSE)
             {
@@ -193,25 +329,17 @@ uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, ui
             
                 // Clear led_mask
                 led_mask = 0;
-                i = 0;
-            
-                // List logins on screen
-                while ((temp_child_address != NODE_ADDR_NULL) && (i != 4))
-                {
-                    // Read child node to get login
-                    readChildNode(c, temp_child_address);
-                
-                    // Print Login at the correct slot
-                    displayCredentialAtSlot(i, (char*)c->login, INDEX_TRUNCATE_LOGIN_FAV);            
                 
-                    // Store address in array, fetch next address
-                    addresses[i] = temp_child_address;
-                    temp_child_address = c->nextChildAddress;
-                    i++;
+                // List logins on screen, flash is only read when the page isn't in the login window
+                i = loginWindowSetPage(login_window, c, first_displayed_child);
+                for (j = 0; j < i; j++)
+                {
+                    displayCredentialAtSlot(j, login_window->logins[first_displayed_child - login_window->first_index + j], INDEX_TRUNCATE_LOGIN_FAV);
                 }
+                more_logins = ((first_displayed_child + LOGIN_WINDOW_PAGE_SIZE < login_window->first_index + login_window->nb_logins) || (login_window->next_address != NODE_ADDR_NULL));
             
                 // If nothing after, hide right arrow
-                if ((i != 4) || (c->nextChildAddress == NODE_ADDR_NULL))
+                if ((i != 4) || (more_logins == FALSE))
                 {
                     oledFillXY(177, 25, 16, 14, 0x00);
                     led_mask |= LED_MASK_RIGHT;
@@ -237,20 +365,15 @@ uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, ui
                 }
                 else if (j < i)
                 {
-                    picked_child = addresses[j];
+                    picked_child = login_window->addresses[first_displayed_child - login_window->first_index + j];
                     action_chosen = TRUE;
                 }
                 else if (j == TOUCHPOS_LEFT)
                 {                
-                    // If there is a previous children, go back 4 indexes
-                    if (addresses[0] != first_child_address)
+                    // If there are previous children, go back 4 indexes
+                    if (first_displayed_child != 0)
                     {
-                        c->prevChildAddress = addresses[0];
-                        for (i = 0; i < 5; i++)
-                        {
-                            temp_child_address = c->prevChildAddress;
-                            readChildNode(c, temp_child_address);
-                        }
+                        first_displayed_child -= LOGIN_WINDOW_PAGE_SIZE;
                     }
                     else
                     {
@@ -258,21 +381,18 @@ uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, ui
                         action_chosen = TRUE;
                     }
                 }
-                else if ((j == TOUCHPOS_RIGHT) && (i == 4) && (c->nextChildAddress != NODE_ADDR_NULL))
+                else if ((j == TOUCHPOS_RIGHT) && (i == 4) && (more_logins != FALSE))
                 {
                     // If there are more nodes to display, let it loop
-                    // temp_child_address = c->nextChildAddress;
-                }
-                else
-                {
-                    // Wrong position
-                    temp_child_address = addresses[0];
+                    first_displayed_child += LOGIN_WINDOW_PAGE_SIZE;
                 }
+                // Wrong position: the same page is displayed again from the login window
             }
+            scratchRelease(SCRATCH_OWNER_LOGIN_SELECT);
         #elif defined(MINI_VERSION)
             // Temp variables
             uint16_t last_child_address = first_child_address;
-            temp_child_address = first_child_address;
+            uint16_t temp_child_address = first_child_address;
             uint8_t string_refresh_needed = TRUE;
             picked_child = first_child_address;
             uint8_t action_chosen = FALSE;
@@ -718,7 +838,7 @@ uint16_t favoriteSelectionScreen(pNode* p, cNode* c)
 static inline uint8_t displayCurrentSearchLoginTexts(char* text, uint16_t* resultsarray, uint8_t search_index)
 {
     uint16_t tempNodeAddr;
-    pNode temp_pnode;
+    pNode* temp_pnode_ptr;
     uint8_t i, j;
     
     // Set font for search text
@@ -740,6 +860,7 @@ static inline uint8_t displayCurrentSearchLoginTexts(char* text, uint16_t* resul
     if (tempNodeAddr != last_matching_parent_addr)
     {
         last_matching_parent_addr = tempNodeAddr;
+        temp_pnode_ptr = &scratchAcquire(SCRATCH_OWNER_LOGIN_SELECT)->loginSelect.pnode;
         
         for (i = 0; i < 4; i++)
         {
@@ -752,21 +873,21 @@ static inline uint8_t displayCurrentSearchLoginTexts(char* text, uint16_t* resul
         while ((temp_bool != FALSE) && (i != 5))
         {
             resultsarray[i] = tempNodeAddr;
-            readParentNode(&temp_pnode, tempNodeAddr);
+            readParentNode(temp_pnode_ptr, tempNodeAddr);
             
             // Display only first 4 services
             if (i < 4)
             {
-                displayCredentialAtSlot(i, (char*)temp_pnode.service, INDEX_TRUNCATE_SERVICE_SEARCH);
+                displayCredentialAtSlot(i, (char*)temp_pnode_ptr->service, INDEX_TRUNCATE_SERVICE_SEARCH);
             }
             // Loop around
-            if (temp_pnode.nextParentAddress == NODE_ADDR_NULL)
+            if (temp_pnode_ptr->nextParentAddress == NODE_ADDR_NULL)
             {
                 tempNodeAddr = getStartingParentAddress();
             } 
             else
             {
-                tempNodeAddr = temp_pnode.nextParentAddress;
+                tempNodeAddr = temp_pnode_ptr->nextParentAddress;
             }
             i++;
             // Check that we haven't already displayed the next node
@@ -783,7 +904,7 @@ static inline uint8_t displayCurrentSearchLoginTexts(char* text, uint16_t* resul
         if (i == 5)
         {       
             // Compare our text with the last service text and see if they match
-            if (strncmp(text, (char*)temp_pnode.service, search_index + 1) == 0)
+            if (strncmp(text, (char*)temp_pnode_ptr->service, search_index + 1) == 0)
             {
                 // show arrow
                 oledBitmapDrawFlash(176, 24, BITMAP_LOGIN_RARROW, 0);
@@ -798,6 +919,7 @@ static inline uint8_t displayCurrentSearchLoginTexts(char* text, uint16_t* resul
         
         // Store and return number of children
         last_matching_parent_number = i;
+        scratchRelease(SCRATCH_OWNER_LOGIN_SELECT);
     }
     
          
@@ -813,6 +935,39 @@ static inline uint8_t displayCurrentSearchLoginTexts(char* text, uint16_t* resul
 }
 #endif
 
+#if defined(HARDWARE_OLIVIER_V1) && defined(GUI_FEATURE_PREDICTIVE_SEARCH)
+/*! \fn     getSearchNextCharacters(char* text, uint8_t length, uint8_t* char_bitmap)
+*   \brief  Get the search characters (a to z then 0 to 9) following the current search prefix
+*   \param  text            Search text
+*   \param  length          Search prefix length
+*   \param  char_bitmap     Bitmap in which the characters following the search prefix are set
+*   \return The first character following the search prefix
+*   \note   If no search character follows the prefix, all of them are set
+*/
+static char getSearchNextCharacters(char* text, uint8_t length, uint8_t* char_bitmap)
+{
+    char c;
+
+    getServiceNextCharacters((uint8_t*)text, length, 0, char_bitmap);
+    for (c = 'a'; c <= 'z'; c++)
+    {
+        if (IS_SERVICE_CHAR_IN_BITMAP(char_bitmap, c))
+        {
+            return c;
+        }
+    }
+    for (c = '0'; c <= '9'; c++)
+    {
+        if (IS_SERVICE_CHAR_IN_BITMAP(char_bitmap, c))
+        {
+            return c;
+        }
+    }
+    memset(char_bitmap, 0xFF, SERVICE_CHAR_BITMAP_SIZE);
+    return 'a';
+}
+#endif
+
 /*! \fn     loginSelectionScreen(void)
 *   \brief  Screen displayed to let the user choose/find a login
 *   \return Valid parent node address or 0 otherwise
@@ -1004,11 +1159,19 @@ uint16_t loginSelectionScreen(void)
     RET_TYPE temp_rettype;
     uint8_t led_mask = 0;
     int8_t temp_int8;
+    #ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+    uint8_t char_bitmap[SERVICE_CHAR_BITMAP_SIZE];
+    uint8_t i;
+    #endif
     
     // Set current text to a
     last_matching_parent_addr = NODE_ADDR_NULL;
     last_matching_parent_number = 0;
     memcpy(currentText, "a\x00\x00\x00\x00", sizeof(currentText));
+    #ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+    // Start with the first letter of our services
+    currentText[0] = getSearchNextCharacters(currentText, 0, char_bitmap);
+    #endif
     
     // Draw bitmap, display it and write active buffer
     oledBitmapDrawFlash(0, 0, BITMAP_LOGIN_FIND, 0);
@@ -1023,6 +1186,23 @@ uint16_t loginSelectionScreen(void)
             nbMatchedParents = displayCurrentSearchLoginTexts(currentText, tempParentAddresses, currentStringIndex);
             displayRefreshNeeded = FALSE;
             
+            #ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+            // Only one service for the current search text: only offer this one
+            if ((nbMatchedParents > 1) && (getServiceNextCharacters((uint8_t*)currentText, currentStringIndex + 1, 0, char_bitmap) != NODE_ADDR_NULL))
+            {
+                for (i = 1; i < 4; i++)
+                {
+                    oledFillXY((i&1)*170, 2+(i&2)*23, 84, 14, 0x00);
+                }
+                oledFillXY(176, 24, 16, 16, 0);
+                nbMatchedParents = 1;
+                // Force a full redraw for the next search text
+                last_matching_parent_addr = NODE_ADDR_NULL;
+            }
+            // Characters following our current search prefix
+            getSearchNextCharacters(currentText, currentStringIndex, char_bitmap);
+            #endif
+            
             // Light only the available choices and right arrow
             led_mask = 0;
             for (temp_int8 = nbMatchedParents; temp_int8 < 5; temp_int8++)
@@ -1061,6 +1241,12 @@ uint16_t loginSelectionScreen(void)
         // Position increment / decrement
         if (temp_int8 != 0)
         {
+            #ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+            // Skip the characters that don't lead to any service
+            i = 0;
+            do
+            {
+            #endif
             if ((currentText[currentStringIndex] == 0x7A) && (temp_int8 == 1))
             {
                 // z->0 wrap
@@ -1082,6 +1268,10 @@ uint16_t loginSelectionScreen(void)
                 currentText[currentStringIndex] = 0x3A;
             }
             currentText[currentStringIndex] += temp_int8;
+            #ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+            }
+            while ((++i < SEARCHTEXT_CHARSET_LENGTH) && !IS_SERVICE_CHAR_IN_BITMAP(char_bitmap, currentText[currentStringIndex]));
+            #endif
             displayRefreshNeeded = TRUE;
         }
         
@@ -1107,6 +1297,9 @@ uint16_t loginSelectionScreen(void)
         {
             // Change search index only if we need to...
             currentText[++currentStringIndex] = 'a';
+            #ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+            currentText[currentStringIndex] = getSearchNextCharacters(currentText, currentStringIndex, char_bitmap);
+            #endif
             displayRefreshNeeded = TRUE;
         }
     }
@@ -1114,6 +1307,10 @@ uint16_t loginSelectionScreen(void)
     // Set inactive buffer write by default
     oledWriteInactiveBuffer();
     
+    #ifdef NODE_FEATURE_SERVICE_ALIAS
+    // Aliases are listed under their own names, their credentials are in the canonical service
+    ret_val = resolveServiceAlias(ret_val);
+    #endif
     return ret_val;
 #endif
 }    
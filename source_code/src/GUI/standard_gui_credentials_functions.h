@@ -29,8 +29,30 @@
 
 #include "node_mgmt.h"
 #include "defines.h"
+#include "gui.h"
 
 #define SEARCHTEXT_MAX_LENGTH   4
+#define SEARCHTEXT_CHARSET_LENGTH   36     // a to z then 0 to 9
+
+// Login selection screen: logins per page and pages kept in RAM (displayed page and its neighbors)
+#define LOGIN_WINDOW_PAGE_SIZE      4
+#define LOGIN_WINDOW_NB_PAGES       3
+#define LOGIN_WINDOW_SIZE           (LOGIN_WINDOW_PAGE_SIZE*LOGIN_WINDOW_NB_PAGES)
+
+// Logins of consecutive children, in display order
+typedef struct
+{
+    uint16_t addresses[LOGIN_WINDOW_SIZE];                      // Child node addresses
+    char logins[LOGIN_WINDOW_SIZE][INDEX_TRUNCATE_LOGIN_FAV+1]; // Truncated logins
+    uint16_t prev_address;                                      // Child displayed before the window, NODE_ADDR_NULL if none
+    uint16_t next_address;                                      // Child displayed after the window, NODE_ADDR_NULL if none
+    uint16_t first_index;                                       // Display index of the first window entry
+    uint8_t nb_logins;                                          // Number of logins in the window
+    #ifdef NODE_FEATURE_LOGIN_USAGE_ORDER
+    uint16_t* login_order;                                      // Display order, 0 to follow the child list
+    uint8_t nb_ordered_children;                                // Number of entries in login_order
+    #endif
+} loginWindow_t;
 
 uint16_t guiAskForLoginSelect(pNode* p, cNode* c, uint16_t parentNodeAddress, uint8_t bypass_confirmation);
 uint16_t favoriteSelectionScreen(pNode* p, cNode* c);
@@ -47,6 +47,10 @@
 
 // Our current screen
 uint8_t currentScreen = SCREEN_DEFAULT_NINSERTED;
+#ifdef GUI_FEATURE_TOAST_SCREENS
+// Action to take once the displayed toast times out
+uint8_t toastAction = TOAST_ACTION_NONE;
+#endif
 
 
 /*! \fn     getCurrentScreen(void)
@@ -72,6 +76,11 @@ void guiSetCurrentScreen(uint8_t screen)
 */
 void guiGetBackToCurrentScreen(void)
 {
+    #ifdef GUI_FEATURE_TOAST_SCREENS
+    // A possibly displayed toast is replaced by the current screen
+    toastAction = TOAST_ACTION_NONE;
+    #endif
+    
     #if defined(MINI_VERSION)
         switch (currentScreen)
         {
@@ -159,8 +168,12 @@ void guiScreenLoop(uint8_t input_interface_result)
         else if (currentScreen == SCREEN_MEMORY_MGMT)
         {
             // Currently in memory management mode, tell the user to finish it via the plugin/app
-            guiDisplayInformationOnScreenAndWait(ID_STRING_CLOSEMEMMGMT);
-            guiGetBackToCurrentScreen();
+            #ifdef GUI_FEATURE_TOAST_SCREENS
+                guiDisplayInformationOnScreenToast(ID_STRING_CLOSEMEMMGMT);
+            #else
+                guiDisplayInformationOnScreenAndWait(ID_STRING_CLOSEMEMMGMT);
+                guiGetBackToCurrentScreen();
+            #endif
         }
         else if (currentScreen == SCREEN_DEFAULT_INSERTED_LCK)
         {
@@ -436,8 +449,12 @@ void guiScreenLoop(uint8_t input_interface_result)
         else if (currentScreen == SCREEN_MEMORY_MGMT)
         {
             // Currently in memory management mode, tell the user to finish it via the plugin/app
-            guiDisplayInformationOnScreenAndWait(ID_STRING_CLOSEMEMMGMT);
-            guiGetBackToCurrentScreen();
+            #ifdef GUI_FEATURE_TOAST_SCREENS
+                guiDisplayInformationOnScreenToast(ID_STRING_CLOSEMEMMGMT);
+            #else
+                guiDisplayInformationOnScreenAndWait(ID_STRING_CLOSEMEMMGMT);
+                guiGetBackToCurrentScreen();
+            #endif
         }
         else if (currentScreen == SCREEN_DEFAULT_INSERTED_LCK)
         {
@@ -699,6 +716,54 @@ void guiDisplayInformationOnScreenAndWait(uint8_t stringID)
     userViewDelay();
 }
 
+#ifdef GUI_FEATURE_TOAST_SCREENS
+/*! \fn     guiStartToast(uint8_t action)
+*   \brief  Keep the displayed screen for a few seconds without blocking the main loop
+*   \param  action  What to do once the delay is over (TOAST_ACTION_XXX)
+*/
+void guiStartToast(uint8_t action)
+{
+    toastAction = action;
+    activateTimer(TIMER_TOAST, TOAST_SCREEN_DEL);
+}
+
+/*! \fn     guiDisplayInformationOnScreenToast(uint8_t stringID)
+*   \brief  Display text information on screen, get back to the current screen a few seconds later
+*   \param  stringID    String ID to display
+*   \note   Non blocking version of guiDisplayInformationOnScreenAndWait(), guiMainLoop() handles the timeout
+*/
+void guiDisplayInformationOnScreenToast(uint8_t stringID)
+{
+    guiDisplayTextInformationOnScreen(readStoredStringToBuffer(stringID));
+    guiStartToast(TOAST_ACTION_BACK_TO_SCREEN);
+}
+
+/*! \fn     guiIsToastDisplayed(void)
+*   \brief  Know if a toast is currently displayed
+*   \return TRUE or FALSE
+*/
+uint8_t guiIsToastDisplayed(void)
+{
+    return (toastAction != TOAST_ACTION_NONE) ? TRUE : FALSE;
+}
+
+/*! \fn     guiGetExpiredToastAction(void)
+*   \brief  Check if the displayed toast timed out
+*   \return The toast action if it did (toast is then over), TOAST_ACTION_NONE otherwise
+*/
+uint8_t guiGetExpiredToastAction(void)
+{
+    uint8_t action = toastAction;
+    
+    if ((action == TOAST_ACTION_NONE) || (hasTimerExpired(TIMER_TOAST, TRUE) != TIMER_EXPIRED))
+    {
+        return TOAST_ACTION_NONE;
+    }
+    toastAction = TOAST_ACTION_NONE;
+    return action;
+}
+#endif
+
 /*! \fn     guiDisplayRawString(uint8_t stringID)
 *   \brief  Display raw text at current position on string
 *   \param  stringID    String ID to display
@@ -32,6 +32,7 @@
 #include "usb_cmd_parser.h"
 #include "timer_manager.h"
 #include "logic_eeprom.h"
+#include "scratch_arena.h"
 #include "hid_defines.h"
 #include "mini_inputs.h"
 #include "aes256_ctr.h"
@@ -60,6 +61,10 @@ volatile uint8_t login_just_added_flag = FALSE;
 volatile uint8_t data_context_valid_flag = FALSE;
 // Currently adding data flag
 volatile uint8_t current_adding_data_flag = FALSE;
+#ifdef NODE_FEATURE_COMPRESSED_DATA
+// Encoding of the data the host is about to write in the current data context
+uint8_t data_context_new_encoding = DATA_ENCODING_RAW;
+#endif
 // Counter for our current data node written bytes
 uint8_t currently_adding_data_cntr = 0;
 // Counter for our current offset when reading data
@@ -78,10 +83,10 @@ uint16_t context_parent_node_addr;
 confirmationText_t conf_text;
 // AES256 context variable
 aes256CtrCtx_t aesctx;
-// Parent node var
-pNode temp_pnode;
-// Child node var
-cNode temp_cnode;
+// Parent node var, in the scratch arena
+#define temp_pnode  (scratchArena.context.pnode)
+// Child node var, in the scratch arena
+#define temp_cnode  (scratchArena.context.cnode)
 // Data node ptr;
 dNode* temp_dnode_ptr = (dNode*)&temp_cnode;
 
@@ -171,21 +176,71 @@ uint16_t searchForServiceName(uint8_t* name, uint8_t mode, uint8_t type)
 {
     uint16_t next_node_addr;
     int8_t compare_result;
+    #ifdef NODE_FEATURE_SERVICE_COMPARE_KEY
+    uint16_t current_node_addr;
+    uint16_t name_hash;
+    #endif
     
-    // If it is of credential type, use the LUT to accelerate things
+    // Use the LUTs to accelerate things
     if (type == SERVICE_CRED_TYPE)
     {
         next_node_addr = getParentNodeForLetter(name[0]);
     }
     else
     {
-        next_node_addr = getStartingDataParentAddress();
+        next_node_addr = getDataParentNodeForLetter(name[0]);
     }
     
     if (next_node_addr == NODE_ADDR_NULL)
     {
         return NODE_ADDR_NULL;
     }
+    #ifdef NODE_FEATURE_SERVICE_COMPARE_KEY
+    else if (type == SERVICE_CRED_TYPE)
+    {
+        // Credential parents: compare keys are used to avoid reading the whole nodes
+        name_hash = serviceNameHash(name);
+        do
+        {
+            current_node_addr = next_node_addr;
+            compare_result = compareServiceWithParentNode(name, name_hash, current_node_addr, &next_node_addr, mode);
+            
+            if ((mode == COMPARE_MODE_MATCH) && (compare_result == 0))
+            {
+                #ifdef NODE_FEATURE_SERVICE_ALIAS
+                // Aliases give the service holding their credentials
+                current_node_addr = resolveServiceAlias(current_node_addr);
+                #endif
+                // Result found, load it like the full search does
+                readParentNode(&temp_pnode, current_node_addr);
+                return current_node_addr;
+            }
+            else if (compare_result < 0)
+            {
+                // Nodes are alphabetically sorted: no match or first node after the name
+                if (mode == COMPARE_MODE_MATCH)
+                {
+                    return NODE_ADDR_NULL;
+                }
+                else
+                {
+                    return current_node_addr;
+                }
+            }
+        }
+        while (next_node_addr != NODE_ADDR_NULL);
+        
+        if(mode == COMPARE_MODE_COMPARE)
+        {
+            // We didn't find the service, return first node
+            return getStartingParentAddress();
+        }
+        else
+        {
+            return NODE_ADDR_NULL;
+        }
+    }
+    #endif
     else
     {
         // Start going through the nodes
@@ -201,6 +256,14 @@ uint16_t searchForServiceName(uint8_t* name, uint8_t mode, uint8_t type)
                 
                 if (compare_result == 0)
                 {
+                    #ifdef NODE_FEATURE_SERVICE_ALIAS
+                    // Aliases give the service holding their credentials
+                    if (type == SERVICE_CRED_TYPE)
+                    {
+                        next_node_addr = resolveServiceAlias(next_node_addr);
+                        readParentNode(&temp_pnode, next_node_addr);
+                    }
+                    #endif
                     // Result found
                     return next_node_addr;
                 } 
@@ -426,6 +489,9 @@ RET_TYPE setCurrentContext(uint8_t* name, uint8_t type)
     current_adding_data_flag = FALSE;
     activateTimer(TIMER_CREDENTIALS, 0);
     currently_writing_first_block = FALSE;
+    #ifdef NODE_FEATURE_COMPRESSED_DATA
+    data_context_new_encoding = DATA_ENCODING_RAW;
+    #endif
     
     // Do we know this context ?
     if ((context_parent_node_addr != NODE_ADDR_NULL) && (smartcard_inserted_unlocked == TRUE))
@@ -438,6 +504,7 @@ RET_TYPE setCurrentContext(uint8_t* name, uint8_t type)
         {
             data_context_valid_flag = TRUE;
             // Load the parent node in memory
+            scratchContextAcquire();
             readParentNode(&temp_pnode, context_parent_node_addr);
         }
         return RETURN_OK;
@@ -448,16 +515,18 @@ RET_TYPE setCurrentContext(uint8_t* name, uint8_t type)
     }
 }
 
-/*! \fn     addNewContext(uint8_t* name, uint8_t length)
-*   \brief  Add a new context
-*   \param  name    Name of the desired service / website
-*   \param  length  Length of the string
-*   \param  type    Type of context (data or credential)
-*   \return If we added the context
+/*! \fn     addNewService(uint8_t* name, uint8_t length, uint8_t type, uint16_t canonical_addr)
+*   \brief  Add a new service after user approval
+*   \param  name            Name of the desired service / website
+*   \param  length          Length of the string
+*   \param  type            Type of context (data or credential)
+*   \param  canonical_addr  Credential service the new one is an alias of, NODE_ADDR_NULL for a regular service
+*   \return If we added the service
 */
-RET_TYPE addNewContext(uint8_t* name, uint8_t length, uint8_t type)
+static RET_TYPE addNewService(uint8_t* name, uint8_t length, uint8_t type, uint16_t canonical_addr)
 {
     RET_TYPE ret_val = RETURN_NOK;
+    uint8_t nb_lines = 2;
     
     // Check if the context doesn't already exist
     if ((smartcard_inserted_unlocked == FALSE) || (searchForServiceName(name, COMPARE_MODE_MATCH, type) != NODE_ADDR_NULL))
@@ -466,24 +535,45 @@ RET_TYPE addNewContext(uint8_t* name, uint8_t length, uint8_t type)
     }
     
     // Prepare domain approval screen
-    if (type == SERVICE_CRED_TYPE)
+    #ifdef NODE_FEATURE_SERVICE_ALIAS
+    if (canonical_addr != NODE_ADDR_NULL)
     {
-        conf_text.lines[0] = readStoredStringToBuffer(ID_STRING_CONF_NEWCREDS);
+        // The user must know which credentials the new service will give, the text is stored in the firmware as bundles don't have it
+        readParentNode(&temp_pnode, canonical_addr);
+        conf_text.lines[0] = (char*)name;
+        conf_text.lines[1] = readProgmemStringToBuffer(PSTR("New Alias Of:"));
+        conf_text.lines[2] = (char*)temp_pnode.service;
+        nb_lines = 3;
     }
     else
+    #endif
     {
-        conf_text.lines[0] = readStoredStringToBuffer(ID_STRING_CONF_NEWDATA);
+        if (type == SERVICE_CRED_TYPE)
+        {
+            conf_text.lines[0] = readStoredStringToBuffer(ID_STRING_CONF_NEWCREDS);
+        }
+        else
+        {
+            conf_text.lines[0] = readStoredStringToBuffer(ID_STRING_CONF_NEWDATA);
+        }
+        conf_text.lines[1] = (char*)name;
     }
-    conf_text.lines[1] = (char*)name;
     
     // Ask for user approval, flash screen
-    if(guiAskForConfirmation(0xF0 | 2, &conf_text) == RETURN_OK)
+    if(guiAskForConfirmation(0xF0 | nb_lines, &conf_text) == RETURN_OK)
     {
         // Display processing screen
         guiDisplayProcessingScreen();
         
-        // Copy service name inside the parent node
+        // Copy service name inside the parent node, the service field tail is left clear
+        memset((void*)temp_pnode.service, 0x00, sizeof(temp_pnode.service));
         memcpy((void*)temp_pnode.service, (void*)name, length);
+        #ifdef NODE_FEATURE_SERVICE_ALIAS
+        if (canonical_addr != NODE_ADDR_NULL)
+        {
+            setParentNodeAlias(&temp_pnode, canonical_addr);
+        }
+        #endif
         
         // Create parent node for service
         if (createParentNode(&temp_pnode, type) == RETURN_OK)
@@ -504,6 +594,117 @@ RET_TYPE addNewContext(uint8_t* name, uint8_t length, uint8_t type)
     return ret_val;
 }
 
+/*! \fn     addNewContext(uint8_t* name, uint8_t length)
+*   \brief  Add a new context
+*   \param  name    Name of the desired service / website
+*   \param  length  Length of the string
+*   \param  type    Type of context (data or credential)
+*   \return If we added the context
+*/
+RET_TYPE addNewContext(uint8_t* name, uint8_t length, uint8_t type)
+{
+    return addNewService(name, length, type, NODE_ADDR_NULL);
+}
+
+#ifdef NODE_FEATURE_SERVICE_ALIAS
+/*! \fn     addNewServiceAlias(uint8_t* name, uint8_t length, uint8_t* canonical_name)
+*   \brief  Add a credential service sharing the credentials of an existing one
+*   \param  name            Name of the alias service / website
+*   \param  length          Length of the string
+*   \param  canonical_name  Name of the service holding the credentials
+*   \return If we added the alias
+*/
+RET_TYPE addNewServiceAlias(uint8_t* name, uint8_t length, uint8_t* canonical_name)
+{
+    uint16_t canonical_addr;
+    
+    if (smartcard_inserted_unlocked == FALSE)
+    {
+        return RETURN_NOK;
+    }
+    
+    // The search resolves aliases: an alias of an alias points at the canonical service
+    canonical_addr = searchForServiceName(canonical_name, COMPARE_MODE_MATCH, SERVICE_CRED_TYPE);
+    if (canonical_addr == NODE_ADDR_NULL)
+    {
+        return RETURN_NOK;
+    }
+    
+    return addNewService(name, length, SERVICE_CRED_TYPE, canonical_addr);
+}
+#endif
+
+/*! \fn     askUserForLoginForContext(uint8_t* login)
+*   \brief  Ask the user to approve a given login or to pick one for the current context
+*   \param  login   Login requested by the plugin, 0 to let the user pick one
+*   \note   Sets selected_login_flag & arms the credential timer on approval
+*   \return RETURN_NOK if the context has no credentials
+*/
+static RET_TYPE askUserForLoginForContext(uint8_t* login)
+{
+    // Read context parent node
+    readParentNode(&temp_pnode, context_parent_node_addr);
+    
+    // Check it actually has a child!
+    if (temp_pnode.nextChildAddress == NODE_ADDR_NULL)
+    {
+        return RETURN_NOK;
+    }
+    
+    // See if a username has already been specified
+    if (login != 0)
+    {
+        // Check that the specified login actually exists...
+        selected_login_child_node_addr = searchForLoginInGivenParent(context_parent_node_addr, login);
+        
+        // Requested login exists, ask for acknowledgment from user...
+        if (selected_login_child_node_addr != NODE_ADDR_NULL)
+        {
+            // Prepare confirmation screen
+            #if defined(HARDWARE_OLIVIER_V1)
+            conf_text.lines[0] = readStoredStringToBuffer(ID_STRING_SEND_PASS_FOR);
+            conf_text.lines[1] = (char*)login;
+            conf_text.lines[2] = readStoredStringToBuffer(ID_STRING_ON);
+            conf_text.lines[3] = (char*)temp_pnode.service;
+            #elif defined(MINI_VERSION)
+            conf_text.lines[0] = (char*)temp_pnode.service;
+            conf_text.lines[1] = readStoredStringToBuffer(ID_STRING_SEND_PASS_FOR);
+            conf_text.lines[2] = (char*)login;
+            #endif
+            
+            // If doesn't exist, ask user for confirmation to add to flash
+            #if defined(HARDWARE_OLIVIER_V1)
+            if (guiAskForConfirmation(4, &conf_text) == RETURN_OK)
+            #elif defined(MINI_VERSION)
+            if (guiAskForConfirmation(3, &conf_text) == RETURN_OK)
+            #endif
+            {
+                selected_login_flag = TRUE;
+                guiGetBackToCurrentScreen();
+                activateTimer(TIMER_CREDENTIALS, CREDENTIAL_TIMER_VALIDITY);
+            }
+            else
+            {
+                guiGetBackToCurrentScreen();
+            }
+        }
+    } 
+    else
+    {
+        // Ask the user to a pick a child
+        selected_login_child_node_addr = guiAskForLoginSelect(&temp_pnode, &temp_cnode, context_parent_node_addr, FALSE);
+        guiGetBackToCurrentScreen();
+        
+        // If a valid child node was selected
+        if (selected_login_child_node_addr != NODE_ADDR_NULL)
+        {
+            selected_login_flag = TRUE;
+            activateTimer(TIMER_CREDENTIALS, CREDENTIAL_TIMER_VALIDITY);
+        }
+    }
+    return RETURN_OK;
+}
+
 /*! \fn     getLoginForContext(uint8_t* buffer)
 *   \brief  Get login for current context
 *   \param  buffer  Buffer to store the login
@@ -526,15 +727,6 @@ RET_TYPE getLoginForContext(char* buffer)
         // Credential timer off, ask for user to choose: implemented to avoid trapping the user with 2 successive prompts for a get login
         if (hasTimerExpired(TIMER_CREDENTIALS, FALSE) == TIMER_EXPIRED)
         {
-            // Read context parent node
-            readParentNode(&temp_pnode, context_parent_node_addr);
-            
-            // Check it actually has a child!
-            if (temp_pnode.nextChildAddress == NODE_ADDR_NULL)
-            {
-                return RETURN_NOK;
-            }
-            
             // See if a username has already been specified
             if (buffer[HID_LEN_FIELD] != 0)
             {
@@ -543,57 +735,15 @@ RET_TYPE getLoginForContext(char* buffer)
                 {
                     return RETURN_NOK;
                 }
-                else
+                else if (askUserForLoginForContext((uint8_t*)(buffer + HID_DATA_START)) == RETURN_NOK)
                 {
-                    // Payload length correct, check that the specified login actually exists...
-                    selected_login_child_node_addr = searchForLoginInGivenParent(context_parent_node_addr, (uint8_t*)(buffer + HID_DATA_START));
-                    
-                    // Requested login exists, ask for acknowledgment from user...
-                    if (selected_login_child_node_addr != NODE_ADDR_NULL)
-                    {
-                        // Prepare confirmation screen
-                        #if defined(HARDWARE_OLIVIER_V1)
-                        conf_text.lines[0] = readStoredStringToBuffer(ID_STRING_SEND_PASS_FOR);
-                        conf_text.lines[1] = (char*)(buffer + HID_DATA_START);
-                        conf_text.lines[2] = readStoredStringToBuffer(ID_STRING_ON);
-                        conf_text.lines[3] = (char*)temp_pnode.service;
-                        #elif defined(MINI_VERSION)
-                        conf_text.lines[0] = (char*)temp_pnode.service;
-                        conf_text.lines[1] = readStoredStringToBuffer(ID_STRING_SEND_PASS_FOR);
-                        conf_text.lines[2] = (char*)(buffer + HID_DATA_START);
-                        #endif
-                        
-                        // If doesn't exist, ask user for confirmation to add to flash
-                        #if defined(HARDWARE_OLIVIER_V1)
-                        if (guiAskForConfirmation(4, &conf_text) == RETURN_OK)
-                        #elif defined(MINI_VERSION)
-                        if (guiAskForConfirmation(3, &conf_text) == RETURN_OK)
-                        #endif
-                        {
-                            selected_login_flag = TRUE;
-                            guiGetBackToCurrentScreen();
-                            activateTimer(TIMER_CREDENTIALS, CREDENTIAL_TIMER_VALIDITY);
-                        }
-                        else
-                        {
-                            guiGetBackToCurrentScreen();
-                        }
-                    }
+                    return RETURN_NOK;
                 }
             } 
-            else
+            else if (askUserForLoginForContext(0) == RETURN_NOK)
             {
-                // Ask the user to a pick a child
-                selected_login_child_node_addr = guiAskForLoginSelect(&temp_pnode, &temp_cnode, context_parent_node_addr, FALSE);
-                guiGetBackToCurrentScreen();
-                
-                // If a valid child node was selected
-                if (selected_login_child_node_addr != NODE_ADDR_NULL)
-                {
-                    selected_login_flag = TRUE;
-                    activateTimer(TIMER_CREDENTIALS, CREDENTIAL_TIMER_VALIDITY);
-                }
-            }            
+                return RETURN_NOK;
+            }
         }
         
         // If the user just approved!
@@ -612,6 +762,53 @@ RET_TYPE getLoginForContext(char* buffer)
     }
 }
 
+#ifdef USB_FEATURE_SINGLE_FETCH_CREDENTIAL
+/*! \fn     getCredentialForContext(uint8_t* login, char* buffer)
+*   \brief  Get login & password for current context, after a single user approval
+*   \param  login   Login requested by the plugin, 0 to let the user pick one
+*   \param  buffer  Buffer to store the null terminated login followed by the null terminated password
+*   \note   buffer must be NODE_CHILD_SIZE_OF_LOGIN + NODE_CHILD_SIZE_OF_PASSWORD bytes long
+*   \return If the credential was approved
+*/
+RET_TYPE getCredentialForContext(uint8_t* login, char* buffer)
+{
+    uint8_t login_length;
+    
+    if (context_valid_flag == FALSE)
+    {
+        return RETURN_NOK;
+    }
+    
+    // Clear current flags, an approval given to a previous request isn't reused
+    selected_login_flag = FALSE;
+    login_just_added_flag = FALSE;
+    
+    if ((askUserForLoginForContext(login) == RETURN_OK) && (selected_login_flag == TRUE))
+    {
+        // Read the selected child node once, login & password are guaranteed to be null terminated
+        readChildNode(&temp_cnode, selected_login_child_node_addr);
+        strcpy(buffer, (char*)temp_cnode.login);
+        login_length = strlen(buffer) + 1;
+        
+        // Call the password decryption function, which also clears the credential_timer_valid flag
+        decrypt32bBlockOfDataAndClearCTVFlag(temp_cnode.password, temp_cnode.ctr);
+        temp_cnode.password[NODE_CHILD_SIZE_OF_PASSWORD-1] = 0;
+        strcpy(buffer + login_length, (char*)temp_cnode.password);
+        memset((void*)temp_cnode.password, 0x00, NODE_CHILD_SIZE_OF_PASSWORD);
+        
+        #ifdef NODE_FEATURE_PARENT_SUMMARY
+        // Remember this login as the most recently used one for this service
+        setParentNodeMruChild(context_parent_node_addr, selected_login_child_node_addr);
+        #endif
+        return RETURN_OK;
+    }
+    else
+    {
+        return RETURN_NOK;
+    }
+}
+#endif
+
 /*! \fn     getPasswordForContext(void)
 *   \brief  Get password for current context
 *   \return If password was entered
@@ -629,6 +826,11 @@ RET_TYPE getPasswordForContext(char* buffer)
         strcpy((char*)buffer, (char*)temp_cnode.password);
         memset((void*)temp_cnode.password, 0x00, NODE_CHILD_SIZE_OF_PASSWORD);
         
+        #ifdef NODE_FEATURE_PARENT_SUMMARY
+        // Remember this login as the most recently used one for this service
+        setParentNodeMruChild(context_parent_node_addr, selected_login_child_node_addr);
+        #endif
+        
         // Timer fired, return
         return RETURN_OK;
     }
@@ -917,6 +1119,17 @@ RET_TYPE addDataForDataContext(uint8_t* data, uint8_t last_packet_flag)
     }
     else
     {
+        // Another scratch arena owner overwrote our parent node and possibly the data node being filled
+        if (scratchContextAcquire() != RETURN_OK)
+        {
+            if (current_adding_data_flag != FALSE)
+            {
+                current_adding_data_flag = FALSE;
+                return RETURN_NOK;
+            }
+            readParentNode(&temp_pnode, context_parent_node_addr);
+        }
+        
         // Check if we haven't already setup a child data node, parent node is already in our memory when flag is set
         if (current_adding_data_flag == FALSE)
         {
@@ -939,6 +1152,18 @@ RET_TYPE addDataForDataContext(uint8_t* data, uint8_t last_packet_flag)
                 // delete all of them before adding the first new block of data
                 // calling deleteDataNodeChain is safe even if the address is NULL
                 deleteDataNodeChain(temp_pnode.nextChildAddress, temp_dnode_ptr);
+                
+                #ifdef NODE_FEATURE_COMPRESSED_DATA
+                // The encoding set by the host is stored in the data parent, written with the first data node
+                if (data_context_new_encoding == DATA_ENCODING_COMPRESSED)
+                {
+                    temp_pnode.flags |= NODE_F_DATA_PARENT_COMPRESSED_MASK;
+                }
+                else
+                {
+                    temp_pnode.flags &= ~NODE_F_DATA_PARENT_COMPRESSED_MASK;
+                }
+                #endif
 
                 memset((void*)temp_dnode_ptr, 0, NODE_SIZE);
                 currently_writing_first_block = TRUE;
@@ -998,6 +1223,53 @@ RET_TYPE addDataForDataContext(uint8_t* data, uint8_t last_packet_flag)
 }
 
 
+#ifdef NODE_FEATURE_COMPRESSED_DATA
+/*! \fn     setDataContextEncoding(uint8_t encoding)
+*   \brief  Set the encoding of the data the host is about to write in the current data context
+*   \param  encoding    DATA_ENCODING_RAW or DATA_ENCODING_COMPRESSED
+*   \return Operation success or not
+*   \note   Only taken into account when the first block is written, the data context defaults to DATA_ENCODING_RAW when set
+*/
+RET_TYPE setDataContextEncoding(uint8_t encoding)
+{
+    if ((data_context_valid_flag == FALSE) || (current_adding_data_flag != FALSE) || ((encoding != DATA_ENCODING_RAW) && (encoding != DATA_ENCODING_COMPRESSED)))
+    {
+        return RETURN_NOK;
+    }
+    data_context_new_encoding = encoding;
+    return RETURN_OK;
+}
+
+/*! \fn     getDataContextEncoding(uint8_t* encoding)
+*   \brief  Get the encoding of the data stored in the current data context
+*   \param  encoding    Where to store DATA_ENCODING_COMPRESSED if the host compressed the data before storing it, DATA_ENCODING_RAW otherwise
+*   \return Operation success or not
+*/
+RET_TYPE getDataContextEncoding(uint8_t* encoding)
+{
+    if ((data_context_valid_flag == FALSE) || (current_adding_data_flag != FALSE))
+    {
+        return RETURN_NOK;
+    }
+    
+    // Another scratch arena owner may have overwritten our parent node
+    if (scratchContextAcquire() != RETURN_OK)
+    {
+        readParentNode(&temp_pnode, context_parent_node_addr);
+    }
+    
+    if ((temp_pnode.flags & NODE_F_DATA_PARENT_COMPRESSED_MASK) != 0)
+    {
+        *encoding = DATA_ENCODING_COMPRESSED;
+    }
+    else
+    {
+        *encoding = DATA_ENCODING_RAW;
+    }
+    return RETURN_OK;
+}
+#endif
+
 /*! \fn     get32BytesDataForCurrentService(uint8_t* buffer, uint8_t* bytes_written)
 *   \brief  Get a 32bytes block of data
 *   \param  buffer          Buffer where to store the data
@@ -1011,7 +1283,14 @@ RET_TYPE get32BytesDataForCurrentService(uint8_t* buffer)
             return RETURN_NOK;
         } 
         else
-        {            
+        {
+            // Another scratch arena owner overwrote the data node being read
+            if ((scratchContextAcquire() != RETURN_OK) && (currently_reading_data_cntr != 0))
+            {
+                activateTimer(TIMER_CREDENTIALS, 0);
+                return RETURN_NOK;
+            }
+            
             // Credential timer off, ask for user to approve
             if (hasTimerExpired(TIMER_CREDENTIALS, FALSE) == TIMER_EXPIRED)
             {
@@ -1125,13 +1404,60 @@ RET_TYPE checkPasswordForContext(uint8_t* password)
     }
 }
 
+#ifdef KEYBOARD_FEATURE_SERVICE_TYPING_DELAY
+/*! \fn     setTypingDelayForContext(uint8_t delay_profile)
+*   \brief  Set the keyboard typing delay profile for the current service
+*   \param  delay_profile   Delay profile (delay = profile * TYPING_DELAY_PROFILE_STEP_MS), 0 for the device wide setting
+*   \return If we managed to set the profile
+*/
+RET_TYPE setTypingDelayForContext(uint8_t delay_profile)
+{
+    if (context_valid_flag == FALSE)
+    {
+        return RETURN_NOK;
+    }
+    
+    if (updateParentNodeTypingDelay(&temp_pnode, context_parent_node_addr, delay_profile) != RETURN_OK)
+    {
+        return RETURN_NOK;
+    }
+    
+    // Inform that the db has changed
+    userDBChangedActions(FALSE);
+    
+    return RETURN_OK;
+}
+
+/*! \fn     setKeyboardTypingDelayForService(uint16_t parent_flags)
+*   \brief  Apply the keyboard typing delay profile stored in a parent node
+*   \param  parent_flags    Flags of the parent node
+*/
+static void setKeyboardTypingDelayForService(uint16_t parent_flags)
+{
+    uint8_t delay_profile = (parent_flags & NODE_F_PARENT_TYPING_DELAY_MASK) >> NODE_F_PARENT_TYPING_DELAY_SHMT;
+    
+    if (delay_profile == 0)
+    {
+        usbKeyboardSetTypingDelay(KEYBOARD_DELAY_DEVICE_SETTING);
+    }
+    else
+    {
+        usbKeyboardSetTypingDelay(delay_profile * TYPING_DELAY_PROFILE_STEP_MS);
+    }
+}
+#endif
+
 /*! \fn     askUserForLoginAndPasswordKeybOutput(uint16_t child_address, char* service_name)
 *   \brief  Ask the user to enter the login password of a given child
 *   \param  child_address   Address of the child
 *   \param  service_name    Service name
 *   \param  RETURN_OK or RETURN_BACK
 */
+#ifdef KEYBOARD_FEATURE_SERVICE_TYPING_DELAY
+static RET_TYPE askUserForLoginAndPasswordKeybOutputNoDelaySet(uint16_t child_address, char* service_name)
+#else
 RET_TYPE askUserForLoginAndPasswordKeybOutput(uint16_t child_address, char* service_name)
+#endif
 {    
     confirmationText_t temp_conf_text;
     
@@ -1298,6 +1624,26 @@ RET_TYPE askUserForLoginAndPasswordKeybOutput(uint16_t child_address, char* serv
     return RETURN_OK;
 }
 
+#ifdef KEYBOARD_FEATURE_SERVICE_TYPING_DELAY
+/*! \fn     askUserForLoginAndPasswordKeybOutput(uint16_t child_address, char* service_name)
+*   \brief  Ask the user to enter the login password of a given child, typed with the service typing delay
+*   \param  child_address   Address of the child
+*   \param  service_name    Service name
+*   \param  RETURN_OK or RETURN_BACK
+*   \note   temp_pnode must contain the parent node of the child
+*/
+RET_TYPE askUserForLoginAndPasswordKeybOutput(uint16_t child_address, char* service_name)
+{
+    RET_TYPE ret_val;
+    
+    // Type the credential with its service typing delay, then get back to the device wide setting
+    setKeyboardTypingDelayForService(temp_pnode.flags);
+    ret_val = askUserForLoginAndPasswordKeybOutputNoDelaySet(child_address, service_name);
+    usbKeyboardSetTypingDelay(KEYBOARD_DELAY_DEVICE_SETTING);
+    return ret_val;
+}
+#endif
+
 /*! \fn     favoritePickingLogic(void)
 *   \brief  Logic for picking a favorite's credentials
 */
@@ -1632,6 +1978,10 @@ void sendOrDisplayString(char * str, uint8_t is_password)
 {
     if (isUsbConfigured())
     {
+        #ifdef KEYBOARD_FEATURE_SERVICE_TYPING_DELAY
+        // temp_pnode contains the service being managed
+        setKeyboardTypingDelayForService(temp_pnode.flags);
+        #endif
         usbKeybPutStr(str);
 
         if(is_password)
@@ -1648,6 +1998,9 @@ void sendOrDisplayString(char * str, uint8_t is_password)
                 usbKeyboardPress(getMooltipassParameterInEeprom(KEY_AFTER_LOGIN_SEND_PARAM), 0);
             }
         }
+        #ifdef KEYBOARD_FEATURE_SERVICE_TYPING_DELAY
+        usbKeyboardSetTypingDelay(KEYBOARD_DELAY_DEVICE_SETTING);
+        #endif
     }
     else
     {
@@ -35,6 +35,11 @@
 #define CTR_FLASH_MIN_INCR              64
 #define AES_ROUTINE_ENC_SIZE            32
 
+
+// CMD_SET_DATA_ENCODING / CMD_GET_DATA_ENCODING values
+#define DATA_ENCODING_RAW               0x00
+#define DATA_ENCODING_COMPRESSED        0x02
+
 #if AES_ROUTINE_ENC_SIZE != NODE_CHILD_SIZE_OF_PASSWORD
     #error "Wrong password size"
 #endif
@@ -47,7 +52,10 @@ void computeAndDisplayBlockSizeEncryptionResult(uint8_t* aes_key, uint8_t* data,
 uint16_t searchForLoginInGivenParent(uint16_t parent_addr, uint8_t* name);
 uint16_t searchForServiceName(uint8_t* name, uint8_t mode, uint8_t type);
 RET_TYPE addDataForDataContext(uint8_t* data, uint8_t last_packet_flag);
+RET_TYPE setDataContextEncoding(uint8_t encoding);
+RET_TYPE getDataContextEncoding(uint8_t* encoding);
 RET_TYPE addNewContext(uint8_t* name, uint8_t length, uint8_t type);
+RET_TYPE addNewServiceAlias(uint8_t* name, uint8_t length, uint8_t* canonical_name);
 void encryptOneAesBlockWithKeyEcb(uint8_t* aes_key, uint8_t* data);
 RET_TYPE setPasswordForContext(uint8_t* password, uint8_t length);
 void initEncryptionHandling(uint8_t* aes_key, uint8_t* nonce);
@@ -61,12 +69,19 @@ RET_TYPE getPasswordForContext(char* buffer);
 uint8_t getSmartCardInsertedUnlocked(void);
 void initUserFlashContext(uint8_t user_id);
 RET_TYPE getLoginForContext(char* buffer);
+RET_TYPE getCredentialForContext(uint8_t* login, char* buffer);
 void clearSmartCardInsertedUnlocked(void);
 void setSmartCardInsertedUnlocked(void);
 void eraseFlashUsersContents(void);
 void ctrPreEncryptionTasks(void);
 void favoritePickingLogic(void);
 void loginSelectLogic(void);
+#ifdef KEYBOARD_FEATURE_SERVICE_TYPING_DELAY
+RET_TYPE setTypingDelayForContext(uint8_t delay_profile);
+
+// Keyboard typing delay for a given service profile
+#define TYPING_DELAY_PROFILE_STEP_MS    5
+#endif
 
 #ifdef ENABLE_CREDENTIAL_MANAGEMENT
 /* charset bitfield significance */
@@ -44,7 +44,7 @@ static const uint8_t eeprom_param_init[] __attribute__((__progmem__)) =
     FALSE,                  // LOCK_TIMEOUT_ENABLE_PARAM            Disable timeout by default
     60,                     // LOCK_TIMEOUT_PARAM                   Set a 1 hour timeout
     6,                      // TOUCH_DI_PARAM                       Set default detection integrator (6 consecutive samples)
-    0,                      // TOUCH_WHEEL_OS_PARAM_OLD             Not used anymore
+    0,                      // TOUCH_WHEEL_OS_PARAM_OLD             Not used anymore, now MEDIA_IMPORT_CHECKPOINT_PARAM: no media import to resume
     0x73,                   // TOUCH_PROX_OS_PARAM                  Set proximity sensing key settings
     FALSE,                  // OFFLINE_MODE_PARAM                   Disable offline mode by default
     FALSE,                  // SCREENSAVER_PARAM                    Disable screen saver by default
@@ -78,6 +78,8 @@ enum lock_feature_t                         {LF_EN_MASK = 0x01, LF_ENT_KEY_MASK
 #define HASH_DISPLAY_FEATURE_PARAM          31
 #define RANDOM_INIT_PIN_PARAM               32
 // we are full.
+// Legacy slot reused to store the number of bundle pages programmed by an interrupted media import, tagged with MEDIA_RESUME_EEP_MARKER
+#define MEDIA_IMPORT_CHECKPOINT_PARAM       TOUCH_WHEEL_OS_PARAM_OLD
 #define FIRST_USER_PARAM                    KEYBOARD_LAYOUT_PARAM
 
 /** Prototypes **/
@@ -21,6 +21,7 @@
  *  \brief  Logic for storing/getting fw data in the dedicated flash storage
  *  Copyright [2014] [Mathieu Stephan]
  */
+#include <avr/pgmspace.h>
 #include <stdint.h>
 #include "logic_fwflash_storage.h"
 #include "logic_eeprom.h"
@@ -89,6 +90,32 @@ char* readStoredStringToBuffer(uint8_t stringID)
     return (char*)ret_val;
 }
 
+/*!	\fn     readProgmemStringToBuffer(const char* string)
+*	\brief	Copy a string stored in the firmware in a buffer and return the pointer to this buffer (same buffers as readStoredStringToBuffer)
+*   \param  string      Program memory string
+*   \return Pointer to the buffer
+*   \note   For security prompts that mustn't depend on the media bundle contents
+*/
+char* readProgmemStringToBuffer(const char* string)
+{
+    uint8_t* ret_val = curTextBufferPtr;
+    
+    strncpy_P((char*)ret_val, string, TEXTBUFFERSIZE);
+    ret_val[TEXTBUFFERSIZE-1] = 0;
+    
+    // Switch buffers
+    if (curTextBufferPtr == textBuffer2)
+    {
+        curTextBufferPtr = textBuffer1;
+    }
+    else
+    {
+        curTextBufferPtr = textBuffer2;
+    }
+    
+    return (char*)ret_val;
+}
+
 /*!	\fn     getKeybLutEntryForLayout(uint8_t layout, uint8_t ascii_char)
 *	\brief	Get a keyboard LUT entry for a given layout
 *   \note   No checking is performed on boundaries, must be done in calling function
@@ -377,6 +377,7 @@
 uint8_t getKeybLutEntryForLayout(uint8_t layout, uint8_t ascii_char);
 RET_TYPE getStoredFileAddr(uint16_t fileId, uint16_t* addr);
 char* readStoredStringToBuffer(uint8_t stringID);
+char* readProgmemStringToBuffer(const char* string);
 
 // Global variables
 extern uint8_t textBuffer1[TEXTBUFFERSIZE];
@@ -103,6 +103,34 @@ void miniAccelerometerSendReceiveSPIData(uint8_t* data, uint8_t nbBytes)
 }
 #endif
 
+#ifdef HARDWARE_MINI_CLICK_V2
+/*! \fn     miniAccelerometerPowerDown(void)
+ *  \brief  Put the accelerometer in power-down mode (output data rate set to 0)
+ */
+void miniAccelerometerPowerDown(void)
+{
+    uint8_t powerDownCommand[] = {0x20, 0x00};
+
+    if (acc_detected == TRUE)
+    {
+        miniAccelerometerSendReceiveSPIData(powerDownCommand, sizeof(powerDownCommand));
+    }
+}
+
+/*! \fn     miniAccelerometerPowerUp(void)
+ *  \brief  Restore the 400Hz output data rate set by initMiniInputs()
+ */
+void miniAccelerometerPowerUp(void)
+{
+    uint8_t setDataRateCommand[] = {0x20, 0x5F};
+
+    if (acc_detected == TRUE)
+    {
+        miniAccelerometerSendReceiveSPIData(setDataRateCommand, sizeof(setDataRateCommand));
+    }
+}
+#endif
+
 /*! \fn     initMiniInputs(void)
 *   \brief  Init Mooltipass mini inputs
 *   \return Init success status
@@ -86,6 +86,8 @@ RET_TYPE initMiniInputs(void);
 
 #ifdef HARDWARE_MINI_CLICK_V2
 void miniAccelerometerSendReceiveSPIData(uint8_t* data, uint8_t nbBytes);
+void miniAccelerometerPowerDown(void);
+void miniAccelerometerPowerUp(void);
 #endif
 
 /* GLOBAL VARS */
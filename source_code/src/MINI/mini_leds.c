@@ -168,4 +168,24 @@ void miniSetLedStates(uint8_t leds)
         }
     }
 }
+
+/*! \fn     miniGetLedStates(void)
+ *  \brief  Read back the current LED states from the port registers
+ *  \return 4 bits bitmask for the led states
+ */
+uint8_t miniGetLedStates(void)
+{
+    uint8_t portid_leds[] = {1 << PORTID_LED_1, 1 << PORTID_LED_2, 1 << PORTID_LED_3, 1 << PORTID_LED_4};
+    volatile uint8_t* port_leds[] = {&PORT_LED_1, &PORT_LED_2, &PORT_LED_3, &PORT_LED_4};
+    uint8_t leds = 0;
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        if (*(port_leds[i]) & portid_leds[i])
+        {
+            leds |= (1 << i);
+        }
+    }
+    return leds;
+}
 #endif
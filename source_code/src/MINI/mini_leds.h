@@ -29,6 +29,7 @@
 
 void miniLedsSetAnimation(uint8_t animation);
 void miniSetLedStates(uint8_t leds);
+uint8_t miniGetLedStates(void);
 void miniLedsAnimationTick(void);
 void miniInitLeds(void);
 
@@ -32,11 +32,41 @@
 #include "node_mgmt.h"
 #include "defines.h"
 #include "usb.h"
+#include "utils.h"
 
 // Current node management handle
 mgmtHandle currentNodeMgmtHandle;
 // Current date
 uint16_t currentDate;
+#ifdef NODE_FEATURE_NODE_CACHE
+// Node cache entry
+typedef struct
+{
+    uint16_t address;   // NODE_ADDR_NULL when the entry is free
+    uint8_t age;        // Number of cache accesses since last use
+    gNode node;
+} nodeCacheEntry;
+// Nodes recently read by the current user
+static nodeCacheEntry nodeCache[NODE_CACHE_NB_ENTRIES];
+#endif
+#ifdef NODE_FEATURE_LOGIN_USAGE_ORDER
+// Parent node whose login usage order is stored, NODE_ADDR_NULL if none
+static uint16_t loginOrderParent = NODE_ADDR_NULL;
+// Number of addresses in the login usage order, 0 if the service has too many children
+static uint8_t loginOrderCount;
+// Child node addresses, most recently used first
+static uint16_t loginOrder[LOGIN_ORDER_MAX_CHILDREN];
+#endif
+#ifdef NODE_FEATURE_PARENT_SUMMARY
+// Parent whose most recently used child isn't written to flash yet, NODE_ADDR_NULL if none
+static uint16_t mruPendingParent = NODE_ADDR_NULL;
+// Most recently used child of mruPendingParent
+static uint16_t mruPendingChild;
+#endif
+#ifdef NODE_FEATURE_PARENTS_REFRESH
+// Set when nodes written in memory management mode or by an older firmware may have left the parent node summaries stale
+static uint8_t parentNodesSummariesStale = FALSE;
+#endif
 
 
 /*! \fn     nodeMgmtCriticalErrorCallback(void)
@@ -110,7 +140,7 @@ static inline void validBitToFlags(uint16_t *flags, uint8_t vb)
  * Gets the credential type from flags  
  * @param   flags           The flags field of a node
  * @return  cred type       as uint8_t
- * @note    No error checking is performed
+ * @note    No error checking is performed. Only meaningful for credential nodes: data parents use bit 0 as NODE_F_DATA_PARENT_COMPRESSED_MASK
  */
 static inline uint8_t credentialTypeFromFlags(uint16_t flags)
 {
@@ -122,7 +152,7 @@ static inline uint8_t credentialTypeFromFlags(uint16_t flags)
  * @param   flags           The flags field of a node
  * @param   credType        The credential type to set in flags (0 up to NODE_MAX_CRED_TYPE)
  * @return  Does not return
- * @note    No error checking is performed
+ * @note    No error checking is performed. Not to be used on data parents, see credentialTypeFromFlags()
  */
 static inline void credentialTypeToFlags(uint16_t *flags, uint8_t credType)
 {
@@ -198,6 +228,25 @@ RET_TYPE extractDate(uint16_t date, uint8_t *year, uint8_t *month, uint8_t *day)
     return RETURN_OK;
 }
 
+/*! \fn     checkUserPermissionFromFlags(uint16_t node_addr, uint16_t flags)
+*   \brief  Check that the user has the right to read/write a node, given its flags
+*   \param  node_addr   Node address
+*   \param  flags       Node flags, as read from flash
+*   \return OK / NOK
+*/
+static RET_TYPE checkUserPermissionFromFlags(uint16_t node_addr, uint16_t flags)
+{
+    // Either the node belongs to us or it is invalid, check that the address is after sector 1 (upper check done at the flashread/write level)
+    if(((getCurrentUserID() == userIdFromFlags(flags)) || (validBitFromFlags(flags) == NODE_VBIT_INVALID)) && (pageNumberFromAddress(node_addr) >= PAGE_PER_SECTOR))
+    {
+        return RETURN_OK;
+    }
+    else
+    {
+        return RETURN_NOK;
+    }
+}
+
 /*! \fn     checkUserPermission(uint16_t node_addr)
 *   \brief  Check that the user has the right to read/write a node
 *   \param  node_addr   Node address
@@ -207,24 +256,88 @@ RET_TYPE checkUserPermission(uint16_t node_addr)
 {
     // Future node flags
     uint16_t temp_flags;
-    // Node Page
-    uint16_t page_addr = pageNumberFromAddress(node_addr);
-    // Node byte address
-    uint16_t byte_addr = NODE_SIZE * (uint16_t)nodeNumberFromAddress(node_addr);
     
     // Fetch the flags
-    readDataFromFlash(page_addr, byte_addr, 2, (void*)&temp_flags);
-                    
-    // Either the node belongs to us or it is invalid, check that the address is after sector 1 (upper check done at the flashread/write level)
-    if(((getCurrentUserID() == userIdFromFlags(temp_flags)) || (validBitFromFlags(temp_flags) == NODE_VBIT_INVALID)) && (page_addr >= PAGE_PER_SECTOR))
+    readDataFromFlash(pageNumberFromAddress(node_addr), NODE_SIZE * (uint16_t)nodeNumberFromAddress(node_addr), 2, (void*)&temp_flags);
+    
+    return checkUserPermissionFromFlags(node_addr, temp_flags);
+}
+
+#ifdef NODE_FEATURE_CHANGE_TRACKING
+/*! \fn     nodeCacheInvalidate(uint16_t address)
+*   \brief  Remove a node from the node cache and forget the login usage order
+*   \param  address Node address, NODE_ADDR_NULL to empty the cache
+*/
+static void nodeCacheInvalidate(uint16_t address)
+{
+    #ifdef NODE_FEATURE_LOGIN_USAGE_ORDER
+        // Any node change may reorder or remove logins
+        loginOrderParent = NODE_ADDR_NULL;
+    #endif
+    
+    #ifdef NODE_FEATURE_NODE_CACHE
+        for (uint8_t i = 0; i < NODE_CACHE_NB_ENTRIES; i++)
+        {
+            if ((address == NODE_ADDR_NULL) || (nodeCache[i].address == address))
+            {
+                nodeCache[i].address = NODE_ADDR_NULL;
+            }
+        }
+    #else
+        (void)address;
+    #endif
+}
+
+/*! \fn     nodeCacheCheckFlashPages(void)
+*   \brief  Empty the node cache if flash pages were erased or programmed from the flash buffer, as they may contain cached nodes
+*/
+static void nodeCacheCheckFlashPages(void)
+{
+    if (haveFlashPagesBeenModified() != FALSE)
     {
-        return RETURN_OK;
+        nodeCacheInvalidate(NODE_ADDR_NULL);
     }
-    else
+}
+#endif
+
+#ifdef NODE_FEATURE_NODE_CACHE
+/*! \fn     nodeCacheGetEntry(uint16_t address)
+*   \brief  Get the cache entry to use for a node read, emptying the cache if flash pages were modified
+*   \param  address Node address
+*   \return The entry holding the node, or the least recently used entry if the node isn't cached
+*/
+static nodeCacheEntry* nodeCacheGetEntry(uint16_t address)
+{
+    nodeCacheEntry* entry = &nodeCache[0];
+    
+    nodeCacheCheckFlashPages();
+    
+    for (uint8_t i = 0; i < NODE_CACHE_NB_ENTRIES; i++)
     {
-        return RETURN_NOK;
+        if (nodeCache[i].address == address)
+        {
+            entry = &nodeCache[i];
+            break;
+        }
+        else if ((nodeCache[i].address == NODE_ADDR_NULL) || (nodeCache[i].age > entry->age))
+        {
+            entry = &nodeCache[i];
+        }
     }
+    
+    // Age the other entries
+    for (uint8_t i = 0; i < NODE_CACHE_NB_ENTRIES; i++)
+    {
+        if (nodeCache[i].age != 0xFF)
+        {
+            nodeCache[i].age++;
+        }
+    }
+    entry->age = 0;
+    
+    return entry;
 }
+#endif
 
 /*! \fn     writeNodeDataBlockToFlash(uint16_t address, void* data)
 *   \brief  Write a node data block to flash
@@ -233,6 +346,9 @@ RET_TYPE checkUserPermission(uint16_t node_addr)
 */
 void writeNodeDataBlockToFlash(uint16_t address, void* data)
 {
+    #ifdef NODE_FEATURE_CHANGE_TRACKING
+        nodeCacheInvalidate(address);
+    #endif
     writeDataToFlash(pageNumberFromAddress(address), NODE_SIZE * nodeNumberFromAddress(address), NODE_SIZE, data);
 }
 
@@ -256,6 +372,9 @@ void eraseNodeDataBlockToFlash(uint16_t address)
     
     // Set data to 0xFF
     memset(data, 0xFF, NODE_SIZE);
+    #ifdef NODE_FEATURE_CHANGE_TRACKING
+        nodeCacheInvalidate(address);
+    #endif
     writeDataToFlash(pageNumberFromAddress(address), NODE_SIZE * nodeNumberFromAddress(address), NODE_SIZE, data);
 }
 
@@ -340,6 +459,9 @@ void initNodeManagementHandle(uint8_t userIdNum)
     currentNodeMgmtHandle.currentUserId = userIdNum;
     currentNodeMgmtHandle.datadbChanged = FALSE;
     currentNodeMgmtHandle.dbChanged = FALSE;
+    #ifdef NODE_FEATURE_CHANGE_TRACKING
+        nodeCacheInvalidate(NODE_ADDR_NULL);
+    #endif
     
     // scan for next free parent and child nodes from the start of the memory
     if (findFreeNodes(1, &currentNodeMgmtHandle.nextFreeNode, 0, 0) == 0)
@@ -347,6 +469,17 @@ void initNodeManagementHandle(uint8_t userIdNum)
         currentNodeMgmtHandle.nextFreeNode = NODE_ADDR_NULL;
     }
     
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    mruPendingParent = NODE_ADDR_NULL;
+    #endif
+    
+    #ifdef NODE_FEATURE_PARENTS_REFRESH
+    // fix the parent summaries & compare keys if memory management mode was interrupted after nodes were written, or on the first login with this firmware
+    readDataFromFlash(currentNodeMgmtHandle.pageUserProfile, currentNodeMgmtHandle.offsetUserProfile + USER_PROFILE_SIZE - 1, 1, &parentNodesSummariesStale);
+    parentNodesSummariesStale = (parentNodesSummariesStale != USER_NODES_FORMAT_KEY);
+    refreshParentNodesSummaries();
+    #endif
+    
     // populate services LUT
     populateServicesLut();
 }
@@ -548,6 +681,17 @@ void readProfileUserDbChangeNumber(void *buf)
  */
 void readNode(gNode* g, uint16_t nodeAddress)
 {
+    #ifdef NODE_FEATURE_NODE_CACHE
+        nodeCacheEntry* cache_entry = nodeCacheGetEntry(nodeAddress);
+        
+        // Only nodes which passed the permission check for the current user are cached
+        if ((nodeAddress != NODE_ADDR_NULL) && (cache_entry->address == nodeAddress))
+        {
+            memcpy((void*)g, (void*)&cache_entry->node, NODE_SIZE);
+            return;
+        }
+    #endif
+    
     readNodeDataBlockFromFlash(nodeAddress, g);
     
     if (checkUserPermission(nodeAddress) != RETURN_OK)
@@ -555,7 +699,22 @@ void readNode(gNode* g, uint16_t nodeAddress)
         // if handle user id != id from node or node is invalid
         // clear local node.. return not ok
         nodeMgmtPermissionValidityErrorCallback();
-    }    
+    }
+    
+    #ifdef NODE_FEATURE_NODE_CACHE
+        memcpy((void*)&cache_entry->node, (void*)g, NODE_SIZE);
+        cache_entry->address = nodeAddress;
+    #endif
+}
+
+/**
+ * Reads the flags and linked list fields of a node, without permission checks
+ * @param   nodeAddress     The address of the node
+ * @param   fields          Storage for flags, prev address, next address & first child address (parent nodes)
+ */
+static void readNodeLinkFields(uint16_t nodeAddress, uint16_t* fields)
+{
+    readDataFromFlash(pageNumberFromAddress(nodeAddress), NODE_SIZE * nodeNumberFromAddress(nodeAddress), 4*sizeof(uint16_t), fields);
 }
 
 /**
@@ -578,8 +737,8 @@ void readChildNode(cNode *c, uint16_t childNodeAddress)
 {
     readNode((gNode*)c, childNodeAddress);
     
-    // If we have a date, update last used field
-    if (currentDate != 0x0000)
+    // If we have a date, update last used field (writes are skipped when it already holds today's date)
+    if ((currentDate != 0x0000) && (c->dateLastUsed != currentDate))
     {
         // Just update the good field and write at the same place, write is destructive!
         c->dateLastUsed = currentDate;
@@ -592,192 +751,974 @@ void readChildNode(cNode *c, uint16_t childNodeAddress)
 }
 
 /**
- * Writes a parent node to memory (next free via handle) (in alphabetical order).
- * @param   p               The parent node to write to memory (nextFreeParentNode)
- * @param   type            Type of context (data or credential)
- * @return  success status
- * @note    Handles necessary doubly linked list management
+ * Reads a child node from memory without marking it as used, for screens only listing credentials
+ * @param   c               Storage for the node from memory
+ * @param   childNodeAddress The address to read in memory
  */
-RET_TYPE createParentNode(pNode* p, uint8_t type)
+void readChildNodeNoDateUpdate(cNode *c, uint16_t childNodeAddress)
 {
-    uint16_t temp_address, first_parent_addr;
-    RET_TYPE temprettype;
-    
-    // Set the first parent address depending on the type
-    if (type == SERVICE_CRED_TYPE)
-    {
-        first_parent_addr = currentNodeMgmtHandle.firstParentNode;
-    } 
-    else
-    {
-        first_parent_addr = currentNodeMgmtHandle.firstDataParentNode;
-    }
-    
-    // This is particular to parent nodes...
-    p->nextChildAddress = NODE_ADDR_NULL;
+    readNode((gNode*)c, childNodeAddress);
+    c->description[sizeof(c->description)-1] = 0;
+    c->login[sizeof(c->login)-1] = 0;
+}
+
+#ifdef NODE_FEATURE_PARENT_SUMMARY
+/**
+ * Computes the check byte of a parent node summary
+ * @param   summary         Pointer to the summary inside the service field
+ * @return  the check byte
+ */
+static uint8_t parentNodeSummaryCheck(uint8_t* summary)
+{
+    return summary[0] ^ summary[1] ^ summary[2] ^ PNODE_SUMMARY_CHECK_KEY;
+}
+
+/**
+ * Checks if a parent node has a valid summary (databases created before its introduction don't)
+ * @param   p               The parent node
+ * @return  RETURN_OK if the summary can be trusted
+ * @note    The check byte only catches summaries damaged since the last refresh: nothing is trusted until the host written nodes are refreshed
+ */
+static RET_TYPE isParentNodeSummaryValid(pNode* p)
+{
+    uint8_t* summary = &(p->service[PNODE_SUMMARY_SERVICE_OFFSET]);
     
-    if (type == SERVICE_CRED_TYPE)
+    if ((parentNodesSummariesStale == FALSE) && (summary[3] == parentNodeSummaryCheck(summary)))
     {
-        nodeTypeToFlags(&(p->flags), NODE_TYPE_PARENT);
+        return RETURN_OK;
     }
     else
     {
-        nodeTypeToFlags(&(p->flags), NODE_TYPE_PARENT_DATA);
+        return RETURN_NOK;
     }
+}
+
+/**
+ * Gets the most recently used child address stored in a parent node summary
+ * @param   p               The parent node
+ * @return  the stored address, only meaningful if the summary is valid
+ */
+static uint16_t parentNodeSummaryMru(pNode* p)
+{
+    return (uint16_t)p->service[PNODE_SUMMARY_SERVICE_OFFSET+1] | ((uint16_t)p->service[PNODE_SUMMARY_SERVICE_OFFSET+2] << 8);
+}
+
+/**
+ * Sets the summary of a parent node (not written to flash)
+ * @param   p               The parent node
+ * @param   childCount      Number of children
+ * @param   mruChild        Address of the most recently used child
+ */
+static void setParentNodeSummary(pNode* p, uint8_t childCount, uint16_t mruChild)
+{
+    uint8_t* summary = &(p->service[PNODE_SUMMARY_SERVICE_OFFSET]);
     
-    // Call createGenericNode to add a node
-    temprettype = createGenericNode((gNode*)p, first_parent_addr, &temp_address, PNODE_COMPARISON_FIELD_OFFSET, NODE_PARENT_SIZE_OF_SERVICE);
+    summary[0] = childCount;
+    summary[1] = (uint8_t)mruChild;
+    summary[2] = (uint8_t)(mruChild >> 8);
+    summary[3] = parentNodeSummaryCheck(summary);
+}
+
+/**
+ * Counts the children of a parent node by walking its child list
+ * @param   p               The parent node
+ * @param   mruChild        Address of a child to look for, cleared if not part of the list
+ * @return  the number of children
+ */
+static uint8_t countParentNodeChildren(pNode* p, uint16_t* mruChild)
+{
+    uint16_t next_address = p->nextChildAddress;
+    uint16_t fields[4];
+    uint8_t mru_found = FALSE;
+    uint8_t count = 0;
     
-    // If the return is ok & we changed the first node address
-    if ((temprettype == RETURN_OK) && (first_parent_addr != temp_address))
+    while ((next_address != NODE_ADDR_NULL) && (count != 0xFF))
     {
-        if (type == SERVICE_CRED_TYPE)
-        {
-            setStartingParent(temp_address);
-        }
-        else
+        if (next_address == *mruChild)
         {
-            setDataStartingParent(temp_address);
+            mru_found = TRUE;
         }
+        readNodeLinkFields(next_address, fields);
+        next_address = fields[2];
+        count++;
     }
     
-    // Populate services LUT
-    populateServicesLut();
-    
-    return temprettype;
+    if (mru_found == FALSE)
+    {
+        *mruChild = NODE_ADDR_NULL;
+    }
+    return count;
 }
 
 /**
- * Writes a child node to memory (next free via handle) (in alphabetical order).
- * @param   pAddr           The parent node address of the child
- * @param   c               The child node to write to memory (nextFreeChildNode)
- * @return  success status
- * @note    Handles necessary doubly linked list management
+ * Gets the number of children of a credential parent node
+ * @param   p               The parent node
+ * @return  the number of children
+ * @note    Falls back to walking the child list when the parent doesn't have a valid summary
  */
-RET_TYPE createChildNode(uint16_t pAddr, cNode *c)
+uint8_t getParentNodeChildCount(pNode* p)
 {
-    pNode* tempPNodePointer = (pNode*)&(currentNodeMgmtHandle.tempgNode);
-    uint16_t childFirstAddress, temp_address;
-    RET_TYPE temprettype;
-    
-    // Set node type to child
-    nodeTypeToFlags(&(c->flags), NODE_TYPE_CHILD);
-    
-    // Write date created & used fields
-    c->dateCreated = currentDate;
-    c->dateLastUsed = currentDate;
+    uint16_t dummy_address = NODE_ADDR_NULL;
     
-    // Read parent to get the first child address
-    readNode((gNode*)tempPNodePointer, pAddr);
-    childFirstAddress = tempPNodePointer->nextChildAddress;
-    
-    // Call createGenericNode to add a node
-    temprettype = createGenericNode((gNode*)c, childFirstAddress, &temp_address, CNODE_COMPARISON_FIELD_OFFSET, NODE_CHILD_SIZE_OF_LOGIN);
-    
-    // If the return is ok & we changed the first child address
-    if ((temprettype == RETURN_OK) && (childFirstAddress != temp_address))
+    if (isParentNodeSummaryValid(p) == RETURN_OK)
     {
-       readNode((gNode*)tempPNodePointer, pAddr);
-       tempPNodePointer->nextChildAddress = temp_address;
-       writeNodeDataBlockToFlash(pAddr, tempPNodePointer);
+        return p->service[PNODE_SUMMARY_SERVICE_OFFSET];
     }
-    
-    return temprettype;
-}   
+    else
+    {
+        return countParentNodeChildren(p, &dummy_address);
+    }
+}
 
 /**
- * Writes a new data node to memory (next free via handle) (in alphabetical order).
- * @param   context_parent_node_addr    Address to the parent node
- * @param   parent_node_ptr             Parent node pointer
- * @param   data_node_ptr               Data node pointer
- * @param   first_data_block_flag       Flag to see if it is the first data block
- * @param   last_packet_flag            Flag to know if it is the last block
- * @return  success status
+ * Gets the most recently used child of a credential parent node
+ * @param   p               The parent node
+ * @param   pAddr           The address of the parent node
+ * @return  the most recently used child address, or the first child if unknown
  */
-RET_TYPE writeNewDataNode(uint16_t context_parent_node_addr, pNode* parent_node_ptr, dNode* data_node_ptr, uint8_t first_data_block_flag, uint8_t last_packet_flag)
+uint16_t getParentNodeMruChild(pNode* p, uint16_t pAddr)
 {
-    gNode* memNodePtr = &(currentNodeMgmtHandle.tempgNode);
-    // Our next 2 free addresses
-    uint16_t next_free_addresses[2];
+    uint16_t mru_address = NODE_ADDR_NULL;
     
-    // This is what scan node usage uses internally, check space in flash
-    if (findFreeNodes(2, next_free_addresses, 0, 0) != 2)
+    if (pAddr == mruPendingParent)
     {
-        return RETURN_NOK;
-    }    
-    
-    // If it is the first data node we need to update the parent
-    if (first_data_block_flag == TRUE)
+        mru_address = mruPendingChild;
+    }
+    else if (isParentNodeSummaryValid(p) == RETURN_OK)
     {
-        // Read supposed parent node
-        readNode(memNodePtr, context_parent_node_addr);
-        
-        // Check the parent nodes fields are the same, update parent node at the right address
-        if (memcmp((void*)memNodePtr, (void*)parent_node_ptr, FLAGS_PREV_NEXT_ADDR_LENGTH) == 0)
-        {
-            parent_node_ptr->nextChildAddress = next_free_addresses[0];
-            writeNodeDataBlockToFlash(context_parent_node_addr, parent_node_ptr);
-        }
-        else
-        {
-            return RETURN_NOK;
-        }
+        mru_address = parentNodeSummaryMru(p);
     }
     
-    // Set correct user id to the node
-    userIdToFlags(&(data_node_ptr->flags), currentNodeMgmtHandle.currentUserId);
-    
-    // set valid bit
-    validBitToFlags(&(data_node_ptr->flags), NODE_VBIT_VALID);
-    
-    // Set correct node type
-    nodeTypeToFlags(&(data_node_ptr->flags), NODE_TYPE_DATA);
-    
-    // If it is not the last packet, set next address
-    if (last_packet_flag == FALSE)
+    if (mru_address == NODE_ADDR_NULL)
     {
-        // Because we can't interrupt data transfer, the next address will automatically be the next one we have in memory
-        data_node_ptr->nextDataAddress = next_free_addresses[1];
+        return p->nextChildAddress;
+    }
+    else
+    {
+        return mru_address;
     }
-    
-    // write parent node to flash (destructive)
-    writeNodeDataBlockToFlash(next_free_addresses[0], data_node_ptr);
-    
-    // Update free node address
-    currentNodeMgmtHandle.nextFreeNode = next_free_addresses[1];
-    
-    return RETURN_OK;
 }
 
 /**
- * Writes a generic node to memory (next free via handle) (in alphabetical order).
- * @param   g                       The node to write to memory (nextFreeParentNode)
- * @param   firstNodeAddress        Address of the first node of its kind
- * @param   newFirstNodeAddress     If the firstNodeAddress changed, this var will store the new value
- * @param   comparisonFieldOffset   The offset used to do the comparison used for the sorting
- * @param   comparisonFieldLength   The length of the field used for comparison
- * @return  success status
- * @note    Handles necessary doubly linked list management
+ * Writes the pending most recently used child to its parent node
+ * @note    The parent node is only rewritten if its summary changes
  */
-RET_TYPE createGenericNode(gNode* g, uint16_t firstNodeAddress, uint16_t* newFirstNodeAddress, uint8_t comparisonFieldOffset, uint8_t comparisonFieldLength)
+static void flushParentNodeMruChild(void)
 {
-    gNode* memNodePtr = &(currentNodeMgmtHandle.tempgNode);
-    uint16_t addr = NODE_ADDR_NULL;
-    int8_t res = 0;
-    
-    // Set newFirstNodeAddress to firstNodeAddress by default
-    *newFirstNodeAddress = firstNodeAddress;
+    pNode* ip = (pNode*)&(currentNodeMgmtHandle.tempgNode);
+    uint16_t pAddr = mruPendingParent;
     
-    // Check space in flash
-    if (currentNodeMgmtHandle.nextFreeNode == NODE_ADDR_NULL)
+    if (pAddr == NODE_ADDR_NULL)
     {
-        return RETURN_NOK;
+        return;
     }
     
-    // Set correct user id to the node
-    userIdToFlags(&(g->flags), currentNodeMgmtHandle.currentUserId);
-    
-    // set valid bit
+    mruPendingParent = NODE_ADDR_NULL;
+    readParentNode(ip, pAddr);
+    if ((isParentNodeSummaryValid(ip) == RETURN_OK) && (parentNodeSummaryMru(ip) == mruPendingChild))
+    {
+        return;
+    }
+    setParentNodeSummary(ip, getParentNodeChildCount(ip), mruPendingChild);
+    writeNodeDataBlockToFlash(pAddr, ip);
+}
+
+/**
+ * Marks a child as the most recently used one in its parent node
+ * @param   pAddr           The address of the parent node
+ * @param   cAddr           The address of the child node
+ * @note    Kept in RAM until another service is used, so repeated fetches from a service don't rewrite its parent
+ */
+void setParentNodeMruChild(uint16_t pAddr, uint16_t cAddr)
+{
+    if (pAddr != mruPendingParent)
+    {
+        flushParentNodeMruChild();
+    }
+    mruPendingParent = pAddr;
+    mruPendingChild = cAddr;
+    #ifdef NODE_FEATURE_LOGIN_USAGE_ORDER
+        // The most recently used child comes first
+        loginOrderParent = NODE_ADDR_NULL;
+    #endif
+}
+
+#endif
+
+#ifdef NODE_FEATURE_LOGIN_USAGE_ORDER
+/**
+ * Gets the children of a credential parent node ordered by last use, most recent first
+ * @param   p               The parent node
+ * @param   pAddr           The address of the parent node
+ * @param   order           Set to the ordered child addresses
+ * @return  the number of children, 0 if there are more than LOGIN_ORDER_MAX_CHILDREN (alphabetical order should then be used)
+ * @note    Computed in one pass reading the child headers, kept until the next node write. Children last used the same day keep their alphabetical order, the most recently used child stored in the parent comes first
+ */
+uint8_t getParentNodeLoginOrder(pNode* p, uint16_t pAddr, uint16_t** order)
+{
+    // Child node fields up to the last used date
+    uint8_t child_header[offsetof(cNode, dateLastUsed) + sizeof(uint16_t)];
+    cNode* child_header_ptr = (cNode*)child_header;
+    uint16_t dates[LOGIN_ORDER_MAX_CHILDREN];
+    uint16_t child_addr = p->nextChildAddress;
+    uint16_t mru_addr = NODE_ADDR_NULL;
+    uint16_t date;
+    uint8_t i, j;
+    
+    *order = loginOrder;
+    nodeCacheCheckFlashPages();
+    if (loginOrderParent == pAddr)
+    {
+        return loginOrderCount;
+    }
+    
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+        mru_addr = getParentNodeMruChild(p, pAddr);
+    #endif
+    
+    loginOrderCount = 0;
+    while (child_addr != NODE_ADDR_NULL)
+    {
+        if (loginOrderCount == LOGIN_ORDER_MAX_CHILDREN)
+        {
+            loginOrderCount = 0;
+            break;
+        }
+        
+        readDataFromFlash(pageNumberFromAddress(child_addr), NODE_SIZE * nodeNumberFromAddress(child_addr), sizeof(child_header), (void*)child_header);
+        if (checkUserPermissionFromFlags(child_addr, child_header_ptr->flags) != RETURN_OK)
+        {
+            nodeMgmtPermissionValidityErrorCallback();
+        }
+        
+        // The most recently used child goes first
+        date = (child_addr == mru_addr) ? 0xFFFF : child_header_ptr->dateLastUsed;
+        
+        // Insert after the children with the same date, keeping alphabetical order between them
+        for (i = 0; (i < loginOrderCount) && (dates[i] >= date); i++);
+        for (j = loginOrderCount; j > i; j--)
+        {
+            dates[j] = dates[j-1];
+            loginOrder[j] = loginOrder[j-1];
+        }
+        dates[i] = date;
+        loginOrder[i] = child_addr;
+        loginOrderCount++;
+        
+        child_addr = child_header_ptr->nextChildAddress;
+    }
+    
+    loginOrderParent = pAddr;
+    return loginOrderCount;
+}
+#endif
+
+#ifdef NODE_FEATURE_SERVICE_COMPARE_KEY
+/**
+ * Computes the hash of a service name, stored in the parent node compare key
+ * @param   name            The null terminated service name
+ * @return  the hash
+ */
+uint16_t serviceNameHash(uint8_t* name)
+{
+    uint16_t hash = 5381;
+    uint8_t i;
+    
+    for (i = 0; (i < NODE_PARENT_SIZE_OF_SERVICE) && (name[i] != 0); i++)
+    {
+        hash = ((hash << 5) + hash) ^ name[i];
+    }
+    return hash;
+}
+
+/**
+ * Computes the compare key of a parent node
+ * @param   p               The parent node
+ * @param   key             Storage for the PNODE_COMPARE_KEY_LENGTH bytes long key
+ * @note    Services are lower cased when received, the prefix therefore is the case folded service name
+ */
+static void computeParentNodeCompareKey(pNode* p, uint8_t* key)
+{
+    uint16_t hash = serviceNameHash(p->service);
+    uint8_t check = PNODE_COMPARE_KEY_CHECK_KEY;
+    uint8_t i;
+    
+    // Service name prefix, zero padded after the end of the name (same result as strncmp)
+    memset((void*)key, 0x00, PNODE_COMPARE_KEY_PREFIX_LENGTH);
+    for (i = 0; (i < PNODE_COMPARE_KEY_PREFIX_LENGTH) && (p->service[i] != 0); i++)
+    {
+        key[i] = p->service[i];
+    }
+    key[PNODE_COMPARE_KEY_PREFIX_LENGTH] = (uint8_t)hash;
+    key[PNODE_COMPARE_KEY_PREFIX_LENGTH+1] = (uint8_t)(hash >> 8);
+    
+    // Check byte
+    for (i = 0; i < PNODE_COMPARE_KEY_LENGTH-1; i++)
+    {
+        check ^= key[i];
+    }
+    key[PNODE_COMPARE_KEY_LENGTH-1] = check;
+}
+
+/**
+ * Checks the check byte of a compare key
+ * @param   key             The compare key
+ * @return  RETURN_OK if the key can be used
+ * @note    Keys written by hosts or by older firmwares pass the check byte once in 256 times: none is used until the parent nodes are refreshed
+ */
+static RET_TYPE isParentNodeCompareKeyValid(uint8_t* key)
+{
+    uint8_t check = PNODE_COMPARE_KEY_CHECK_KEY;
+    uint8_t i;
+    
+    if (parentNodesSummariesStale != FALSE)
+    {
+        return RETURN_NOK;
+    }
+    
+    for (i = 0; i < PNODE_COMPARE_KEY_LENGTH-1; i++)
+    {
+        check ^= key[i];
+    }
+    
+    if (check == key[PNODE_COMPARE_KEY_LENGTH-1])
+    {
+        return RETURN_OK;
+    }
+    else
+    {
+        return RETURN_NOK;
+    }
+}
+
+/**
+ * Compares a service name with the service of a credential parent node, as strncmp would
+ * @param   name                The service name to look for
+ * @param   nameHash            serviceNameHash() of that name
+ * @param   parentNodeAddress   The parent node address
+ * @param   nextParentAddress   Storage for the next parent node address
+ * @param   mode                Mode of compare (see service_compare_mode_t)
+ * @return  -1, 0 or 1 like strncmp, SERVICE_COMPARE_UNORDERED when different in COMPARE_MODE_MATCH without knowing the order
+ * @note    Only the linked list fields & the compare key are read, the full node only when the key isn't enough
+ */
+int8_t compareServiceWithParentNode(uint8_t* name, uint16_t nameHash, uint16_t parentNodeAddress, uint16_t* nextParentAddress, uint8_t mode)
+{
+    pNode* ip = (pNode*)&(currentNodeMgmtHandle.tempgNode);
+    uint8_t key[PNODE_COMPARE_KEY_LENGTH];
+    uint16_t fields[4];
+    int8_t compare_result;
+    uint8_t i;
+    
+    // Linked list fields & permission check
+    readNodeLinkFields(parentNodeAddress, fields);
+    *nextParentAddress = fields[2];
+    if ((userIdFromFlags(fields[0]) == currentNodeMgmtHandle.currentUserId) && (validBitFromFlags(fields[0]) == NODE_VBIT_VALID) && (pageNumberFromAddress(parentNodeAddress) >= PAGE_PER_SECTOR))
+    {
+        // Compare key read
+        readDataFromFlash(pageNumberFromAddress(parentNodeAddress), NODE_SIZE * nodeNumberFromAddress(parentNodeAddress) + PNODE_COMPARISON_FIELD_OFFSET + PNODE_COMPARE_KEY_SERVICE_OFFSET, PNODE_COMPARE_KEY_LENGTH, key);
+        
+        if (isParentNodeCompareKeyValid(key) == RETURN_OK)
+        {
+            for (i = 0; i < PNODE_COMPARE_KEY_PREFIX_LENGTH; i++)
+            {
+                if (name[i] != key[i])
+                {
+                    return (name[i] < key[i]) ? -1 : 1;
+                }
+                else if (name[i] == 0)
+                {
+                    return 0;
+                }
+            }
+            
+            // Same prefix, different hashes: names differ
+            if ((mode == COMPARE_MODE_MATCH) && (nameHash != ((uint16_t)key[PNODE_COMPARE_KEY_PREFIX_LENGTH] | ((uint16_t)key[PNODE_COMPARE_KEY_PREFIX_LENGTH+1] << 8))))
+            {
+                return SERVICE_COMPARE_UNORDERED;
+            }
+        }
+    }
+    
+    // Full compare (readParentNode also performs the permission checks)
+    readParentNode(ip, parentNodeAddress);
+    compare_result = strncmp((char*)name, (char*)ip->service, NODE_CHILD_SIZE_OF_LOGIN);
+    if (compare_result < 0)
+    {
+        return -1;
+    }
+    else if (compare_result > 0)
+    {
+        return 1;
+    }
+    else
+    {
+        return 0;
+    }
+}
+#endif
+
+#ifdef NODE_FEATURE_SERVICE_ALIAS
+/**
+ * Computes the check byte of a parent node alias record
+ * @param   alias           Pointer to the alias record inside the service field
+ * @return  the check byte
+ */
+static uint8_t parentNodeAliasCheck(uint8_t* alias)
+{
+    uint8_t check = PNODE_ALIAS_CHECK_KEY;
+    uint8_t i;
+    
+    for (i = 0; i < PNODE_ALIAS_LENGTH-1; i++)
+    {
+        check ^= alias[i];
+    }
+    return check;
+}
+
+/**
+ * Computes the hash of the service name of a parent node stored in flash
+ * @param   pAddr           The parent node address
+ * @return  the hash
+ * @note    The service is read in small chunks, so the node buffers aren't used
+ */
+static uint16_t parentNodeServiceHash(uint16_t pAddr)
+{
+    uint8_t chunk[8];
+    uint16_t hash = 5381;
+    uint8_t i, j;
+    
+    for (i = 0; i < NODE_PARENT_SIZE_OF_SERVICE; i += sizeof(chunk))
+    {
+        readDataFromFlash(pageNumberFromAddress(pAddr), NODE_SIZE * nodeNumberFromAddress(pAddr) + PNODE_COMPARISON_FIELD_OFFSET + i, sizeof(chunk), chunk);
+        for (j = 0; (j < sizeof(chunk)) && (i + j < NODE_PARENT_SIZE_OF_SERVICE); j++)
+        {
+            if (chunk[j] == 0)
+            {
+                return hash;
+            }
+            hash = ((hash << 5) + hash) ^ chunk[j];
+        }
+    }
+    return hash;
+}
+
+/**
+ * Makes a credential parent node an alias of another service (not written to flash)
+ * @param   p               The parent node
+ * @param   canonicalAddr   Address of the parent node holding the credentials
+ * @note    Aliases have no children: tools unaware of them see an empty service
+ */
+void setParentNodeAlias(pNode* p, uint16_t canonicalAddr)
+{
+    uint8_t* alias = &(p->service[PNODE_ALIAS_SERVICE_OFFSET]);
+    uint16_t hash = parentNodeServiceHash(canonicalAddr);
+    
+    alias[0] = (uint8_t)canonicalAddr;
+    alias[1] = (uint8_t)(canonicalAddr >> 8);
+    alias[2] = (uint8_t)hash;
+    alias[3] = (uint8_t)(hash >> 8);
+    alias[4] = parentNodeAliasCheck(alias);
+}
+
+/**
+ * Tells if a parent node is a service alias, whether its canonical service still exists or not
+ * @param   p               The parent node
+ * @return  RETURN_OK if p is a childless credential parent with a valid alias record
+ */
+static RET_TYPE isParentNodeAlias(pNode* p)
+{
+    uint8_t* alias = &(p->service[PNODE_ALIAS_SERVICE_OFFSET]);
+    
+    if ((nodeTypeFromFlags(p->flags) != NODE_TYPE_PARENT) || (p->nextChildAddress != NODE_ADDR_NULL) || (alias[PNODE_ALIAS_LENGTH-1] != parentNodeAliasCheck(alias)))
+    {
+        return RETURN_NOK;
+    }
+    if (((uint16_t)alias[0] | ((uint16_t)alias[1] << 8)) == NODE_ADDR_NULL)
+    {
+        return RETURN_NOK;
+    }
+    return RETURN_OK;
+}
+
+/**
+ * Gets the parent node a service alias points at
+ * @param   p               The parent node
+ * @return  the canonical parent node address, NODE_ADDR_NULL if p isn't an alias or if its target isn't the service it was added for anymore
+ * @note    The target isn't read as a whole: the canonical parent may have been deleted in memory management mode and its slot reused
+ */
+uint16_t getParentNodeAliasTarget(pNode* p)
+{
+    uint8_t* alias = &(p->service[PNODE_ALIAS_SERVICE_OFFSET]);
+    uint16_t canonical_addr = (uint16_t)alias[0] | ((uint16_t)alias[1] << 8);
+    uint16_t canonical_hash = (uint16_t)alias[2] | ((uint16_t)alias[3] << 8);
+    uint16_t fields[4];
+    uint16_t prev_fields[4];
+    
+    if (isParentNodeAlias(p) != RETURN_OK)
+    {
+        return NODE_ADDR_NULL;
+    }
+    if ((pageNumberFromAddress(canonical_addr) >= PAGE_COUNT) || (nodeNumberFromAddress(canonical_addr) >= NODE_PER_PAGE))
+    {
+        return NODE_ADDR_NULL;
+    }
+    
+    // Credential parent of the current user holding credentials: neither a data service nor another alias
+    readNodeLinkFields(canonical_addr, fields);
+    if ((checkUserPermissionFromFlags(canonical_addr, fields[0]) != RETURN_OK) || (validBitFromFlags(fields[0]) != NODE_VBIT_VALID) || (nodeTypeFromFlags(fields[0]) != NODE_TYPE_PARENT) || (fields[3] == NODE_ADDR_NULL))
+    {
+        return NODE_ADDR_NULL;
+    }
+    
+    // Still linked in the credential services list
+    if (fields[1] == NODE_ADDR_NULL)
+    {
+        if (canonical_addr != currentNodeMgmtHandle.firstParentNode)
+        {
+            return NODE_ADDR_NULL;
+        }
+    }
+    else
+    {
+        readNodeLinkFields(fields[1], prev_fields);
+        if (prev_fields[2] != canonical_addr)
+        {
+            return NODE_ADDR_NULL;
+        }
+    }
+    
+    // Same service as when the alias was added
+    if (parentNodeServiceHash(canonical_addr) != canonical_hash)
+    {
+        return NODE_ADDR_NULL;
+    }
+    return canonical_addr;
+}
+
+/**
+ * Gets the service holding the credentials of a credential service
+ * @param   pAddr           The parent node address
+ * @return  the canonical parent node address for valid service aliases, pAddr otherwise
+ */
+uint16_t resolveServiceAlias(uint16_t pAddr)
+{
+    pNode* ip = (pNode*)&(currentNodeMgmtHandle.tempgNode);
+    uint16_t canonical_addr;
+    
+    if (pAddr == NODE_ADDR_NULL)
+    {
+        return NODE_ADDR_NULL;
+    }
+    
+    readParentNode(ip, pAddr);
+    canonical_addr = getParentNodeAliasTarget(ip);
+    if (canonical_addr == NODE_ADDR_NULL)
+    {
+        return pAddr;
+    }
+    else
+    {
+        return canonical_addr;
+    }
+}
+#endif
+
+#ifdef NODE_FEATURE_PARENTS_REFRESH
+/**
+ * Flags the parent node summaries of the current user as stale until the next refresh
+ * @note    Called before nodes are written directly in memory management mode, the flag is kept in the user profile in case the mode is interrupted
+ */
+void markParentNodesSummariesStale(void)
+{
+    uint8_t stale_key = USER_SUMMARIES_STALE_KEY;
+    
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    // The pending parent may be rewritten or deleted by the host
+    mruPendingParent = NODE_ADDR_NULL;
+    #endif
+    
+    if (parentNodesSummariesStale == FALSE)
+    {
+        writeDataToFlash(currentNodeMgmtHandle.pageUserProfile, currentNodeMgmtHandle.offsetUserProfile + USER_PROFILE_SIZE - 1, 1, &stale_key);
+        parentNodesSummariesStale = TRUE;
+    }
+}
+
+/**
+ * Recomputes the summaries & compare keys of all the credential parent nodes of the current user, deletes the aliases of services that don't exist anymore
+ * @note    Only walks the database when nodes were written directly in memory management mode or on the first login with this firmware, parents are only rewritten when their stored records don't match
+ */
+void refreshParentNodesSummaries(void)
+{
+    pNode* ip = (pNode*)&(currentNodeMgmtHandle.tempgNode);
+    uint16_t next_parent_addr = currentNodeMgmtHandle.firstParentNode;
+    #if defined(NODE_FEATURE_SERVICE_ALIAS) && defined(NODE_FEATURE_BATCH_DELETE)
+    uint16_t alias_addr;
+    #endif
+    uint8_t rewrite_needed;
+    uint8_t migration;
+    uint8_t format_key;
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    uint16_t mru_address;
+    uint8_t summary_valid;
+    uint8_t child_count;
+    #endif
+    #ifdef NODE_FEATURE_SERVICE_COMPARE_KEY
+    uint8_t key[PNODE_COMPARE_KEY_LENGTH];
+    #endif
+    
+    // Summaries are maintained when children are created or deleted, compare keys are computed by createParentNode()
+    if (parentNodesSummariesStale == FALSE)
+    {
+        return;
+    }
+    
+    // Databases from older firmwares: the service field tails may hold anything the hosts wrote there
+    readDataFromFlash(currentNodeMgmtHandle.pageUserProfile, currentNodeMgmtHandle.offsetUserProfile + USER_PROFILE_SIZE - 1, 1, &format_key);
+    migration = (format_key != USER_SUMMARIES_STALE_KEY);
+    
+    while (next_parent_addr != NODE_ADDR_NULL)
+    {
+        readParentNode(ip, next_parent_addr);
+        rewrite_needed = FALSE;
+        
+        #ifdef NODE_FEATURE_SERVICE_ALIAS
+        // Aliases can't predate this firmware, clear the records that only look like one
+        if ((migration != FALSE) && (isParentNodeAlias(ip) == RETURN_OK))
+        {
+            memset((void*)&(ip->service[PNODE_ALIAS_SERVICE_OFFSET]), 0x00, PNODE_ALIAS_LENGTH);
+            rewrite_needed = TRUE;
+        }
+        #endif
+        
+        #if defined(NODE_FEATURE_SERVICE_ALIAS) && defined(NODE_FEATURE_BATCH_DELETE)
+        // The host may have deleted or replaced the canonical service of an alias
+        if ((isParentNodeAlias(ip) == RETURN_OK) && (getParentNodeAliasTarget(ip) == NODE_ADDR_NULL))
+        {
+            alias_addr = next_parent_addr;
+            next_parent_addr = ip->nextParentAddress;
+            deleteNodesBatch(&alias_addr, 1);
+            continue;
+        }
+        #endif
+        
+        #ifdef NODE_FEATURE_PARENT_SUMMARY
+        summary_valid = (migration == FALSE) && (ip->service[PNODE_SUMMARY_SERVICE_OFFSET+3] == parentNodeSummaryCheck(&(ip->service[PNODE_SUMMARY_SERVICE_OFFSET])));
+        
+        // Keep the most recently used child if it still is one of the children
+        mru_address = NODE_ADDR_NULL;
+        if (summary_valid)
+        {
+            mru_address = parentNodeSummaryMru(ip);
+        }
+        child_count = countParentNodeChildren(ip, &mru_address);
+        
+        if ((!summary_valid) || (ip->service[PNODE_SUMMARY_SERVICE_OFFSET] != child_count) || (parentNodeSummaryMru(ip) != mru_address))
+        {
+            setParentNodeSummary(ip, child_count, mru_address);
+            rewrite_needed = TRUE;
+        }
+        #endif
+        
+        #ifdef NODE_FEATURE_SERVICE_COMPARE_KEY
+        // The host may have written a service without its key, or changed the service
+        computeParentNodeCompareKey(ip, key);
+        if (memcmp((void*)key, (void*)&(ip->service[PNODE_COMPARE_KEY_SERVICE_OFFSET]), PNODE_COMPARE_KEY_LENGTH) != 0)
+        {
+            memcpy((void*)&(ip->service[PNODE_COMPARE_KEY_SERVICE_OFFSET]), (void*)key, PNODE_COMPARE_KEY_LENGTH);
+            rewrite_needed = TRUE;
+        }
+        #endif
+        
+        // Only rewrite the node when needed
+        if (rewrite_needed != FALSE)
+        {
+            writeNodeDataBlockToFlash(next_parent_addr, ip);
+            readParentNode(ip, next_parent_addr);
+        }
+        next_parent_addr = ip->nextParentAddress;
+    }
+    
+    // Summaries & keys are up to date
+    format_key = USER_NODES_FORMAT_KEY;
+    writeDataToFlash(currentNodeMgmtHandle.pageUserProfile, currentNodeMgmtHandle.offsetUserProfile + USER_PROFILE_SIZE - 1, 1, &format_key);
+    parentNodesSummariesStale = FALSE;
+}
+#endif
+
+/**
+ * Writes a parent node to memory (next free via handle) (in alphabetical order).
+ * @param   p               The parent node to write to memory (nextFreeParentNode)
+ * @param   type            Type of context (data or credential)
+ * @return  success status
+ * @note    Handles necessary doubly linked list management
+ */
+RET_TYPE createParentNode(pNode* p, uint8_t type)
+{
+    uint16_t temp_address, first_parent_addr, start_parent_addr;
+    // createGenericNode writes the new node at the next free address
+    uint16_t new_parent_addr = currentNodeMgmtHandle.nextFreeNode;
+    RET_TYPE temprettype;
+    
+    // Set the first parent address depending on the type
+    if (type == SERVICE_CRED_TYPE)
+    {
+        first_parent_addr = currentNodeMgmtHandle.firstParentNode;
+        // Services starting with a letter before the new service's one can be skipped
+        start_parent_addr = getParentNodeForLetter(p->service[0]);
+    } 
+    else
+    {
+        first_parent_addr = currentNodeMgmtHandle.firstDataParentNode;
+        start_parent_addr = getDataParentNodeForLetter(p->service[0]);
+    }
+    
+    // This is particular to parent nodes...
+    p->nextChildAddress = NODE_ADDR_NULL;
+    
+    // New services use the device wide typing delay
+    p->flags &= ~NODE_F_PARENT_TYPING_DELAY_MASK;
+    
+    if (type == SERVICE_CRED_TYPE)
+    {
+        nodeTypeToFlags(&(p->flags), NODE_TYPE_PARENT);
+        #ifdef NODE_FEATURE_PARENT_SUMMARY
+        // No children yet
+        setParentNodeSummary(p, 0, NODE_ADDR_NULL);
+        #endif
+        #ifdef NODE_FEATURE_SERVICE_COMPARE_KEY
+        computeParentNodeCompareKey(p, &(p->service[PNODE_COMPARE_KEY_SERVICE_OFFSET]));
+        #endif
+    }
+    else
+    {
+        nodeTypeToFlags(&(p->flags), NODE_TYPE_PARENT_DATA);
+    }
+    
+    // Call createGenericNode to add a node
+    temprettype = createGenericNode((gNode*)p, start_parent_addr, &temp_address, PNODE_COMPARISON_FIELD_OFFSET, NODE_PARENT_SIZE_OF_SERVICE);
+    
+    // If the return is ok & we changed the first node address
+    if ((temprettype == RETURN_OK) && (start_parent_addr != temp_address))
+    {
+        if (type == SERVICE_CRED_TYPE)
+        {
+            setStartingParent(temp_address);
+        }
+        else
+        {
+            setDataStartingParent(temp_address);
+        }
+    }
+    
+    // Update the services LUT for the new service
+    if ((temprettype == RETURN_OK) && (type == SERVICE_CRED_TYPE))
+    {
+        insertServiceInServicesLut(p, new_parent_addr);
+    }
+    #ifdef NODE_FEATURE_DATA_SERVICES_LUT
+    else if (temprettype == RETURN_OK)
+    {
+        insertServiceInDataServicesLut(p, new_parent_addr);
+    }
+    #endif
+    
+    return temprettype;
+}
+
+/**
+ * Updates the keyboard typing delay profile of a given parent node
+ * @param   p               Pointer to a temporary parent node for buffer purposes
+ * @param   pAddr           The address to the parent node to update
+ * @param   delay_profile   The typing delay profile, 0 for the device wide setting
+ * @note    pNode will be filled with the parent node in case it may be useful....
+ * @return  success status
+ */
+RET_TYPE updateParentNodeTypingDelay(pNode* p, uint16_t pAddr, uint8_t delay_profile)
+{
+    if (delay_profile > NODE_F_PARENT_TYPING_DELAY_MASK_FINAL)
+    {
+        return RETURN_NOK;
+    }
+    
+    // userID check and valid check performed in readParent
+    readParentNode(p, pAddr);
+    
+    // Update typing delay bits
+    p->flags = (p->flags & ~NODE_F_PARENT_TYPING_DELAY_MASK) | ((uint16_t)delay_profile << NODE_F_PARENT_TYPING_DELAY_SHMT);
+    
+    // service is identical just rewrite the node
+    writeNodeDataBlockToFlash(pAddr, p);
+    
+    // write is destructive.. read
+    readParentNode(p, pAddr);
+    
+    return RETURN_OK;
+}
+
+/**
+ * Writes a child node to memory (next free via handle) (in alphabetical order).
+ * @param   pAddr           The parent node address of the child
+ * @param   c               The child node to write to memory (nextFreeChildNode)
+ * @return  success status
+ * @note    Handles necessary doubly linked list management
+ */
+RET_TYPE createChildNode(uint16_t pAddr, cNode *c)
+{
+    pNode* tempPNodePointer = (pNode*)&(currentNodeMgmtHandle.tempgNode);
+    uint16_t childFirstAddress, temp_address;
+    RET_TYPE temprettype;
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    // createGenericNode writes the new node at the next free address
+    uint16_t newChildAddress = currentNodeMgmtHandle.nextFreeNode;
+    uint8_t childCount;
+    #endif
+    
+    // Set node type to child
+    nodeTypeToFlags(&(c->flags), NODE_TYPE_CHILD);
+    
+    // Write date created & used fields
+    c->dateCreated = currentDate;
+    c->dateLastUsed = currentDate;
+    
+    // Read parent to get the first child address
+    readNode((gNode*)tempPNodePointer, pAddr);
+    childFirstAddress = tempPNodePointer->nextChildAddress;
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    childCount = getParentNodeChildCount(tempPNodePointer);
+    #endif
+    
+    // Call createGenericNode to add a node
+    temprettype = createGenericNode((gNode*)c, childFirstAddress, &temp_address, CNODE_COMPARISON_FIELD_OFFSET, NODE_CHILD_SIZE_OF_LOGIN);
+    
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    // Update the first child address & the summary in a single parent write
+    if (temprettype == RETURN_OK)
+    {
+       readNode((gNode*)tempPNodePointer, pAddr);
+       tempPNodePointer->nextChildAddress = temp_address;
+       if (childCount != 0xFF)
+       {
+           childCount++;
+       }
+       setParentNodeSummary(tempPNodePointer, childCount, newChildAddress);
+       writeNodeDataBlockToFlash(pAddr, tempPNodePointer);
+       if (mruPendingParent == pAddr)
+       {
+           mruPendingParent = NODE_ADDR_NULL;
+       }
+    }
+    #else
+    // If the return is ok & we changed the first child address
+    if ((temprettype == RETURN_OK) && (childFirstAddress != temp_address))
+    {
+       readNode((gNode*)tempPNodePointer, pAddr);
+       tempPNodePointer->nextChildAddress = temp_address;
+       writeNodeDataBlockToFlash(pAddr, tempPNodePointer);
+    }
+    #endif
+    
+    return temprettype;
+}   
+
+/**
+ * Writes a new data node to memory (next free via handle) (in alphabetical order).
+ * @param   context_parent_node_addr    Address to the parent node
+ * @param   parent_node_ptr             Parent node pointer
+ * @param   data_node_ptr               Data node pointer
+ * @param   first_data_block_flag       Flag to see if it is the first data block
+ * @param   last_packet_flag            Flag to know if it is the last block
+ * @return  success status
+ */
+RET_TYPE writeNewDataNode(uint16_t context_parent_node_addr, pNode* parent_node_ptr, dNode* data_node_ptr, uint8_t first_data_block_flag, uint8_t last_packet_flag)
+{
+    gNode* memNodePtr = &(currentNodeMgmtHandle.tempgNode);
+    // Our next 2 free addresses
+    uint16_t next_free_addresses[2];
+    
+    // This is what scan node usage uses internally, check space in flash
+    if (findFreeNodes(2, next_free_addresses, 0, 0) != 2)
+    {
+        return RETURN_NOK;
+    }    
+    
+    // If it is the first data node we need to update the parent
+    if (first_data_block_flag == TRUE)
+    {
+        // Read supposed parent node
+        readNode(memNodePtr, context_parent_node_addr);
+        
+        #ifdef NODE_FEATURE_COMPRESSED_DATA
+        // The encoding flag is updated together with the first data node
+        memNodePtr->flags = (memNodePtr->flags & ~NODE_F_DATA_PARENT_COMPRESSED_MASK) | (parent_node_ptr->flags & NODE_F_DATA_PARENT_COMPRESSED_MASK);
+        #endif
+        
+        // Check the parent nodes fields are the same, update parent node at the right address
+        if (memcmp((void*)memNodePtr, (void*)parent_node_ptr, FLAGS_PREV_NEXT_ADDR_LENGTH) == 0)
+        {
+            parent_node_ptr->nextChildAddress = next_free_addresses[0];
+            writeNodeDataBlockToFlash(context_parent_node_addr, parent_node_ptr);
+        }
+        else
+        {
+            return RETURN_NOK;
+        }
+    }
+    
+    // Set correct user id to the node
+    userIdToFlags(&(data_node_ptr->flags), currentNodeMgmtHandle.currentUserId);
+    
+    // set valid bit
+    validBitToFlags(&(data_node_ptr->flags), NODE_VBIT_VALID);
+    
+    // Set correct node type
+    nodeTypeToFlags(&(data_node_ptr->flags), NODE_TYPE_DATA);
+    
+    // If it is not the last packet, set next address
+    if (last_packet_flag == FALSE)
+    {
+        // Because we can't interrupt data transfer, the next address will automatically be the next one we have in memory
+        data_node_ptr->nextDataAddress = next_free_addresses[1];
+    }
+    
+    // write parent node to flash (destructive)
+    writeNodeDataBlockToFlash(next_free_addresses[0], data_node_ptr);
+    
+    // Update free node address
+    currentNodeMgmtHandle.nextFreeNode = next_free_addresses[1];
+    
+    return RETURN_OK;
+}
+
+/**
+ * Writes a generic node to memory (next free via handle) (in alphabetical order).
+ * @param   g                       The node to write to memory (nextFreeParentNode)
+ * @param   firstNodeAddress        Address of the first node of its kind, or of any node that doesn't come after g
+ * @param   newFirstNodeAddress     If g becomes the first node of its kind, this var will store its address (firstNodeAddress otherwise)
+ * @param   comparisonFieldOffset   The offset used to do the comparison used for the sorting
+ * @param   comparisonFieldLength   The length of the field used for comparison
+ * @return  success status
+ * @note    Handles necessary doubly linked list management
+ */
+RET_TYPE createGenericNode(gNode* g, uint16_t firstNodeAddress, uint16_t* newFirstNodeAddress, uint8_t comparisonFieldOffset, uint8_t comparisonFieldLength)
+{
+    gNode* memNodePtr = &(currentNodeMgmtHandle.tempgNode);
+    uint16_t addr = NODE_ADDR_NULL;
+    int8_t res = 0;
+    
+    // Set newFirstNodeAddress to firstNodeAddress by default
+    *newFirstNodeAddress = firstNodeAddress;
+    
+    // Check space in flash
+    if (currentNodeMgmtHandle.nextFreeNode == NODE_ADDR_NULL)
+    {
+        return RETURN_NOK;
+    }
+    
+    // Set correct user id to the node
+    userIdToFlags(&(g->flags), currentNodeMgmtHandle.currentUserId);
+    
+    // set valid bit
     validBitToFlags(&(g->flags), NODE_VBIT_VALID);
 
     // clear next/prev address
@@ -862,7 +1803,7 @@ RET_TYPE createGenericNode(gNode* g, uint16_t firstNodeAddress, uint16_t* newFir
                     writeNodeDataBlockToFlash(g->prevAddress, memNodePtr);
                 }                
                 
-                if(addr == firstNodeAddress)
+                if(g->prevAddress == NODE_ADDR_NULL)
                 {
                     // new node comes before current address and current address in first node.
                     // new node should be first node
@@ -886,6 +1827,71 @@ RET_TYPE createGenericNode(gNode* g, uint16_t firstNodeAddress, uint16_t* newFir
     return RETURN_OK;
 }
 
+#ifdef NODE_FEATURE_DATA_SERVICES_LUT
+/*! \fn     populateDataServicesLut(void)
+*   \brief  Populate our LUT for our data services
+*/
+static void populateDataServicesLut(void)
+{
+    uint16_t next_node_addr = currentNodeMgmtHandle.firstDataParentNode;
+    uint8_t temp_node_buffer[9];
+    uint16_t temp_page_number;
+    pNode* pnode_ptr = (pNode*)temp_node_buffer;
+    uint8_t first_service_letter;
+    
+    // Empty our current data services list
+    memset(currentNodeMgmtHandle.dataServicesLut, 0x00, sizeof(currentNodeMgmtHandle.dataServicesLut));
+    
+    // Same eeprom setting as the credential services LUT
+    if (getMooltipassParameterInEeprom(LUT_BOOT_POPULATING_PARAM) == FALSE)
+    {
+        return;
+    }
+    
+    while(next_node_addr != NODE_ADDR_NULL)
+    {
+        // Get the node page number, check that we're not out of memory bounds
+        temp_page_number = pageNumberFromAddress(next_node_addr);
+        if(temp_page_number >= PAGE_COUNT)
+        {
+            return;
+        }
+        
+        // Read first 9 bytes of the parent node as we just want to know the first letter
+        readDataFromFlash(temp_page_number, NODE_SIZE * nodeNumberFromAddress(next_node_addr), sizeof(temp_node_buffer), temp_node_buffer);
+        first_service_letter = pnode_ptr->service[0];
+        
+        // LUT is only for chars between 'a' and 'z', populate the entry if it isn't
+        if ((first_service_letter >= 'a') && (first_service_letter <= 'z') && (currentNodeMgmtHandle.dataServicesLut[first_service_letter - 'a'] == NODE_ADDR_NULL))
+        {
+            currentNodeMgmtHandle.dataServicesLut[first_service_letter - 'a'] = next_node_addr;
+        }
+        
+        // Fetch next node
+        next_node_addr = pnode_ptr->nextParentAddress;
+    }
+}
+
+/*! \fn     insertServiceInDataServicesLut(pNode* p, uint16_t pAddr)
+*   \brief  Update our data services LUT for a data service that was just inserted in the data parent list
+*   \param  p       The new data parent node, as read back after its insertion
+*   \param  pAddr   Address of the new data parent node
+*/
+void insertServiceInDataServicesLut(pNode* p, uint16_t pAddr)
+{
+    uint8_t first_service_letter = p->service[0];
+    
+    if ((getMooltipassParameterInEeprom(LUT_BOOT_POPULATING_PARAM) != FALSE) && (first_service_letter >= 'a') && (first_service_letter <= 'z'))
+    {
+        // The new data service is the first one for its letter if there was none or if it was inserted right before it
+        if ((currentNodeMgmtHandle.dataServicesLut[first_service_letter - 'a'] == NODE_ADDR_NULL) || (currentNodeMgmtHandle.dataServicesLut[first_service_letter - 'a'] == p->nextParentAddress))
+        {
+            currentNodeMgmtHandle.dataServicesLut[first_service_letter - 'a'] = pAddr;
+        }
+    }
+}
+#endif
+
 /*! \fn     populateServicesLut(void)
 *   \brief  Populate our LUT for our services
 */
@@ -900,6 +1906,11 @@ void populateServicesLut(void)
     // Empty our current services list
     memset(currentNodeMgmtHandle.servicesLut, 0x00, sizeof(currentNodeMgmtHandle.servicesLut));
     
+    #ifdef NODE_FEATURE_DATA_SERVICES_LUT
+    // The data services LUT is refreshed together with the credential one
+    populateDataServicesLut();
+    #endif
+    
     // If the dedicated boolean in eeprom is sent, do not actually populate the LUT
     if (getMooltipassParameterInEeprom(LUT_BOOT_POPULATING_PARAM) == FALSE)
     {
@@ -942,6 +1953,39 @@ void populateServicesLut(void)
     }
 }
 
+/*! \fn     insertServiceInServicesLut(pNode* p, uint16_t pAddr)
+*   \brief  Update our LUT for a service that was just inserted in the parent list, without walking the list
+*   \param  p       The new parent node, as read back after its insertion
+*   \param  pAddr   Address of the new parent node
+*/
+void insertServiceInServicesLut(pNode* p, uint16_t pAddr)
+{
+    uint8_t first_service_letter = p->service[0];
+    
+    // If the dedicated boolean in eeprom is sent, the LUT isn't populated
+    if (getMooltipassParameterInEeprom(LUT_BOOT_POPULATING_PARAM) == FALSE)
+    {
+        currentNodeMgmtHandle.lastParentNode = getStartingParentAddress();
+        return;
+    }
+    
+    // LUT is only for chars between 'a' and 'z'
+    if ((first_service_letter >= 'a') && (first_service_letter <= 'z'))
+    {
+        // The new service is the first one for its letter if there was none or if it was inserted right before it
+        if ((currentNodeMgmtHandle.servicesLut[first_service_letter - 'a'] == NODE_ADDR_NULL) || (currentNodeMgmtHandle.servicesLut[first_service_letter - 'a'] == p->nextParentAddress))
+        {
+            currentNodeMgmtHandle.servicesLut[first_service_letter - 'a'] = pAddr;
+        }
+    }
+    
+    // Last node address
+    if (p->nextParentAddress == NODE_ADDR_NULL)
+    {
+        currentNodeMgmtHandle.lastParentNode = pAddr;
+    }
+}
+
 /*! \fn     getPreviousNextFirstLetterForGivenLetter(char c, char* array, uint16_t* parent_addresses)
 *   \brief  Get the previous and next letter around a given letter
 *   \param  c                   The first letter
@@ -956,73 +2000,240 @@ void getPreviousNextFirstLetterForGivenLetter(char c, char* array, uint16_t* par
     parent_addresses[0] = NODE_ADDR_NULL;
     parent_addresses[2] = NODE_ADDR_NULL;
 
-    // Store the provided char as first letter for the current credential
-    if ((c >= 'a') && (c <= 'z'))
-    {
-        array[1] = c - 'a' + 'A';
-    } 
-    else
+    // Store the provided char as first letter for the current credential
+    if ((c >= 'a') && (c <= 'z'))
+    {
+        array[1] = c - 'a' + 'A';
+    } 
+    else
+    {
+        array[1] = c;
+    }
+
+    // Loop through our LUT
+    for (uint8_t i = 0; i < sizeof(currentNodeMgmtHandle.servicesLut)/sizeof(currentNodeMgmtHandle.servicesLut[0]); i++)
+    {
+        if (currentNodeMgmtHandle.servicesLut[i] != NODE_ADDR_NULL)
+        {
+            if (((i + 'a') < c) && (array[0] != (i + 'A')))
+            {
+                // First letter before the current one, only run once for each letter
+                array[0] = i + 'A';
+                parent_addresses[0] = currentNodeMgmtHandle.servicesLut[i];
+            }
+            if ((i + 'a') > c)
+            {
+                // First letter after the current one
+                array[2] = i + 'A';
+                parent_addresses[2] = currentNodeMgmtHandle.servicesLut[i];
+                return;
+            }
+        }
+    }
+}
+
+/*! \fn     getParentNodeForLetter(uint8_t letter, uint8_t empty_mode)
+*   \brief  Use the LUT to find the first parent node for a given letter
+*   \note   If we don't know the letter, the first previous one will be returned
+*   \param  letter      The first letter
+*/
+uint16_t getParentNodeForLetter(uint8_t letter)
+{    
+    // LUT is only for chars between 'a' and 'z'
+    if ((letter >= 'a') && (letter <= 'z'))
+    {
+        // If the entry is populated, return it
+        if (currentNodeMgmtHandle.servicesLut[letter - 'a'] != NODE_ADDR_NULL)
+        {
+            return currentNodeMgmtHandle.servicesLut[letter - 'a'];
+        }
+        else
+        {            
+            // No entry, return the one before
+            for (int8_t i = letter - 'a'; i >= 0; i--)
+            {
+                if (currentNodeMgmtHandle.servicesLut[(uint8_t)i] != NODE_ADDR_NULL)
+                {
+                    return currentNodeMgmtHandle.servicesLut[(uint8_t)i];
+                }
+            }
+                
+            // If we're here it means nothing was found so we return the starting parent
+            return currentNodeMgmtHandle.firstParentNode;
+        }
+    }
+    else
+    {
+        return currentNodeMgmtHandle.firstParentNode;
+    }
+}
+
+/*! \fn     getDataParentNodeForLetter(uint8_t letter)
+*   \brief  Use the data services LUT to find the first data parent node for a given letter
+*   \note   If we don't know the letter, the first previous one will be returned
+*   \param  letter      The first letter
+*/
+uint16_t getDataParentNodeForLetter(uint8_t letter)
+{
+    #ifdef NODE_FEATURE_DATA_SERVICES_LUT
+    // LUT is only for chars between 'a' and 'z'
+    if ((letter >= 'a') && (letter <= 'z'))
+    {
+        // Entry for the letter or the closest previous one
+        for (int8_t i = letter - 'a'; i >= 0; i--)
+        {
+            if (currentNodeMgmtHandle.dataServicesLut[(uint8_t)i] != NODE_ADDR_NULL)
+            {
+                return currentNodeMgmtHandle.dataServicesLut[(uint8_t)i];
+            }
+        }
+    }
+    #endif
+    return currentNodeMgmtHandle.firstDataParentNode;
+}
+
+#ifdef GUI_FEATURE_PREDICTIVE_SEARCH
+/*! \fn     markServiceNextCharacter(uint8_t* char_bitmap, uint8_t c)
+*   \brief  Mark a printable character as available in a next characters bitmap
+*   \param  char_bitmap Next characters bitmap
+*   \param  c           The character
+*/
+static inline void markServiceNextCharacter(uint8_t* char_bitmap, uint8_t c)
+{
+    if ((c >= SERVICE_CHAR_BITMAP_FIRST_CHAR) && (c <= SERVICE_CHAR_BITMAP_LAST_CHAR))
+    {
+        char_bitmap[(c - SERVICE_CHAR_BITMAP_FIRST_CHAR) >> 3] |= (1 << ((c - SERVICE_CHAR_BITMAP_FIRST_CHAR) & 0x07));
+    }
+}
+
+/*! \fn     getServiceNextCharacters(uint8_t* prefix, uint8_t prefix_length, uint8_t buffer_length, uint8_t* char_bitmap)
+*   \brief  Find which characters follow a given prefix in the current user credential service names
+*   \param  prefix          Service name prefix (lower case, as stored in the parent nodes)
+*   \param  prefix_length   Prefix length
+*   \param  buffer_length   Size of the prefix buffer, used for completion (0: no completion)
+*   \param  char_bitmap     SERVICE_CHAR_BITMAP_SIZE bytes bitmap in which the available characters are set
+*   \return Address of the parent node if only one service matches the prefix (prefix buffer then contains its full name), NODE_ADDR_NULL otherwise
+*   \note   The services are sorted: the matching parents are found with the LUT and a bounded forward scan.
+*           When the scan bound is reached, all the characters after the last one found are set (superset)
+*/
+uint16_t getServiceNextCharacters(uint8_t* prefix, uint8_t prefix_length, uint8_t buffer_length, uint8_t* char_bitmap)
+{
+    uint8_t temp_node_buffer[PNODE_COMPARISON_FIELD_OFFSET + SERVICE_PREDICTION_MAX_PREFIX + 1];
+    uint16_t next_node_addr = currentNodeMgmtHandle.firstParentNode;
+    pNode* pnode_ptr = (pNode*)temp_node_buffer;
+    uint16_t matching_node_addr = NODE_ADDR_NULL;
+    uint8_t nb_scanned_nodes = 0;
+    uint8_t nb_matching_nodes = 0;
+    uint8_t last_char = SERVICE_CHAR_BITMAP_FIRST_CHAR;
+    uint8_t next_char;
+    int8_t i;
+
+    memset(char_bitmap, 0x00, SERVICE_CHAR_BITMAP_SIZE);
+
+    // Prefix too long for our buffer: no prediction
+    if (prefix_length > SERVICE_PREDICTION_MAX_PREFIX)
     {
-        array[1] = c;
+        memset(char_bitmap, 0xFF, SERVICE_CHAR_BITMAP_SIZE);
+        return NODE_ADDR_NULL;
     }
 
-    // Loop through our LUT
-    for (uint8_t i = 0; i < sizeof(currentNodeMgmtHandle.servicesLut)/sizeof(currentNodeMgmtHandle.servicesLut[0]); i++)
+    if (prefix_length > 0)
     {
-        if (currentNodeMgmtHandle.servicesLut[i] != NODE_ADDR_NULL)
+        // No service starts with a letter that isn't in the LUT
+        if ((prefix[0] >= 'a') && (prefix[0] <= 'z') && (currentNodeMgmtHandle.servicesLut[prefix[0] - 'a'] == NODE_ADDR_NULL) && (getMooltipassParameterInEeprom(LUT_BOOT_POPULATING_PARAM) != FALSE))
         {
-            if (((i + 'a') < c) && (array[0] != (i + 'A')))
-            {
-                // First letter before the current one, only run once for each letter
-                array[0] = i + 'A';
-                parent_addresses[0] = currentNodeMgmtHandle.servicesLut[i];
-            }
-            if ((i + 'a') > c)
-            {
-                // First letter after the current one
-                array[2] = i + 'A';
-                parent_addresses[2] = currentNodeMgmtHandle.servicesLut[i];
-                return;
-            }
+            return NODE_ADDR_NULL;
         }
+        next_node_addr = getParentNodeForLetter(prefix[0]);
     }
-}
 
-/*! \fn     getParentNodeForLetter(uint8_t letter, uint8_t empty_mode)
-*   \brief  Use the LUT to find the first parent node for a given letter
-*   \note   If we don't know the letter, the first previous one will be returned
-*   \param  letter      The first letter
-*/
-uint16_t getParentNodeForLetter(uint8_t letter)
-{    
-    // LUT is only for chars between 'a' and 'z'
-    if ((letter >= 'a') && (letter <= 'z'))
+    while ((next_node_addr != NODE_ADDR_NULL) && (nb_scanned_nodes++ < SERVICE_PREDICTION_MAX_SCAN))
     {
-        // If the entry is populated, return it
-        if (currentNodeMgmtHandle.servicesLut[letter - 'a'] != NODE_ADDR_NULL)
+        // Read the node header and the part of the service we need
+        readDataFromFlash(pageNumberFromAddress(next_node_addr), NODE_SIZE * nodeNumberFromAddress(next_node_addr), PNODE_COMPARISON_FIELD_OFFSET + prefix_length + 1, temp_node_buffer);
+
+        if (prefix_length == 0)
         {
-            return currentNodeMgmtHandle.servicesLut[letter - 'a'];
+            next_char = pnode_ptr->service[0];
+            markServiceNextCharacter(char_bitmap, next_char);
+            last_char = next_char;
+
+            // Other services with the same first letter can be skipped thanks to the LUT
+            if ((next_char >= 'a') && (next_char <= 'z'))
+            {
+                for (i = next_char - 'a' + 1; i < (int8_t)(sizeof(currentNodeMgmtHandle.servicesLut)/sizeof(currentNodeMgmtHandle.servicesLut[0])); i++)
+                {
+                    if (currentNodeMgmtHandle.servicesLut[(uint8_t)i] != NODE_ADDR_NULL)
+                    {
+                        break;
+                    }
+                }
+                if (i < (int8_t)(sizeof(currentNodeMgmtHandle.servicesLut)/sizeof(currentNodeMgmtHandle.servicesLut[0])))
+                {
+                    next_node_addr = currentNodeMgmtHandle.servicesLut[(uint8_t)i];
+                    continue;
+                }
+            }
         }
         else
-        {            
-            // No entry, return the one before
-            for (int8_t i = letter - 'a'; i >= 0; i--)
+        {
+            i = strncmp((char*)pnode_ptr->service, (char*)prefix, prefix_length);
+
+            // Past the matching range
+            if (i > 0)
             {
-                if (currentNodeMgmtHandle.servicesLut[(uint8_t)i] != NODE_ADDR_NULL)
+                next_node_addr = NODE_ADDR_NULL;
+                break;
+            }
+            else if (i == 0)
+            {
+                next_char = pnode_ptr->service[prefix_length];
+                markServiceNextCharacter(char_bitmap, next_char);
+                if (next_char != 0)
                 {
-                    return currentNodeMgmtHandle.servicesLut[(uint8_t)i];
+                    last_char = next_char;
                 }
+                matching_node_addr = next_node_addr;
+                nb_matching_nodes++;
             }
-                
-            // If we're here it means nothing was found so we return the starting parent
-            return currentNodeMgmtHandle.firstParentNode;
         }
+
+        next_node_addr = pnode_ptr->nextParentAddress;
     }
-    else
+
+    // Scan bound reached: the remaining services can only continue with characters after the last one we found
+    if (next_node_addr != NODE_ADDR_NULL)
     {
-        return currentNodeMgmtHandle.firstParentNode;
+        for (next_char = last_char; next_char <= SERVICE_CHAR_BITMAP_LAST_CHAR; next_char++)
+        {
+            markServiceNextCharacter(char_bitmap, next_char);
+        }
+        return NODE_ADDR_NULL;
+    }
+
+    // Unique service for that prefix: complete it
+    if ((prefix_length == 0) && (currentNodeMgmtHandle.firstParentNode == currentNodeMgmtHandle.lastParentNode))
+    {
+        matching_node_addr = currentNodeMgmtHandle.firstParentNode;
+        nb_matching_nodes = 1;
+    }
+    if ((nb_matching_nodes == 1) && (matching_node_addr != NODE_ADDR_NULL) && (checkUserPermission(matching_node_addr) == RETURN_OK))
+    {
+        if (buffer_length > NODE_PARENT_SIZE_OF_SERVICE)
+        {
+            buffer_length = NODE_PARENT_SIZE_OF_SERVICE;
+        }
+        if (buffer_length > prefix_length)
+        {
+            readDataFromFlash(pageNumberFromAddress(matching_node_addr), NODE_SIZE * nodeNumberFromAddress(matching_node_addr) + PNODE_COMPARISON_FIELD_OFFSET, buffer_length - 1, prefix);
+            prefix[buffer_length - 1] = 0;
+        }
+        return matching_node_addr;
     }
+
+    return NODE_ADDR_NULL;
 }
+#endif
 
 /*! \fn     findFreeNodes(uint8_t nbNodes, uint16_t* array)
 *   \brief  Find Free Nodes inside our external memory
@@ -1073,6 +2284,96 @@ uint8_t findFreeNodes(uint8_t nbNodes, uint16_t* nodeArray, uint16_t startPage,
     return nbNodesFound;
 }
 
+#ifdef NODE_FEATURE_TOPOLOGY_DUMP
+/**
+ * Scans the memory for the nodes of the current user and describes them compactly
+ * @param   nbNodes         The maximum number of nodes to describe
+ * @param   nodeArray       Storage for the node descriptions
+ * @param   scanAddress     The address to start scanning from, set to the address to resume from or to NODE_ADDR_NULL when the end of the memory was reached
+ * @return  The number of nodes described
+ * @note    At most NODE_TOPOLOGY_MAX_PAGES pages are scanned, so fewer than nbNodes nodes may be described before the end of the memory
+ */
+uint8_t getUserNodesTopology(uint8_t nbNodes, nodeTopology_t* nodeArray, uint16_t* scanAddress)
+{
+    uint16_t pageItr = pageNumberFromAddress(*scanAddress);
+    uint8_t nodeItr = nodeNumberFromAddress(*scanAddress);
+    uint16_t pageEnd;
+    uint8_t nbNodesFound = 0;
+    uint8_t temp_buffer[16];
+    uint32_t crc;
+    
+    // Check the start page
+    if (pageItr < PAGE_PER_SECTOR)
+    {
+        pageItr = PAGE_PER_SECTOR;
+        nodeItr = 0;
+    }
+    
+    // Bound the time spent per call, sparse databases would otherwise be scanned in one go
+    pageEnd = pageItr + NODE_TOPOLOGY_MAX_PAGES;
+    if (pageEnd > PAGE_COUNT)
+    {
+        pageEnd = PAGE_COUNT;
+    }
+    
+    // for each page
+    for(; pageItr < pageEnd; pageItr++)
+    {
+        // for each possible node in the page
+        for(; nodeItr < NODE_PER_PAGE; nodeItr++)
+        {
+            // Nodes array full, resume from here next time
+            if (nbNodesFound == nbNodes)
+            {
+                *scanAddress = constructAddress(pageItr, nodeItr);
+                return nbNodesFound;
+            }
+            
+            // Read the flags and address fields
+            readDataFromFlash(pageItr, NODE_SIZE*nodeItr, sizeof(temp_buffer), temp_buffer);
+            memcpy((void*)&nodeArray[nbNodesFound].flags, (void*)temp_buffer, sizeof(uint16_t) + sizeof(nodeArray[nbNodesFound].links));
+            
+            // Only describe valid nodes belonging to the current user
+            if ((validBitFromFlags(nodeArray[nbNodesFound].flags) == NODE_VBIT_VALID) && (userIdFromFlags(nodeArray[nbNodesFound].flags) == getCurrentUserID()))
+            {
+                // Digest the complete node, 16 bytes at a time
+                crc = 0xFFFFFFFF;
+                for (uint8_t offset = 0; offset < NODE_SIZE; offset += sizeof(temp_buffer))
+                {
+                    uint8_t chunk_length = sizeof(temp_buffer);
+                    if ((NODE_SIZE - offset) < sizeof(temp_buffer))
+                    {
+                        chunk_length = NODE_SIZE - offset;
+                    }
+                    if (offset != 0)
+                    {
+                        readDataFromFlash(pageItr, NODE_SIZE*nodeItr + offset, chunk_length, temp_buffer);
+                    }
+                    for (uint8_t i = 0; i < chunk_length; i++)
+                    {
+                        crc = crc32_update(crc, temp_buffer[i]);
+                    }
+                }
+                nodeArray[nbNodesFound].digest = ~crc;
+                nodeArray[nbNodesFound++].nodeAddress = constructAddress(pageItr, nodeItr);
+            }
+        }
+        nodeItr = 0;
+    }
+    
+    // Resume from the next page unless the end of the memory was reached
+    if (pageItr < PAGE_COUNT)
+    {
+        *scanAddress = constructAddress(pageItr, 0);
+    }
+    else
+    {
+        *scanAddress = NODE_ADDR_NULL;
+    }
+    return nbNodesFound;
+}
+#endif
+
 /*! \fn     scanNodeUsage(void)
 *   \brief  Scan memory to find empty slots
 */
@@ -1093,8 +2394,11 @@ void deleteCurrentUserFromFlash(void)
     uint16_t next_parent_addr = currentNodeMgmtHandle.firstParentNode;
     uint16_t next_child_addr;
     uint16_t temp_address;
-    pNode temp_pnode;
-    cNode temp_cnode;
+    uint16_t fields[4];
+    
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    mruPendingParent = NODE_ADDR_NULL;
+    #endif
     
     // Delete user profile memory
     formatUserProfileMemory(currentNodeMgmtHandle.currentUserId);
@@ -1104,45 +2408,38 @@ void deleteCurrentUserFromFlash(void)
     {
         while (next_parent_addr != NODE_ADDR_NULL)
         {
-            // Read current parent node
-            readParentNode(&temp_pnode, next_parent_addr);
+            // Read current parent node flags & addresses
+            if (checkUserPermission(next_parent_addr) != RETURN_OK)
+            {
+                nodeMgmtPermissionValidityErrorCallback();
+            }
+            readNodeLinkFields(next_parent_addr, fields);
             
-            // Read his first child
-            next_child_addr = temp_pnode.nextChildAddress;
+            // Store the next parent address in temp, read his first child
+            temp_address = fields[2];
+            next_child_addr = fields[3];
             
             // Browse through all children
             while (next_child_addr != NODE_ADDR_NULL)
             {
-                // Read child node
-                readChildNode(&temp_cnode, next_child_addr);
-                
-                // Store the next child address in temp
-                if (i == 0)
-                {
-                    // First loop is cnode
-                    temp_address = temp_cnode.nextChildAddress;
-                } 
-                else
+                // Read child node flags & addresses
+                if (checkUserPermission(next_child_addr) != RETURN_OK)
                 {
-                    // Second loop is dnode
-                    dNode* temp_dnode_ptr = (dNode*)&temp_cnode;
-                    temp_address = temp_dnode_ptr->nextDataAddress;
+                    nodeMgmtPermissionValidityErrorCallback();
                 }
+                readNodeLinkFields(next_child_addr, fields);
                 
-                // Delete child data block
-                memset(&temp_cnode, 0xFF, NODE_SIZE);
-                writeNodeDataBlockToFlash(next_child_addr, &temp_cnode);
+                // Delete child data block, the buffer is destroyed by each write
+                memset((void*)&currentNodeMgmtHandle.tempgNode, DELETE_POLICY_WRITE_ONES, NODE_SIZE);
+                writeNodeDataBlockToFlash(next_child_addr, &currentNodeMgmtHandle.tempgNode);
                 
-                // Set correct next address
-                next_child_addr = temp_address;
+                // Set correct next address: first loop is cnode (nextChildAddress), second loop is dnode (nextDataAddress)
+                next_child_addr = (i == 0) ? fields[2] : fields[1];
             }
             
-            // Store the next parent address in temp
-            temp_address = temp_pnode.nextParentAddress;
-            
             // Delete parent data block
-            memset(&temp_pnode, 0xFF, NODE_SIZE);
-            writeNodeDataBlockToFlash(next_parent_addr, &temp_pnode);
+            memset((void*)&currentNodeMgmtHandle.tempgNode, DELETE_POLICY_WRITE_ONES, NODE_SIZE);
+            writeNodeDataBlockToFlash(next_parent_addr, &currentNodeMgmtHandle.tempgNode);
             
             // Set correct next address
             next_parent_addr = temp_address;
@@ -1199,6 +2496,10 @@ RET_TYPE updateChildNode(pNode *p, cNode *c, uint16_t pAddr, uint16_t cAddr)
             
             // write is destructive.. read
             readChildNode(&(*c), cAddr);
+            
+            #ifdef NODE_FEATURE_PARENT_SUMMARY
+            setParentNodeMruChild(pAddr, cAddr);
+            #endif
         }
         else
         {            
@@ -1231,10 +2532,24 @@ RET_TYPE deleteChildNode(uint16_t pAddr, uint16_t cAddr, cNode *ic)
 {
     pNode *ip = (pNode*)&(currentNodeMgmtHandle.tempgNode);
     uint16_t prevAddress, nextAddress;
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    uint16_t mruChild;
+    uint8_t childCount;
+    #endif
     
     // read parent node of child to delete
     readParentNode(ip, pAddr);
     
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    // Fetch the summary before the child list changes
+    childCount = getParentNodeChildCount(ip);
+    mruChild = getParentNodeMruChild(ip, pAddr);
+    if (mruPendingParent == pAddr)
+    {
+        mruPendingParent = NODE_ADDR_NULL;
+    }
+    #endif
+    
     // read child node to delete
     readChildNode(ic, cAddr);
 
@@ -1281,12 +2596,296 @@ RET_TYPE deleteChildNode(uint16_t pAddr, uint16_t cAddr, cNode *ic)
         //     set starting parent to next
         // Long story short.. set parent to nextChildAddress to next always
         ip->nextChildAddress = nextAddress;
+        #ifndef NODE_FEATURE_PARENT_SUMMARY
         writeNodeDataBlockToFlash(pAddr, ip);
+        #endif
+    }
+    
+    #ifdef NODE_FEATURE_PARENT_SUMMARY
+    // Update the summary, together with the first child address
+    if (childCount != 0)
+    {
+        childCount--;
+    }
+    if (mruChild == cAddr)
+    {
+        mruChild = NODE_ADDR_NULL;
+    }
+    setParentNodeSummary(ip, childCount, mruChild);
+    writeNodeDataBlockToFlash(pAddr, ip);
+    #endif
+    
+    scanNodeUsage();
+    return RETURN_OK;
+}
+
+#ifdef NODE_FEATURE_BATCH_DELETE
+/**
+ * Finds a node address inside a list of addresses
+ * @param   nodeAddress     The address to look for
+ * @param   nodeAddresses   The list of addresses
+ * @param   nbNodes         Number of addresses in the list
+ * @return  The index in the list, 0xFF if not found
+ */
+static uint8_t nodeIndexInList(uint16_t nodeAddress, uint16_t* nodeAddresses, uint8_t nbNodes)
+{
+    uint8_t i;
+    
+    for (i = 0; i < nbNodes; i++)
+    {
+        if (nodeAddresses[i] == nodeAddress)
+        {
+            return i;
+        }
+    }
+    return 0xFF;
+}
+
+/**
+ * Adds a linked list field update to a list, if not already present
+ * @param   updates         The list of updates
+ * @param   nbUpdates       Pointer to the number of updates in the list
+ * @param   nodeAddress     The node to update
+ * @param   fieldOffset     The field to update
+ * @param   value           The new value
+ */
+static void addNodeFieldUpdate(nodeFieldUpdate_t* updates, uint8_t* nbUpdates, uint16_t nodeAddress, uint8_t fieldOffset, uint16_t value)
+{
+    uint8_t i;
+    
+    // Nodes of a same deleted run give the same updates
+    for (i = 0; i < *nbUpdates; i++)
+    {
+        if ((updates[i].nodeAddress == nodeAddress) && (updates[i].fieldOffset == fieldOffset))
+        {
+            return;
+        }
+    }
+    updates[*nbUpdates].nodeAddress = nodeAddress;
+    updates[*nbUpdates].fieldOffset = fieldOffset;
+    updates[*nbUpdates].value = value;
+    (*nbUpdates)++;
+}
+
+/**
+ * Deletes a list of nodes from memory, unlinking them from their lists.
+ * All the linked list updates are computed first, then applied with one page program per touched flash page.
+ * @param   nodeAddresses   The addresses of the nodes to delete
+ * @param   nbNodes         Number of addresses (NODE_BATCH_DELETE_MAX max)
+ * @return  success status, nothing is written in case of failure
+ * @note    A parent node can only be deleted together with all its children / data nodes
+ * @note    Starting parents, services LUT & free nodes are updated once at the end
+ */
+RET_TYPE deleteNodesBatch(uint16_t* nodeAddresses, uint8_t nbNodes)
+{
+    nodeFieldUpdate_t updates[2*NODE_BATCH_DELETE_MAX];
+    uint16_t newStartingParent = NODE_ADDR_NULL;
+    uint16_t newStartingDataParent = NODE_ADDR_NULL;
+    uint8_t startingParentChanged = FALSE;
+    uint8_t startingDataParentChanged = FALSE;
+    uint16_t prevAddress, nextAddress, headAddress, parentAddress;
+    uint16_t coveredNodes = 0;
+    uint16_t fields[4];
+    uint8_t nbUpdates = 0;
+    uint8_t i, j, index, type, loopCount;
+    uint16_t page;
+    
+    if ((nbNodes == 0) || (nbNodes > NODE_BATCH_DELETE_MAX))
+    {
+        return RETURN_NOK;
+    }
+    
+    // Check the nodes & mark the children of deleted parents
+    for (i = 0; i < nbNodes; i++)
+    {
+        if ((nodeAddresses[i] == NODE_ADDR_NULL) || (checkUserPermission(nodeAddresses[i]) != RETURN_OK))
+        {
+            return RETURN_NOK;
+        }
+        
+        readNodeLinkFields(nodeAddresses[i], fields);
+        if (validBitFromFlags(fields[0]) != NODE_VBIT_VALID)
+        {
+            return RETURN_NOK;
+        }
+        
+        type = nodeTypeFromFlags(fields[0]);
+        if ((type == NODE_TYPE_PARENT) || (type == NODE_TYPE_PARENT_DATA))
+        {
+            // All the parent children must be deleted too
+            nextAddress = fields[3];
+            loopCount = 0;
+            while (nextAddress != NODE_ADDR_NULL)
+            {
+                index = nodeIndexInList(nextAddress, nodeAddresses, nbNodes);
+                if ((index == 0xFF) || (loopCount++ == nbNodes))
+                {
+                    return RETURN_NOK;
+                }
+                coveredNodes |= ((uint16_t)1 << index);
+                readNodeLinkFields(nextAddress, fields);
+                
+                // Data nodes only have a next address field
+                if (type == NODE_TYPE_PARENT)
+                {
+                    nextAddress = fields[2];
+                }
+                else
+                {
+                    nextAddress = fields[1];
+                }
+            }
+        }
+    }
+    
+    // Compute the linked list updates, no flash write until everything was checked
+    for (i = 0; i < nbNodes; i++)
+    {
+        readNodeLinkFields(nodeAddresses[i], fields);
+        type = nodeTypeFromFlags(fields[0]);
+        
+        if ((coveredNodes & ((uint16_t)1 << i)) != 0)
+        {
+            // The whole list is deleted with its parent
+            continue;
+        }
+        else if (type == NODE_TYPE_DATA)
+        {
+            // Data nodes can't be unlinked on their own
+            return RETURN_NOK;
+        }
+        
+        // Find the closest previous node that isn't deleted
+        headAddress = nodeAddresses[i];
+        prevAddress = fields[1];
+        loopCount = 0;
+        while ((prevAddress != NODE_ADDR_NULL) && (nodeIndexInList(prevAddress, nodeAddresses, nbNodes) != 0xFF))
+        {
+            if (loopCount++ == nbNodes)
+            {
+                return RETURN_NOK;
+            }
+            headAddress = prevAddress;
+            readNodeLinkFields(prevAddress, fields);
+            prevAddress = fields[1];
+        }
+        
+        // Find the closest next node that isn't deleted
+        readNodeLinkFields(nodeAddresses[i], fields);
+        nextAddress = fields[2];
+        loopCount = 0;
+        while ((nextAddress != NODE_ADDR_NULL) && (nodeIndexInList(nextAddress, nodeAddresses, nbNodes) != 0xFF))
+        {
+            if (loopCount++ == nbNodes)
+            {
+                return RETURN_NOK;
+            }
+            readNodeLinkFields(nextAddress, fields);
+            nextAddress = fields[2];
+        }
+        
+        if (prevAddress != NODE_ADDR_NULL)
+        {
+            addNodeFieldUpdate(updates, &nbUpdates, prevAddress, NODE_NEXT_ADDR_OFFSET, nextAddress);
+        }
+        else if (type == NODE_TYPE_CHILD)
+        {
+            // First child deleted: find its parent to update its first child address
+            parentAddress = getStartingParentAddress();
+            while (parentAddress != NODE_ADDR_NULL)
+            {
+                readNodeLinkFields(parentAddress, fields);
+                if (fields[3] == headAddress)
+                {
+                    break;
+                }
+                parentAddress = fields[2];
+            }
+            if (parentAddress == NODE_ADDR_NULL)
+            {
+                return RETURN_NOK;
+            }
+            addNodeFieldUpdate(updates, &nbUpdates, parentAddress, NODE_CHILD_ADDR_OFFSET, nextAddress);
+        }
+        else if (type == NODE_TYPE_PARENT)
+        {
+            // First parent deleted: starting parent is updated at the end
+            newStartingParent = nextAddress;
+            startingParentChanged = TRUE;
+        }
+        else
+        {
+            newStartingDataParent = nextAddress;
+            startingDataParentChanged = TRUE;
+        }
+        
+        if (nextAddress != NODE_ADDR_NULL)
+        {
+            addNodeFieldUpdate(updates, &nbUpdates, nextAddress, NODE_PREV_ADDR_OFFSET, prevAddress);
+        }
+    }
+    
+    // Node erasing buffer
+    memset((void*)&currentNodeMgmtHandle.tempgNode, DELETE_POLICY_WRITE_ONES, NODE_SIZE);
+    
+    // Apply the erases & updates, one page program per touched page
+    for (i = 0; i < nbNodes + nbUpdates; i++)
+    {
+        if (i < nbNodes)
+        {
+            page = pageNumberFromAddress(nodeAddresses[i]);
+        }
+        else
+        {
+            page = pageNumberFromAddress(updates[i - nbNodes].nodeAddress);
+        }
+        
+        // Check that this page wasn't already programmed
+        for (j = 0; j < i; j++)
+        {
+            if (((j < nbNodes) && (pageNumberFromAddress(nodeAddresses[j]) == page)) || ((j >= nbNodes) && (pageNumberFromAddress(updates[j - nbNodes].nodeAddress) == page)))
+            {
+                break;
+            }
+        }
+        if (j != i)
+        {
+            continue;
+        }
+        
+        loadPageToInternalBuffer(page);
+        for (j = 0; j < nbNodes; j++)
+        {
+            if (pageNumberFromAddress(nodeAddresses[j]) == page)
+            {
+                flashWriteBuffer((uint8_t*)&currentNodeMgmtHandle.tempgNode, NODE_SIZE * nodeNumberFromAddress(nodeAddresses[j]), NODE_SIZE);
+            }
+        }
+        for (j = 0; j < nbUpdates; j++)
+        {
+            if (pageNumberFromAddress(updates[j].nodeAddress) == page)
+            {
+                flashWriteBuffer((uint8_t*)&updates[j].value, NODE_SIZE * nodeNumberFromAddress(updates[j].nodeAddress) + updates[j].fieldOffset, sizeof(updates[j].value));
+            }
+        }
+        flashWriteBufferToPage(page);
+    }
+    
+    // Update user profile once
+    if (startingParentChanged != FALSE)
+    {
+        setStartingParent(newStartingParent);
+    }
+    if (startingDataParentChanged != FALSE)
+    {
+        setDataStartingParent(newStartingDataParent);
     }
     
+    populateServicesLut();
     scanNodeUsage();
     return RETURN_OK;
 }
+#endif
 
 /**
  * Updates the password field of a given child node
@@ -48,6 +48,11 @@ typedef enum _nodeType
 #define NODE_SIZE   132
 
 #define NODE_ADDR_NULL 0x0000
+
+// Number of nodes kept in the node cache (NODE_FEATURE_NODE_CACHE), each entry takes NODE_SIZE + 3 bytes of SRAM
+#define NODE_CACHE_NB_ENTRIES 2
+// Maximum number of logins in a service ordered by last use (NODE_FEATURE_LOGIN_USAGE_ORDER), each taking 2 bytes of SRAM
+#define LOGIN_ORDER_MAX_CHILDREN 16
 #define NODE_VBIT_VALID 0
 #define NODE_VBIT_INVALID 1
 
@@ -69,8 +74,14 @@ typedef enum _nodeType
 
 #define NODE_F_CHILD_USERFLAGS_MASK 0x00ff // reserved bits in child node left available to user data (credential charset)
 
+#define NODE_F_PARENT_TYPING_DELAY_MASK 0x00f0 // reserved bits in parent node used for the service keyboard typing delay profile
+#define NODE_F_PARENT_TYPING_DELAY_SHMT 4
+#define NODE_F_PARENT_TYPING_DELAY_MASK_FINAL 0x000f
+
 #define NODE_F_DATA_SEQ_NUM_MASK 0x00ff
 
+#define NODE_F_DATA_PARENT_COMPRESSED_MASK 0x0001 // credential type bit 0 in data parent nodes, set when the host compressed the stored data
+
 #define NODE_ADDR_SHMT 3
 #define NODE_ADDR_PAGE_MASK 0x1fff
 #define NODE_ADDR_NODE_MASK 0x0007
@@ -101,7 +112,7 @@ typedef enum _nodeType
 - 2B: user data start node
 - 2B: user db change number (1B for cred DB, 1B for data DB)
 - 3B: user CTR
-- 1B: reserved
+- 1B: USER_NODES_FORMAT_KEY when the parent node summaries are up to date, USER_SUMMARIES_STALE_KEY when they need a refresh, any other value for databases from older firmwares
 */
 #define USER_START_NODE_SIZE 2
 #define USER_FAV_SIZE 4
@@ -111,6 +122,8 @@ typedef enum _nodeType
 #define USER_RES_CTR 4
 #define USER_PROFILE_SIZE (USER_START_NODE_SIZE + (USER_MAX_FAV*USER_FAV_SIZE) + USER_DATA_START_NODE_SIZE + USER_DB_CHANGE_NB_SIZE + USER_RES_CTR)
 #define USER_CTR_SIZE 3             // USER_RES_CTR is set to 4 but the actual CTR is 3 bytes long and the last byte is reserved for later
+#define USER_SUMMARIES_STALE_KEY 0xA5   // Set in the last user profile byte while nodes written in memory management mode may have left summaries stale
+#define USER_NODES_FORMAT_KEY 0x3C      // Set in the last user profile byte once all the parent node summaries were written by this firmware
 
 #define GRAPHIC_ZONE_START          (8*BYTES_PER_PAGE)
 #define GRAPHIC_ZONE_PAGE_START     (8)
@@ -122,6 +135,46 @@ typedef enum _nodeType
 // flags, prev & nextaddress bytes length
 #define FLAGS_PREV_NEXT_ADDR_LENGTH 6
 
+// Offsets of the linked list fields inside a node
+#define NODE_PREV_ADDR_OFFSET       2
+#define NODE_NEXT_ADDR_OFFSET       4
+#define NODE_CHILD_ADDR_OFFSET      6
+
+// Maximum number of nodes deleted by deleteNodesBatch()
+#define NODE_BATCH_DELETE_MAX       16
+
+// Maximum number of pages scanned by getUserNodesTopology() per call
+#define NODE_TOPOLOGY_MAX_PAGES     16
+
+// Credential parent node summary, stored in the service field tail (never used for sorting/comparisons)
+// service[116] -> number of children, service[117..118] -> most recently used child, service[119] -> check byte
+#define PNODE_SUMMARY_SERVICE_OFFSET    116
+#define PNODE_SUMMARY_CHECK_KEY         0x5A
+
+// Credential parent node compare key, stored in the service field tail
+// service[107..112] -> service name prefix, service[113..114] -> service name hash, service[115] -> check byte
+#define PNODE_COMPARE_KEY_SERVICE_OFFSET    107
+#define PNODE_COMPARE_KEY_PREFIX_LENGTH     6
+#define PNODE_COMPARE_KEY_LENGTH            9
+#define PNODE_COMPARE_KEY_CHECK_KEY         0xA5
+
+// Credential parent node service alias, stored in the service field tail (service names are at most NODE_PARENT_SIZE_OF_SERVICE long)
+// service[102..103] -> canonical parent node address, service[104..105] -> canonical service name hash, service[106] -> check byte
+#define PNODE_ALIAS_SERVICE_OFFSET          102
+#define PNODE_ALIAS_LENGTH                  5
+#define PNODE_ALIAS_CHECK_KEY               0xC3
+
+// compareServiceWithParentNode() result when the names differ but their order isn't known
+#define SERVICE_COMPARE_UNORDERED           2
+
+// Predictive service search: bitmap of the printable characters (' ' to '~') following a prefix
+#define SERVICE_CHAR_BITMAP_FIRST_CHAR      ' '
+#define SERVICE_CHAR_BITMAP_LAST_CHAR       '~'
+#define SERVICE_CHAR_BITMAP_SIZE            12
+#define SERVICE_PREDICTION_MAX_PREFIX       20
+#define SERVICE_PREDICTION_MAX_SCAN         32
+#define IS_SERVICE_CHAR_IN_BITMAP(bitmap, c)    (((c) >= SERVICE_CHAR_BITMAP_FIRST_CHAR) && ((c) <= SERVICE_CHAR_BITMAP_LAST_CHAR) && ((bitmap)[((c) - SERVICE_CHAR_BITMAP_FIRST_CHAR) >> 3] & (1 << (((c) - SERVICE_CHAR_BITMAP_FIRST_CHAR) & 0x07))))
+
 /*!
 * Struct containing a generic node
 */
@@ -145,8 +198,9 @@ typedef struct __attribute__((packed)) parentNode {
                                     * 15 dn 14-> Node type (Always 00 for Parent Node)
                                     * 13 dn 13 -> Valid Bit
                                     * 12 dn 8 -> User ID
-                                    * 7 dn 4 -> RESERVED
-                                    * 3 dn0 -> credential type UID
+                                    * 7 dn 4 -> Keyboard typing delay profile (0 for the device wide setting)
+                                    * 3 dn0 -> credential type UID for credential parents
+                                    *          Data parents: bit 0 set when the host compressed the stored data, 3 dn 1 unused
                                     */
     uint16_t prevParentAddress;     /*!< Previous parent node address (Alphabetically) */
     uint16_t nextParentAddress;     /*!< Next parent node address (Alphabetically) */
@@ -196,6 +250,25 @@ typedef struct __attribute__((packed)) childNode {
 #define CNODE_COMPARISON_FIELD_OFFSET   37
 #define CNODE_LIB_FIELDS_LENGTH         6
 
+/*!
+* Struct containing a linked list field update, used by batched node deletion
+*/
+typedef struct __attribute__((packed)) nodeFieldUpdate {
+    uint16_t nodeAddress;           /*!< Address of the node to update */
+    uint8_t fieldOffset;            /*!< Offset of the 2 bytes field inside the node */
+    uint16_t value;                 /*!< New field value */
+} nodeFieldUpdate_t;
+
+/*!
+* Struct containing the compact description of a node, used to dump the user database topology
+*/
+typedef struct __attribute__((packed)) nodeTopology {
+    uint16_t nodeAddress;           /*!< Address of the node */
+    uint16_t flags;                 /*!< Node flags (type, user id...) */
+    uint16_t links[3];              /*!< The 3 fields following the flags: prev / next / first child addresses for parents, prev / next addresses for children, next address for data nodes */
+    uint32_t digest;                /*!< CRC32 of the complete node, as computed by crc32_update() */
+} nodeTopology_t;
+
 #define DATA_NODE_DATA_LENGTH           128
 
 /*!
@@ -232,6 +305,9 @@ typedef struct __attribute__((packed)) nodeMgmtH
     uint16_t nextFreeNode;          /*!< The address of the next free node */
     gNode tempgNode;                /*!< A generic node to be used as a buffer */
     uint16_t servicesLut[26];       /*!<Look up table for our services */
+    #ifdef NODE_FEATURE_DATA_SERVICES_LUT
+    uint16_t dataServicesLut[26];   /*!<Look up table for our data services */
+    #endif
 } mgmtHandle;
 
 /**
@@ -315,7 +391,11 @@ uint16_t getLastParentAddress(void);
 
 void getPreviousNextFirstLetterForGivenLetter(char c, char* array, uint16_t* parent_addresses);
 uint16_t getParentNodeForLetter(uint8_t letter);
+uint16_t getDataParentNodeForLetter(uint8_t letter);
 void populateServicesLut(void);
+void insertServiceInServicesLut(pNode* p, uint16_t pAddr);
+void insertServiceInDataServicesLut(pNode* p, uint16_t pAddr);
+uint16_t getServiceNextCharacters(uint8_t* prefix, uint8_t prefix_length, uint8_t buffer_length, uint8_t* char_bitmap);
 
 void setFav(uint8_t favId, uint16_t parentAddress, uint16_t childAddress);
 void readFav(uint8_t favId, uint16_t *parentAddress, uint16_t *childAddress);
@@ -330,17 +410,32 @@ RET_TYPE createParentNode(pNode* p, uint8_t type);
 void readParentNode(pNode *p, uint16_t parentNodeAddress);
 RET_TYPE updateParentNode(pNode *p, uint16_t parentNodeAddress);
 RET_TYPE deleteParentNode(uint16_t parentNodeAddress);
+RET_TYPE updateParentNodeTypingDelay(pNode* p, uint16_t pAddr, uint8_t delay_profile);
+uint8_t getParentNodeChildCount(pNode* p);
+uint16_t getParentNodeMruChild(pNode* p, uint16_t pAddr);
+void setParentNodeMruChild(uint16_t pAddr, uint16_t cAddr);
+void markParentNodesSummariesStale(void);
+void refreshParentNodesSummaries(void);
+uint8_t getParentNodeLoginOrder(pNode* p, uint16_t pAddr, uint16_t** order);
+uint16_t serviceNameHash(uint8_t* name);
+int8_t compareServiceWithParentNode(uint8_t* name, uint16_t nameHash, uint16_t parentNodeAddress, uint16_t* nextParentAddress, uint8_t mode);
+void setParentNodeAlias(pNode* p, uint16_t canonicalAddr);
+uint16_t getParentNodeAliasTarget(pNode* p);
+uint16_t resolveServiceAlias(uint16_t pAddr);
 void deleteDataNodeChain(uint16_t dataNodeAddress, dNode* data_node_ptr);
 
 RET_TYPE createChildNode(uint16_t pAddr, cNode *c);
 RET_TYPE createChildStartOfDataNode(uint16_t pAddr, cNode *c, uint8_t dataNodeCount);
 void readChildNode(cNode *c, uint16_t childNodeAddress);
+void readChildNodeNoDateUpdate(cNode *c, uint16_t childNodeAddress);
 RET_TYPE updateChildNode(pNode *p, cNode *c, uint16_t pAddr, uint16_t cAddr);
 RET_TYPE deleteChildNode(uint16_t pAddr, uint16_t cAddr, cNode *ic);
+RET_TYPE deleteNodesBatch(uint16_t* nodeAddresses, uint8_t nbNodes);
 
 void readNode(gNode* g, uint16_t nodeAddress);
 
 uint8_t findFreeNodes(uint8_t nbNodes, uint16_t* nodeArray, uint16_t startPage, uint8_t startNode);
+uint8_t getUserNodesTopology(uint8_t nbNodes, nodeTopology_t* nodeArray, uint16_t* scanAddress);
 RET_TYPE updateChildNodePassword(cNode* c, uint16_t cAddr, uint8_t* password, uint8_t* ctr_value);
 RET_TYPE updateChildNodeDescription(cNode* c, uint16_t cAddr, uint8_t* description);
 void setProfileUserDbChangeNumber(void *buf);
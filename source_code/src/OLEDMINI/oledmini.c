@@ -775,6 +775,72 @@ void miniOledBitmapDrawRaw(int8_t x, uint8_t y, bitstream_mini_t* bs)
     }  
 }
 
+#ifdef MINI_FEATURE_NATIVE_BITMAPS
+/*! \fn     miniOledBitmapDrawNative(int8_t x, uint8_t y, bitmap_t* bitmap, uint16_t addr)
+ *  \brief  Copy a bitmap stored in the frame buffer layout to the frame buffer
+ *  \param  x       x position for the bitmap
+ *  \param  y       y position for the bitmap (0=top, 31=bottom)
+ *  \param  bitmap  pointer to the bitmap header
+ *  \param  addr    address of the pixel data in flash
+ *  \note   Whole pages are written: the bundle tool only stores bitmaps with a height multiple of 8 in this layout
+ */
+static void miniOledBitmapDrawNative(int8_t x, uint8_t y, bitmap_t* bitmap, uint16_t addr)
+{
+    uint8_t start_ypixel = miniOledBufferYOffset + y;
+    uint8_t data_lbitshift = start_ypixel & 0x07;
+    uint8_t page = start_ypixel >> SSD1305_PAGE_HEIGHT_BIT_SHIFT;
+    uint8_t nb_pages = (bitmap->height + 7) >> SSD1305_PAGE_HEIGHT_BIT_SHIFT;
+    uint8_t width = bitmap->width;
+    uint8_t pixels[BITSTREAM_BUFFER_SIZE];
+    
+    // Check if x is < 0, skip the columns out of the screen
+    if (x < 0)
+    {
+        if ((uint8_t)(-x) >= width)
+        {
+            return;
+        }
+        width -= (uint8_t)(-x);
+        addr += (uint8_t)(-x);
+        x = 0;
+    }
+    
+    // Clip to the screen width
+    if (width > SSD1305_OLED_WIDTH - x)
+    {
+        width = SSD1305_OLED_WIDTH - x;
+    }
+    
+    while (nb_pages--)
+    {
+        uint8_t* cur_line = &miniOledFrameBuffer[((uint16_t)(page % SSD1305_OLED_BUFFER_PAGE_HEIGHT) << SSD1305_WIDTH_BIT_SHIFT) + x];
+        
+        if (data_lbitshift == 0)
+        {
+            // Page aligned: the page is copied as it is
+            flashRawRead(cur_line, addr, width);
+        }
+        else
+        {
+            // Otherwise each byte is split over two frame buffer pages
+            uint8_t* next_line = &miniOledFrameBuffer[((uint16_t)((page + 1) % SSD1305_OLED_BUFFER_PAGE_HEIGHT) << SSD1305_WIDTH_BIT_SHIFT) + x];
+            for (uint8_t i = 0; i < width; i++)
+            {
+                if ((i % sizeof(pixels)) == 0)
+                {
+                    flashRawRead(pixels, addr + i, sizeof(pixels));
+                }
+                cur_line[i] = (cur_line[i] & (0xFF >> (8 - data_lbitshift))) | (pixels[i % sizeof(pixels)] << data_lbitshift);
+                next_line[i] = (next_line[i] & (0xFF << data_lbitshift)) | (pixels[i % sizeof(pixels)] >> (8 - data_lbitshift));
+            }
+        }
+        
+        addr += bitmap->width;
+        page++;
+    }
+}
+#endif
+
 /*! \fn     miniOledBitmapDrawFlash(uint8_t x, int8_t y, uint8_t fileId, uint8_t options)
  *  \brief  Draw a bitmap from a Flash storage slot
  *  \param  x       x position for the bitmap
@@ -804,15 +870,20 @@ void miniOledBitmapDrawFlash(int8_t x, int8_t y, uint8_t fileId, uint8_t options
     miniBistreamInit(&bs, bitmap.height, bitmap.width, addr+sizeof(bitmap));
     
     // Draw the bitmap
-    if (y >= 0)
+    if (y < 0)
     {
-        miniOledBitmapDrawRaw(x, y, &bs);
+        miniOledScreenYOffset = (miniOledScreenYOffset - y) & SSD1305_Y_BUFFER_HEIGHT_BITMASK;
+        miniOledBufferYOffset = (miniOledBufferYOffset - y) & SSD1305_OLED_HEIGHT_BITMASK;      // TODO: fix this line!
+    }
+    #ifdef MINI_FEATURE_NATIVE_BITMAPS
+    if ((bitmap.flags & MINI_BITMAP_FLAG_NATIVE) != 0)
+    {
+        miniOledBitmapDrawNative(x, (y >= 0) ? y : 0, &bitmap, addr+sizeof(bitmap));
     }
     else
+    #endif
     {
-        miniOledScreenYOffset = (miniOledScreenYOffset - y) & SSD1305_Y_BUFFER_HEIGHT_BITMASK;
-        miniOledBufferYOffset = (miniOledBufferYOffset - y) & SSD1305_OLED_HEIGHT_BITMASK;      // TODO: fix this line!
-        miniOledBitmapDrawRaw(x, 0, &bs);
+        miniOledBitmapDrawRaw(x, (y >= 0) ? y : 0, &bs);
     }
 
     // If we're asked to scroll or flip
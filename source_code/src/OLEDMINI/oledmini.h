@@ -84,6 +84,9 @@
 #define SSD1305_TOTAL_PAGE_HEIGHT                   8           // 8 pages is one screen buffer height
 #define SSD1305_TOTAL_PAGE_HEIGHT_BITMASK           0x07        // Bitmask for 8
 
+/** DEFINES BITMAPS **/
+#define MINI_BITMAP_FLAG_NATIVE                     0x80        // Pixel data in the frame buffer layout: page by page, one byte per column, LSB at the top
+
 /** ONE LINE FUNCTIONS **/
 #define miniOledNormalDisplay()                     miniOledWriteSimpleCommand(SSD1305_CMD_ENTIRE_DISPLAY_NREVERSED)
 #define miniOledInvertedDisplay()                   miniOledWriteSimpleCommand(SSD1305_CMD_ENTIRE_DISPLAY_REVERSED)
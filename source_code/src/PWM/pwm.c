@@ -70,5 +70,19 @@ void setPwmDc(uint16_t pwm_value)
         OCR3A = ~pwm_value;
     #endif
 }
+
+/*! \fn     getPwmDc(void)
+*   \brief  Read back the PWM duty cycle from the timer compare register
+*   \return The duty cycle
+*/
+uint16_t getPwmDc(void)
+{
+    #if defined(HARDWARE_OLIVIER_V1)
+        uint8_t temp_low = OCR4A;
+        return (~(((uint16_t)TC4H << 8) | temp_low)) & MAX_PWM_VAL;
+    #elif defined(LEDS_ENABLED_MINI)
+        return ~OCR3A;
+    #endif
+}
 #endif
 /***************************************************************/
\ No newline at end of file
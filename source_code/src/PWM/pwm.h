@@ -11,6 +11,7 @@
 
 // Prototypes
 void setPwmDc(uint16_t pwm_value);
+uint16_t getPwmDc(void);
 void initPwm(void);
 
 // Defines
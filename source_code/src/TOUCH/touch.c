@@ -23,12 +23,26 @@
  */
 #include "touch_higher_level_functions.h"
 #include "defines.h"
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/delay.h>
 #include <avr/io.h>
 #include "touch.h"
 /***************************************************************/
 /*  This file is only used for the Mooltipass standard version */
 #if defined(HARDWARE_OLIVIER_V1)
 
+#ifdef TOUCH_FEATURE_TWI_INTERRUPT
+// Transactions queued by the main loop, processed by the TWI interrupt
+static twiTransaction_t twi_queue[TWI_QUEUE_SIZE];
+// Index of the transaction currently processed by the interrupt
+static volatile uint8_t twi_queue_tail = 0;
+// Index of the next free slot in the queue
+static volatile uint8_t twi_queue_head = 0;
+// Set once the data byte of the current write transaction was sent
+static volatile uint8_t twi_data_sent;
+#endif
+
 
 /*! \fn     waitForTwintFlag(void)
 *   \brief  Wait for TWINT flag, indicating that current task is finished
@@ -118,6 +132,35 @@ static inline RET_TYPE isDataSendingOk(void)
     }
 }
 
+#ifdef TOUCH_FEATURE_TWI_INTERRUPT
+/*! \fn     touchWaitForQueueIdle(void)
+*   \brief  Wait for the background transactions to finish, reset the TWI if they don't
+*   \return RETURN_OK, or RETURN_NOK if the queue was dropped (touch controller not answering, bus stuck low)
+*/
+static RET_TYPE touchWaitForQueueIdle(void)
+{
+    uint16_t nb_loops = 0;
+
+    while (touchIsQueueIdle() == FALSE)
+    {
+        if (nb_loops++ == TWI_QUEUE_TIMEOUT_LOOPS)
+        {
+            // Disable the TWI to release the bus, drop the queued transactions
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                TWCR = 0;
+                twi_queue_tail = twi_queue_head;
+            }
+            clear_twint_flag();
+            return RETURN_NOK;
+        }
+        _delay_us(10);
+    }
+
+    return RETURN_OK;
+}
+#endif
+
 /*! \fn     initiateI2cWrite(uint8_t addr, uint8_t reg)
 *   \brief  Initiate a write process in the at42qt2120
 *   \param  addr        The chip address
@@ -166,6 +209,14 @@ RET_TYPE writeDataToTS(uint8_t reg, uint8_t data)
 {
     RET_TYPE ret_val;
 
+    #ifdef TOUCH_FEATURE_TWI_INTERRUPT
+    // Let the background transactions finish, the TWI interrupt is then disabled
+    if (touchWaitForQueueIdle() != RETURN_OK)
+    {
+        return RETURN_NOK;
+    }
+    #endif
+
     ret_val = initiateI2cWrite(AT42QT2120_ADDR, reg);
     if(ret_val != RETURN_OK)
     {
@@ -231,6 +282,14 @@ RET_TYPE readDataFromTS(uint8_t reg, uint8_t* data)
 {
     RET_TYPE ret_val;
 
+    #ifdef TOUCH_FEATURE_TWI_INTERRUPT
+    // Let the background transactions finish, the TWI interrupt is then disabled
+    if (touchWaitForQueueIdle() != RETURN_OK)
+    {
+        return RETURN_NOK;
+    }
+    #endif
+
     ret_val = initiateI2cRead(AT42QT2120_ADDR, reg);
     if(ret_val != RETURN_OK)
     {
@@ -259,5 +318,159 @@ void initI2cPort(void)
     TWBR = 3;                               // IC freq = 16Mhz / (16 + 2*TWBR*4^TWPS) = 400KHz
     clear_twint_flag();                     // Init IC controller
 }
+
+#ifdef TOUCH_FEATURE_TWI_INTERRUPT
+/*! \fn     ISR(TWI_vect)
+*   \brief  TWI state machine processing the transaction queue
+*/
+ISR(TWI_vect)
+{
+    twiTransaction_t* cur_transaction = &twi_queue[twi_queue_tail];
+
+    switch(TWSR & 0xF8)
+    {
+        case I2C_START:
+        {
+            // New transaction: send chip address (write mode)
+            twi_data_sent = FALSE;
+            TWDR = AT42QT2120_ADDR;
+            clear_twint_flag_irq();
+            return;
+        }
+        case I2C_SLA_ACK:
+        {
+            // Send register address
+            TWDR = cur_transaction->reg;
+            clear_twint_flag_irq();
+            return;
+        }
+        case I2C_DATA_ACK:
+        {
+            if (cur_transaction->read_dest != 0)
+            {
+                // Register address sent, restart in reading mode
+                start_condition_irq();
+                return;
+            }
+            else if (twi_data_sent == FALSE)
+            {
+                // Register address sent, send data byte
+                twi_data_sent = TRUE;
+                TWDR = cur_transaction->data;
+                clear_twint_flag_irq();
+                return;
+            }
+            // Data byte sent, transaction done
+            break;
+        }
+        case I2C_RSTART:
+        {
+            // Send chip address (read mode)
+            TWDR = AT42QT2120_ADDR | 0x01;
+            clear_twint_flag_irq();
+            return;
+        }
+        case I2C_SLAR_ACK:
+        {
+            // Receive one byte, answer with a NACK
+            clear_twint_flag_irq();
+            return;
+        }
+        case I2C_DATAR_NACK:
+        {
+            // Byte received, transaction done
+            *(cur_transaction->read_dest) = TWDR;
+            break;
+        }
+        default:
+        {
+            // Bus error: the transaction is dropped
+            break;
+        }
+    }
+
+    // Move on to the next transaction if there's one, otherwise release the bus
+    twi_queue_tail = (twi_queue_tail + 1) & (TWI_QUEUE_SIZE - 1);
+    if (twi_queue_tail != twi_queue_head)
+    {
+        stop_start_condition_irq();
+    }
+    else
+    {
+        stop_condition();
+    }
+}
+
+/*! \fn     touchQueueTransaction(uint8_t reg, uint8_t data, uint8_t* read_dest)
+*   \brief  Add a transaction to the background queue
+*   \param  reg         The register address
+*   \param  data        The data to write (write transaction)
+*   \param  read_dest   Where to store the read byte, 0 for a write transaction
+*   \return RETURN_OK or RETURN_NOK if the queue is full
+*/
+static RET_TYPE touchQueueTransaction(uint8_t reg, uint8_t data, uint8_t* read_dest)
+{
+    uint8_t next_head = (twi_queue_head + 1) & (TWI_QUEUE_SIZE - 1);
+    RET_TYPE ret_val = RETURN_NOK;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (next_head != twi_queue_tail)
+        {
+            twi_queue[twi_queue_head].reg = reg;
+            twi_queue[twi_queue_head].data = data;
+            twi_queue[twi_queue_head].read_dest = read_dest;
+
+            // Start the state machine if it was idle
+            if (twi_queue_head == twi_queue_tail)
+            {
+                start_condition_irq();
+            }
+            twi_queue_head = next_head;
+            ret_val = RETURN_OK;
+        }
+    }
+
+    return ret_val;
+}
+
+/*! \fn     touchQueueRead(uint8_t reg, uint8_t* data)
+*   \brief  Queue a background read of an AT42QT2120 register
+*   \param  reg         The register address
+*   \param  data        Where the byte will be stored, must stay valid until the queue is idle
+*   \return RETURN_OK or RETURN_NOK if the queue is full
+*/
+RET_TYPE touchQueueRead(uint8_t reg, uint8_t* data)
+{
+    return touchQueueTransaction(reg, 0, data);
+}
+
+/*! \fn     touchQueueWrite(uint8_t reg, uint8_t data)
+*   \brief  Queue a background write of an AT42QT2120 register
+*   \param  reg         The register address
+*   \param  data        The data to write
+*   \return RETURN_OK or RETURN_NOK if the queue is full
+*/
+RET_TYPE touchQueueWrite(uint8_t reg, uint8_t data)
+{
+    return touchQueueTransaction(reg, data, 0);
+}
+
+/*! \fn     touchIsQueueIdle(void)
+*   \brief  Know if all queued transactions were processed
+*   \return TRUE or FALSE
+*/
+uint8_t touchIsQueueIdle(void)
+{
+    if (twi_queue_head == twi_queue_tail)
+    {
+        return TRUE;
+    }
+    else
+    {
+        return FALSE;
+    }
+}
+#endif
 #endif
 /***************************************************************/
\ No newline at end of file
@@ -32,6 +32,23 @@
 RET_TYPE readDataFromTS(uint8_t reg, uint8_t* data);
 RET_TYPE writeDataToTS(uint8_t reg, uint8_t data);
 void initI2cPort(void);
+#ifdef TOUCH_FEATURE_TWI_INTERRUPT
+RET_TYPE touchQueueRead(uint8_t reg, uint8_t* data);
+RET_TYPE touchQueueWrite(uint8_t reg, uint8_t data);
+uint8_t touchIsQueueIdle(void);
+#endif
+
+// Structs
+typedef struct
+{
+    uint8_t reg;
+    uint8_t data;
+    uint8_t* read_dest;
+} twiTransaction_t;
+
+/** Background transaction queue defines **/
+#define TWI_QUEUE_SIZE      8       // Must be a power of 2, one slot is always kept empty
+#define TWI_QUEUE_TIMEOUT_LOOPS 500 // 10us loops waiting for the queue to empty (5ms), a full queue takes less than 1ms at 400KHz
 
 /** I2C controller defines **/
 #define I2C_START		    0x08
@@ -74,4 +91,19 @@ void initI2cPort(void);
 */
 #define acknowledge_data()      (TWCR = (1<<TWINT) | (1<<TWEN) | (1 << TWEA))
 
+/*! \fn     start_condition_irq()
+*   \brief  Generate start condition, TWI interrupt enabled
+*/
+#define start_condition_irq()   (TWCR = (1<<TWINT)|(1<<TWSTA)|(1<<TWEN)|(1<<TWIE))
+
+/*! \fn     stop_start_condition_irq()
+*   \brief  Generate stop condition followed by a start condition, TWI interrupt enabled
+*/
+#define stop_start_condition_irq()  (TWCR = (1<<TWINT)|(1<<TWSTO)|(1<<TWSTA)|(1<<TWEN)|(1<<TWIE))
+
+/*! \fn     clear_twint_flag_irq()
+*   \brief  Clear TWINT flag, TWI interrupt enabled
+*/
+#define clear_twint_flag_irq()  (TWCR = (1<<TWINT)|(1<<TWEN)|(1<<TWIE))
+
 #endif /* TOUCH_H_ */
\ No newline at end of file
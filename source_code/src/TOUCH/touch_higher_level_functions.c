@@ -39,10 +39,22 @@ uint8_t last_raw_wheel_position;
 uint8_t touch_inhibit = FALSE;
 // Last LED mask
 uint8_t last_led_mask;
+#ifdef TOUCH_FEATURE_TWI_INTERRUPT
+// Status registers read in the background: DET_STAT, KEY_STAT1, SLIDER_POS, KEY_STAT2
+static uint8_t touch_status_regs[4];
+// Set when the status registers reads were queued
+static uint8_t touch_status_pending = FALSE;
+// Set when detections should be cleared once the LEDs settled
+static uint8_t touch_clear_pending = FALSE;
+// LED writes go through the background queue
+#define touchLedWrite(reg, val)     touchQueueWrite(reg, val)
+#else
+#define touchLedWrite(reg, val)     writeDataToTS(reg, val)
+#endif
 // Touch sensing init
 static const uint8_t touch_init[] __attribute__((__progmem__)) = 
 {
-    REG_AT42QT_LP,          1,                                                  // Perform measurements every 16ms
+    REG_AT42QT_LP,          AT42QT2120_LP_16MS_VAL,                             // Perform measurements every 16ms
     REG_AT42QT_KEY4_CTRL,   AT42QT2120_OUTPUT_H_VAL,                            // LED (top right)
     REG_AT42QT_KEY5_CTRL,   AT42QT2120_OUTPUT_H_VAL,                            // LED (right button)
     REG_AT42QT_KEY6_CTRL,   AT42QT2120_OUTPUT_H_VAL,                            // LED (bottom right)
@@ -112,6 +124,24 @@ void activateProxDetection(void)
     launchCalibrationCycle();
 }
 
+#ifdef USB_FEATURE_SUSPEND_POWER_DOWN
+/*! \fn     touchSensingSleep(void)
+*   \brief  Stop the AT42QT2120 measurements, the chip then goes to its sleep mode
+*/
+void touchSensingSleep(void)
+{
+    writeDataToTS(REG_AT42QT_LP, AT42QT2120_LP_SLEEP_VAL);
+}
+
+/*! \fn     touchSensingWakeUp(void)
+*   \brief  Resume the AT42QT2120 measurements
+*/
+void touchSensingWakeUp(void)
+{
+    writeDataToTS(REG_AT42QT_LP, AT42QT2120_LP_16MS_VAL);
+}
+#endif
+
 /*! \fn     initTouchSensing()
 *   \brief  Initialize AT42QT2120
 */
@@ -216,8 +246,9 @@ void touchInhibitUntilRelease(void)
 RET_TYPE touchDetectionRoutine(uint8_t led_mask)
 {
     RET_TYPE return_val = RETURN_NO_CHANGE;
-    uint8_t keys_detection_status;
+    uint8_t keys_detection_status = 0;
     uint8_t led_states[NB_KEYS];
+    uint8_t keys_status2 = 0;
     uint8_t temp_bool = FALSE;
     uint8_t temp_uint;
     
@@ -233,6 +264,52 @@ RET_TYPE touchDetectionRoutine(uint8_t led_mask)
         }
     }
     
+    #ifdef TOUCH_FEATURE_TWI_INTERRUPT
+    // Background transactions still running: nothing new to report
+    if (touchIsQueueIdle() == FALSE)
+    {
+        return RETURN_NO_CHANGE;
+    }
+    
+    if (touch_clear_pending == TRUE)
+    {
+        // In some rare cases LED state changes can create detections, which we discard once the LEDs settled
+        if (hasTimerExpired(TIMER_TOUCH_SETTLE, TRUE) == TIMER_RUNNING)
+        {
+            return RETURN_NO_CHANGE;
+        }
+        touch_clear_pending = FALSE;
+        touchQueueRead(REG_AT42QT_SLIDER_POS, &touch_status_regs[2]);
+        touchQueueRead(REG_AT42QT_DET_STAT, &touch_status_regs[0]);
+        touchQueueRead(REG_AT42QT_KEY_STAT1, &touch_status_regs[1]);
+        touchQueueRead(REG_AT42QT_KEY_STAT2, &touch_status_regs[3]);
+        return RETURN_NO_CHANGE;
+    }
+    
+    if (touch_status_pending == TRUE)
+    {
+        // Status registers read in the background are available
+        touch_status_pending = FALSE;
+        temp_bool = TRUE;
+        keys_detection_status = touch_status_regs[0];
+        if (keys_detection_status & AT42QT2120_SDET_MASK)
+        {
+            last_raw_wheel_position = touch_status_regs[2];
+        }
+        keys_status2 = touch_status_regs[3];
+    }
+    else if (isTouchChangeDetected())
+    {
+        // Queue the status registers reads (KEY_STAT1 & SLIDER_POS need to be read to clear the change line), results are consumed by a later call
+        memset((void*)touch_status_regs, 0x00, sizeof(touch_status_regs));
+        touchQueueRead(REG_AT42QT_DET_STAT, &touch_status_regs[0]);
+        touchQueueRead(REG_AT42QT_KEY_STAT1, &touch_status_regs[1]);
+        touchQueueRead(REG_AT42QT_SLIDER_POS, &touch_status_regs[2]);
+        touchQueueRead(REG_AT42QT_KEY_STAT2, &touch_status_regs[3]);
+        touch_status_pending = TRUE;
+        return RETURN_NO_CHANGE;
+    }
+    #else
     if (isTouchChangeDetected())
     {
         // Set temp bool to TRUE
@@ -244,12 +321,22 @@ RET_TYPE touchDetectionRoutine(uint8_t led_mask)
         // Unused byte that needs to be read        
         readDataFromTS(REG_AT42QT_KEY_STAT1, &temp_uint);
         
-        // If wheel is touched
+        // If wheel is touched, get position and update global var
         if (keys_detection_status & AT42QT2120_SDET_MASK)
         {
-            // Get position and update global var
             readDataFromTS(REG_AT42QT_SLIDER_POS, &last_raw_wheel_position);
-            
+        }
+
+        // Read button touched register
+        readDataFromTS(REG_AT42QT_KEY_STAT2, &keys_status2);
+    }
+    #endif
+    
+    if (temp_bool == TRUE)
+    {        
+        // If wheel is touched
+        if (keys_detection_status & AT42QT2120_SDET_MASK)
+        {
             // Update LED states
             led_states[getWheelTouchDetectionQuarter()] = AT42QT2120_OUTPUT_L_VAL;
             return_val |= RETURN_WHEEL_PRESSED;
@@ -258,21 +345,18 @@ RET_TYPE touchDetectionRoutine(uint8_t led_mask)
         {
             return_val |= RETURN_WHEEL_RELEASED;
         }
-
-        // Read button touched register
-        readDataFromTS(REG_AT42QT_KEY_STAT2, &temp_uint);
         
         // If one button is touched
         if ((keys_detection_status & AT42QT2120_TDET_MASK) && !(keys_detection_status & AT42QT2120_SDET_MASK))
         {
-            if (temp_uint & 0x02)
+            if (keys_status2 & 0x02)
             {
                 // Left button
                 led_states[TOUCHPOS_LEFT] = AT42QT2120_OUTPUT_L_VAL;
                 return_val |= RETURN_LEFT_PRESSED;
                 return_val |= RETURN_RIGHT_RELEASED;
             }
-            else if(temp_uint & 0x08)
+            else if(keys_status2 & 0x08)
             {
                 // Right button
                 led_states[TOUCHPOS_RIGHT] = AT42QT2120_OUTPUT_L_VAL;
@@ -312,15 +396,21 @@ RET_TYPE touchDetectionRoutine(uint8_t led_mask)
     if ((temp_bool == TRUE) || (led_mask != last_led_mask))
     {
         last_led_mask = led_mask;
-        writeDataToTS(LEFT_LED_REGISTER, led_states[TOUCHPOS_LEFT]);
-        writeDataToTS(RIGHT_LED_REGISTER, led_states[TOUCHPOS_RIGHT]);
-        writeDataToTS(WHEEL_TLEFT_LED_REGISTER, led_states[TOUCHPOS_WHEEL_TLEFT]);
-        writeDataToTS(WHEEL_TRIGHT_LED_REGISTER, led_states[TOUCHPOS_WHEEL_TRIGHT]);
-        writeDataToTS(WHEEL_BLEFT_LED_REGISTER, led_states[TOUCHPOS_WHEEL_BLEFT]);
-        writeDataToTS(WHEEL_BRIGHT_LED_REGISTER,  led_states[TOUCHPOS_WHEEL_BRIGHT]);
+        touchLedWrite(LEFT_LED_REGISTER, led_states[TOUCHPOS_LEFT]);
+        touchLedWrite(RIGHT_LED_REGISTER, led_states[TOUCHPOS_RIGHT]);
+        touchLedWrite(WHEEL_TLEFT_LED_REGISTER, led_states[TOUCHPOS_WHEEL_TLEFT]);
+        touchLedWrite(WHEEL_TRIGHT_LED_REGISTER, led_states[TOUCHPOS_WHEEL_TRIGHT]);
+        touchLedWrite(WHEEL_BLEFT_LED_REGISTER, led_states[TOUCHPOS_WHEEL_BLEFT]);
+        touchLedWrite(WHEEL_BRIGHT_LED_REGISTER,  led_states[TOUCHPOS_WHEEL_BRIGHT]);
+        #ifdef TOUCH_FEATURE_TWI_INTERRUPT
+        // In some rare cases LED state changes can create detections. Detections are cleared 2ms later by a following call
+        activateTimer(TIMER_TOUCH_SETTLE, 3);
+        touch_clear_pending = TRUE;
+        #else
         // In some rare cases LED state changes can create detections. In that case we add a small delay
         timerBasedDelayMs(2);
         touchClearCurrentDetections();
+        #endif
     }
     
     return return_val;   
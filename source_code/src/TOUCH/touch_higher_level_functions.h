@@ -30,6 +30,8 @@
 
 // Prototypes
 void activateGuardKey(void);
+void touchSensingSleep(void);
+void touchSensingWakeUp(void);
 RET_TYPE initTouchSensing(void);
 void activateProxDetection(void);
 void launchCalibrationCycle(void);
@@ -52,6 +54,8 @@ RET_TYPE touchDetectionRoutine(uint8_t led_mask);
 #define AT42QT2120_OUTPUT_H_VAL     0x03
 #define AT42QT2120_GUARD_VAL        0x10
 #define AT42QT2120_AKS_GP1_MASK     0x04
+#define AT42QT2120_LP_SLEEP_VAL     0x00
+#define AT42QT2120_LP_16MS_VAL      0x01
 
 // AT42QT2120 registers defines
 #define REG_AT42QT_CHIP_ID          0x00
@@ -28,6 +28,7 @@
 #include "mooltipass.h"
 #include "defines.h"
 #include "usb.h"
+#include <avr/sleep.h>
 #include <string.h>
 #include <stdio.h>
 //#define USB_OLED_DEBUG_COMMS
@@ -65,15 +66,42 @@ static uint8_t keyboard_idle_count = 0;
 // 1=num lock, 2=caps lock, 4=scroll lock, 8=compose, 16=kana
 volatile uint8_t keyboard_leds = 0;
 
+// Delay after each keyboard report, KEYBOARD_DELAY_DEVICE_SETTING to use the eeprom setting
+static uint8_t keyboard_typing_delay = KEYBOARD_DELAY_DEVICE_SETTING;
+
+#ifdef USB_FEATURE_SUSPEND_POWER_DOWN
+// Set when the host suspended the bus, cleared on resume
+static volatile uint8_t usb_suspended = FALSE;
+#endif
+
 // Endpoint configuration table
 static const uint8_t PROGMEM endpoint_config_table[] =
 {
     1, EP_TYPE_INTERRUPT_IN,  EP_SIZE(RAWHID_TX_SIZE) | RAWHID_TX_BUFFER,
     1, EP_TYPE_INTERRUPT_OUT, EP_SIZE(RAWHID_RX_SIZE) | RAWHID_RX_BUFFER,
     1, EP_TYPE_INTERRUPT_IN,  EP_SIZE(KEYBOARD_SIZE) | KEYBOARD_BUFFER,
+#if defined(USB_FEATURE_MGMT_BULK)
+    1, EP_TYPE_BULK_IN,       EP_SIZE(RAWHID_TX_SIZE) | RAWHID_TX_BUFFER,
+    1, EP_TYPE_BULK_OUT,      EP_SIZE(RAWHID_RX_SIZE) | RAWHID_RX_BUFFER,
+#elif defined(USB_FEATURE_MGMT_INTERFACE)
+    1, EP_TYPE_INTERRUPT_IN,  EP_SIZE(RAWHID_TX_SIZE) | RAWHID_TX_BUFFER,
+    1, EP_TYPE_INTERRUPT_OUT, EP_SIZE(RAWHID_RX_SIZE) | RAWHID_RX_BUFFER,
+#endif
     0
 };
 
+#ifdef USB_FEATURE_TAGGED_REQUESTS
+// Tag of the request being answered, sent in the upper bits of the length field
+static uint8_t usb_reply_tag = 0;
+#endif
+
+#ifdef USB_FEATURE_MGMT_INTERFACE
+// Raw HID interface the last packet was received on, replies are sent back on it
+static uint8_t usb_last_rx_interface = RAWHID_INTERFACE;
+// Matching TX endpoint
+static uint8_t usb_current_tx_endpoint = RAWHID_TX_ENDPOINT;
+#endif
+
 
 #ifdef USB_OLED_DEBUG_COMMS
 /*! \fn     displayDebugStatusCode(char* text)
@@ -103,8 +131,46 @@ void initUsb(void)
     USB_CONFIG();                   // start USB clock
     UDCON = 0x00;                   // enable attach resistor
     usb_configuration = 0;          // usb not configured by default
+    #ifdef USB_FEATURE_SUSPEND_POWER_DOWN
+    UDIEN = (1<<EORSTE)|(1<<SOFE)|(1<<SUSPE);
+    #else
     UDIEN = (1<<EORSTE)|(1<<SOFE);  // start USB
+    #endif
+}
+
+#ifdef USB_FEATURE_SUSPEND_POWER_DOWN
+/*! \fn     usbIsSuspended(void)
+*   \brief  Know if the host suspended the USB bus
+*   \return TRUE or FALSE
+*/
+uint8_t usbIsSuspended(void)
+{
+    return usb_suspended;
+}
+
+/*! \fn     usbSleepUntilResume(void)
+*   \brief  Stop the USB clocks & put the MCU in power-down until the host resumes the bus
+*   \note   The peripherals should be powered down by the caller, clocks are restarted by the USB interrupt
+*/
+void usbSleepUntilResume(void)
+{
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    
+    // Interrupts are disabled so a resume can't slip in between the check and the sleep instruction
+    cli();
+    while (usb_suspended != FALSE)
+    {
+        USB_FREEZE();
+        PLLCSR = 0;
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+        cli();
+    }
+    sei();
 }
+#endif
 
 /*! \fn     isUsbConfigured(void)
 *   \brief  Know if the PC has enumerated the mooltipass
@@ -178,7 +244,11 @@ RET_TYPE usbKeyboardPress(uint8_t key, uint8_t modifier)
     uint8_t delay_ms = 0;
     int8_t r;
     
-    if (getMooltipassParameterInEeprom(DELAY_AFTER_KEY_ENTRY_BOOL_PARAM) != FALSE)
+    if (keyboard_typing_delay != KEYBOARD_DELAY_DEVICE_SETTING)
+    {
+        delay_ms = keyboard_typing_delay;
+    }
+    else if (getMooltipassParameterInEeprom(DELAY_AFTER_KEY_ENTRY_BOOL_PARAM) != FALSE)
     {
         delay_ms = getMooltipassParameterInEeprom(DELAY_AFTER_KEY_ENTRY_PARAM);
     }
@@ -212,6 +282,15 @@ RET_TYPE usbKeyboardPress(uint8_t key, uint8_t modifier)
     return r;
 }
 
+/*! \fn     usbKeyboardSetTypingDelay(uint8_t delay_ms)
+*   \brief  Override the delay applied after each keyboard report
+*   \param  delay_ms    Delay in ms, KEYBOARD_DELAY_DEVICE_SETTING to use the device wide setting
+*/
+void usbKeyboardSetTypingDelay(uint8_t delay_ms)
+{
+    keyboard_typing_delay = delay_ms;
+}
+
 /*! \fn     usbSendLockShortcut(void)
 *   \brief  Send host lock shortcut
 */
@@ -235,10 +314,77 @@ uint8_t getKeyboardLeds(void)
     return keyboard_leds;
 }
 
+/*! \fn     usbGetLastRxInterface(void)
+*   \brief  Get the raw HID interface the last packet was received on
+*   \return RAWHID_INTERFACE or MGMT_INTERFACE
+*/
+uint8_t usbGetLastRxInterface(void)
+{
+    #ifdef USB_FEATURE_MGMT_INTERFACE
+        return usb_last_rx_interface;
+    #else
+        return RAWHID_INTERFACE;
+    #endif
+}
+
+#ifdef USB_FEATURE_TAGGED_REQUESTS
+/*! \fn     usbSetReplyTag(uint8_t tag)
+*   \brief  Set the request tag of the next packets sent
+*   \param  tag     Tag bits (HID_LEN_TAG_MASK) of the request being answered, 0 for untagged
+*/
+void usbSetReplyTag(uint8_t tag)
+{
+    usb_reply_tag = tag;
+}
+#endif
+
+#ifdef USB_FEATURE_MGMT_INTERFACE
+/*! \fn     usbSetTxInterface(uint8_t interface)
+*   \brief  Select the raw HID interface the next packets are sent on
+*   \param  interface   RAWHID_INTERFACE or MGMT_INTERFACE
+*/
+void usbSetTxInterface(uint8_t interface)
+{
+    usb_last_rx_interface = interface;
+    if (interface == MGMT_INTERFACE)
+    {
+        usb_current_tx_endpoint = MGMT_TX_ENDPOINT;
+    }
+    else
+    {
+        usb_current_tx_endpoint = RAWHID_TX_ENDPOINT;
+    }
+}
+
+/*! \fn     usbRawHidRxPacketAvailable(void)
+*   \brief  Check both raw HID RX endpoints for a packet, plugin one first
+*   \return TRUE if a packet is available, UENUM then points to its endpoint
+*   \note   Interrupts must be disabled
+*/
+static uint8_t usbRawHidRxPacketAvailable(void)
+{
+    // Interactive (plugin) requests always have priority over bulk transfers
+    UENUM = RAWHID_RX_ENDPOINT;
+    if (UEINTX & (1<<RWAL))
+    {
+        usbSetTxInterface(RAWHID_INTERFACE);
+        return TRUE;
+    }
+    UENUM = MGMT_RX_ENDPOINT;
+    if (UEINTX & (1<<RWAL))
+    {
+        usbSetTxInterface(MGMT_INTERFACE);
+        return TRUE;
+    }
+    return FALSE;
+}
+#endif
+
 /*! \fn     usbRawHidRecv(uint8_t *buffer, uint8_t timeout)
 *   \brief  Receive a packet, with timeout
 *   \param  buffer    Pointer to the buffer to store received data
 *   \return RETURN_COM_TRANSF_OK or RETURN_COM_NOK or RETURN_COM_TIMEOUT
+*   \note   When the management interface is enabled, both interfaces are polled
 */
 RET_TYPE usbRawHidRecv(uint8_t *buffer)
 {
@@ -254,11 +400,17 @@ RET_TYPE usbRawHidRecv(uint8_t *buffer)
     cli();
     // Activate timeout timer
     activateTimer(TIMER_WAIT_FUNCTS, USB_READ_TIMEOUT);
+    #ifndef USB_FEATURE_MGMT_INTERFACE
     UENUM = RAWHID_RX_ENDPOINT;
+    #endif
     // wait for data to be available in the FIFO
     while (1)
     {
+        #ifdef USB_FEATURE_MGMT_INTERFACE
+        if (usbRawHidRxPacketAvailable() == TRUE)
+        #else
         if (UEINTX & (1<<RWAL))
+        #endif
         {
             break;
         }
@@ -273,7 +425,9 @@ RET_TYPE usbRawHidRecv(uint8_t *buffer)
         }
         intr_state = SREG;
         cli();
+        #ifndef USB_FEATURE_MGMT_INTERFACE
         UENUM = RAWHID_RX_ENDPOINT;
+        #endif
     }
     for(i = 0; i < RAWHID_RX_SIZE; i++)
     {
@@ -296,8 +450,28 @@ ISR(USB_GEN_vect)
     uint8_t intbits, i;
 
     intbits = UDINT;
+    #ifdef USB_FEATURE_SUSPEND_POWER_DOWN
+    // Bus activity after a suspend: the clocks need to run before the flags can be cleared
+    if ((intbits & (1<<WAKEUPI)) && (UDIEN & (1<<WAKEUPE)))
+    {
+        PLL_CONFIG();
+        while (!(PLLCSR & (1<<PLOCK)));
+        USB_CONFIG();
+        UDIEN = (UDIEN & ~(1<<WAKEUPE)) | (1<<SUSPE);
+        usb_suspended = FALSE;
+    }
+    #endif
     UDINT = 0;
     
+    #ifdef USB_FEATURE_SUSPEND_POWER_DOWN
+    // Bus idle for more than 3ms: the host suspended us, wait for the resume
+    if ((intbits & (1<<SUSPI)) && (UDIEN & (1<<SUSPE)))
+    {
+        UDIEN = (UDIEN & ~(1<<SUSPE)) | (1<<WAKEUPE);
+        usb_suspended = TRUE;
+    }
+    #endif
+    
     // Device reset
     if (intbits & (1<<EORSTI))
     {
@@ -394,7 +568,12 @@ ISR(USB_COM_vect)
         wLength |= (UEDATX << 8);
         UEINTX = ~((1<<RXSTPI) | (1<<RXOUTI) | (1<<TXINI) | (1 << NAKINI));
 
+        #ifdef USB_FEATURE_MGMT_BULK
+        // The Microsoft OS compatible ID descriptor request is served from the descriptor list too
+        if ((bRequest == GET_DESCRIPTOR) || ((bmRequestType == 0xC0) && (bRequest == MS_OS_VENDOR_CODE)))
+        #else
         if (bRequest == GET_DESCRIPTOR)
+        #endif
         {
             list = (const uint8_t *)descriptor_list;
             for (i=0; ; i++)
@@ -467,7 +646,7 @@ ISR(USB_COM_vect)
             usb_configuration = wValue;
             usb_send_in();
             cfg = endpoint_config_table;
-            for (i=1; i<5; i++)
+            for (i=1; i<=MAX_ENDPOINT; i++)
             {
                 UENUM = i;
                 en = pgm_read_byte(cfg++);
@@ -478,7 +657,7 @@ ISR(USB_COM_vect)
                     UECFG1X = pgm_read_byte(cfg++);
                 }
             }
-            UERST = 0x1E;
+            UERST = ((1 << (MAX_ENDPOINT+1)) - 2);
             UERST = 0;
             return;
         }
@@ -527,7 +706,11 @@ ISR(USB_COM_vect)
                 return;
             }
         }
+        #if defined(USB_FEATURE_MGMT_INTERFACE) && !defined(USB_FEATURE_MGMT_BULK)
+        if ((wIndex == RAWHID_INTERFACE) || (wIndex == MGMT_INTERFACE))
+        #else
         if (wIndex == RAWHID_INTERFACE)
+        #endif
         {
             if (bmRequestType == 0xA1 && bRequest == HID_GET_REPORT)
             {
@@ -664,7 +847,11 @@ static RET_TYPE usbWaitFifoReady(uint8_t *intr_state)
     cli();
     // Activate timeout timer
     activateTimer(TIMER_WAIT_FUNCTS, USB_WRITE_TIMEOUT);
+    #ifdef USB_FEATURE_MGMT_INTERFACE
+    UENUM = usb_current_tx_endpoint;
+    #else
     UENUM = RAWHID_TX_ENDPOINT;
+    #endif
     // wait for the FIFO to be ready to accept data
     while (1)
     {
@@ -683,7 +870,11 @@ static RET_TYPE usbWaitFifoReady(uint8_t *intr_state)
         }
         *intr_state = SREG;
         cli();
+        #ifdef USB_FEATURE_MGMT_INTERFACE
+        UENUM = usb_current_tx_endpoint;
+        #else
         UENUM = RAWHID_TX_ENDPOINT;
+        #endif
     }
     return RETURN_COM_TRANSF_OK;
 }
@@ -730,7 +921,11 @@ RET_TYPE usbHidSend(uint8_t cmd, const void *buffer, uint8_t buflen)
 
     if (cmd)
     {
+        #ifdef USB_FEATURE_TAGGED_REQUESTS
+        UEDATX = buflen | usb_reply_tag;
+        #else
         UEDATX = buflen;
+        #endif
         UEDATX = cmd;
     }
 
@@ -793,7 +988,11 @@ RET_TYPE usbHidSend_P(uint8_t cmd, const void *buffer, uint8_t buflen)
 
     if (cmd)
     {
+        #ifdef USB_FEATURE_TAGGED_REQUESTS
+        UEDATX = buflen | usb_reply_tag;
+        #else
         UEDATX = buflen;
+        #endif
         UEDATX = cmd;
     }
 
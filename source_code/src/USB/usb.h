@@ -22,6 +22,7 @@
 #define PRODUCT_ID          0x09A0              // Product ID (from MCS)
 #define RAWHID_USAGE_PAGE   0xFF31              // HID usage page, after 0xFF00: vendor-defined
 #define RAWHID_USAGE        0x0074              // HID usage
+#define MGMT_USAGE          0x0075              // HID usage for the management interface
 #define STR_MANUFACTURER    L"SE"               // Manufacturer string
 #define STR_PRODUCT         L"Mooltipass"       // Product string
 #define ENDPOINT0_SIZE      32                  // Size for endpoint 0
@@ -36,6 +37,10 @@
 #define KEYBOARD_ENDPOINT   3                   // Endpoint number for keyboard
 #define KEYBOARD_SIZE       8                   // Endpoint size for keyboard
 #define KEYBOARD_BUFFER     EP_DOUBLE_BUFFER    // Double buffer
+#define MGMT_INTERFACE      2                   // Interface for the management / bulk raw HID
+#define MGMT_TX_ENDPOINT    4                   // Management raw HID TX endpoint
+#define MGMT_RX_ENDPOINT    5                   // Management raw HID RX endpoint
+#define MS_OS_VENDOR_CODE   0x4D                // Vendor request used by Windows to fetch the Microsoft OS compatible ID descriptor
 #define USB_WRITE_TIMEOUT   50                  // Timeout for writing in the pipe
 #define USB_READ_TIMEOUT    4                   // Timeout for reading in the pipe
 
@@ -50,7 +55,14 @@
 #define EP_TYPE_ISOCHRONOUS_OUT     0x40
 #define EP_SINGLE_BUFFER            0x02
 #define EP_DOUBLE_BUFFER            0x06
-#define MAX_ENDPOINT                4
+#ifdef USB_FEATURE_MGMT_INTERFACE
+    #define MAX_ENDPOINT            5
+#else
+    #define MAX_ENDPOINT            4
+#endif
+#if defined(USB_FEATURE_MGMT_BULK) && !defined(USB_FEATURE_MGMT_INTERFACE)
+    #error "USB_FEATURE_MGMT_BULK requires USB_FEATURE_MGMT_INTERFACE"
+#endif
 
 // Macros
 #define LSB(n) (n & 255)
@@ -87,6 +99,9 @@
 #define HID_COMPOSE_MASK        8
 #define HID_KANA_MASK           16
 
+// Keyboard typing delay override value to use the device wide setting
+#define KEYBOARD_DELAY_DEVICE_SETTING   0xFF
+
 /** Function prototypes **/
 void initUsb(void);                                           // initialize everything
 uint8_t isUsbConfigured(void);                                // is the USB port configured
@@ -96,14 +111,22 @@ RET_TYPE usbKeybPutChar(char ch);                             // type char
 RET_TYPE usbKeybPutStr(char* string);                         // type string
 RET_TYPE usbRawHidRecv(uint8_t* buffer);                      // receive a packet, with timeout
 RET_TYPE usbRawHidSend(uint8_t* buffer);
+uint8_t usbGetLastRxInterface(void);                          // interface the last packet was received on
+void usbSetTxInterface(uint8_t interface);                    // interface the next packets are sent on
+void usbSetReplyTag(uint8_t tag);                             // request tag set in the next packets length field
 RET_TYPE usbHidSend(uint8_t cmd, const void *buffer, uint8_t buflen);
 RET_TYPE usbHidSend_P(uint8_t cmd, const void *buffer, uint8_t buflen);
 RET_TYPE usbKeyboardPress(uint8_t key, uint8_t modifier);     // send a keyboard press
+void usbKeyboardSetTypingDelay(uint8_t delay_ms);             // override the delay after each keyboard report
 RET_TYPE usbPutstr(const char *str);
 RET_TYPE usbPutstr_P(const char *str);
 RET_TYPE usbSendMessage(uint8_t cmd, uint8_t size, const void *msg);
 RET_TYPE usbSendMessage_P(uint8_t cmd, uint8_t size, const void *msg);
 RET_TYPE usbSendMessageWithRetries(uint8_t cmd, uint8_t size, const void *msg, uint8_t nb_retries);
+#ifdef USB_FEATURE_SUSPEND_POWER_DOWN
+uint8_t usbIsSuspended(void);                                 // did the host suspend the bus
+void usbSleepUntilResume(void);                               // power-down until the host resumes the bus
+#endif
 
 #ifdef ENABLE_PRINTF
     uint8_t usbPrintf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
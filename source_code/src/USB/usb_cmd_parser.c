@@ -32,8 +32,10 @@
 #include "gui_pin_functions.h"
 #include "eeprom_addresses.h"
 #include "watchdog_driver.h"
+#include "aes256_ctr.h"
 #include "logic_smartcard.h"
 #include "usb_cmd_parser.h"
+#include "scratch_arena.h"
 #include "timer_manager.h"
 #include "oled_wrapper.h"
 #include "logic_eeprom.h"
@@ -63,6 +65,30 @@ uint16_t currentNodeWritten = NODE_ADDR_NULL;
 uint16_t mediaFlashImportPage;
 // Media flash import temp offset
 uint16_t mediaFlashImportOffset;
+#ifdef USB_FEATURE_MGMT_INTERFACE
+// Interface that started the current node write
+static uint8_t usb_node_write_interface = RAWHID_INTERFACE;
+// Interface that started the current media import
+static uint8_t usb_media_import_interface = RAWHID_INTERFACE;
+#endif
+#ifdef USB_FEATURE_MEDIA_IMPORT_RESUME
+// Running CBCMAC checkpoint over the programmed media bytes
+uint8_t mediaFlashImportMac[AES_BLOCK_SIZE/8];
+// Number of programmed media bytes covered by the checkpoint
+uint32_t mediaFlashImportMacLength;
+#endif
+#ifdef USB_FEATURE_TAGGED_REQUESTS
+// Tag of the request being processed
+static uint8_t usb_request_tag = 0;
+// Tagged requests received while another one was being processed, served in order
+static uint8_t usb_tagged_queue[USB_TAGGED_QUEUE_SIZE][RAWHID_RX_SIZE];
+#ifdef USB_FEATURE_MGMT_INTERFACE
+// Interfaces the queued requests were received on
+static uint8_t usb_tagged_queue_interface[USB_TAGGED_QUEUE_SIZE];
+#endif
+// Number of queued requests
+static uint8_t usb_tagged_queue_count = 0;
+#endif
 /* External var, addr of bottom of stack (usually located at end of RAM)*/
 extern uint8_t __stack;
 /* External var, end of known static RAM (to be filled by linker) */
@@ -115,7 +141,119 @@ void leaveMemoryManagementMode(void)
         miniLedsSetAnimation(ANIM_NONE);
     #endif
     memoryManagementModeApproved = FALSE;
+    // An unfinished node write is abandoned
+    currentNodeWritten = NODE_ADDR_NULL;
+}
+
+#ifdef USB_FEATURE_MEDIA_IMPORT_RESUME
+/*! \fn     updateMediaImportCheckpoint(void)
+*   \brief  Extend the media import CBCMAC checkpoint over the pages programmed since the last call, by MEDIA_RESUME_MAC_BLOCKS blocks at most
+*   \note   Data is read back from flash, zero key & IV: this only is an integrity check, the bundle itself is authenticated by the bootloader
+*/
+static void updateMediaImportCheckpoint(void)
+{
+    uint32_t programmed_bytes = (uint32_t)(mediaFlashImportPage - GRAPHIC_ZONE_PAGE_START) * BYTES_PER_PAGE;
+    uint8_t temp_block[AES_BLOCK_SIZE/8];
+    uint8_t mac_key[AES_KEY_LENGTH/8];
+    aes256_context temp_aes_context;
+    uint8_t nb_blocks = 0;
+
+    memset((void*)mac_key, 0x00, sizeof(mac_key));
+    aes256_init_ecb(&temp_aes_context, mac_key);
+
+    // The app sends 0xDC again until the checkpoint covers all the programmed pages, so USB isn't blocked for long
+    while (((mediaFlashImportMacLength + sizeof(temp_block)) <= programmed_bytes) && (nb_blocks++ < MEDIA_RESUME_MAC_BLOCKS))
+    {
+        // Page based reads as the media zone can go over the 16 bits addressing space, blocks may straddle two pages
+        uint16_t page = GRAPHIC_ZONE_PAGE_START + (uint16_t)(mediaFlashImportMacLength / BYTES_PER_PAGE);
+        uint16_t page_offset = (uint16_t)(mediaFlashImportMacLength % BYTES_PER_PAGE);
+        uint8_t first_length = sizeof(temp_block);
+        if ((BYTES_PER_PAGE - page_offset) < sizeof(temp_block))
+        {
+            first_length = (uint8_t)(BYTES_PER_PAGE - page_offset);
+            readDataFromFlash(page + 1, 0, sizeof(temp_block) - first_length, temp_block + first_length);
+        }
+        readDataFromFlash(page, page_offset, first_length, temp_block);
+        aesXorVectors(mediaFlashImportMac, temp_block, sizeof(temp_block));
+        aes256_encrypt_ecb(&temp_aes_context, mediaFlashImportMac);
+        mediaFlashImportMacLength += sizeof(temp_block);
+        wdt_reset();
+    }
+}
+
+/*! \fn     storeMediaImportResumePage(void)
+*   \brief  Store the number of bundle pages programmed so far in eeprom, so an import can be resumed after a reset
+*   \note   Rounded down to MEDIA_RESUME_EEP_PAGES pages, the eeprom is only written when the value changes
+*/
+static void storeMediaImportResumePage(void)
+{
+    #if ((GRAPHIC_ZONE_PAGE_END - GRAPHIC_ZONE_PAGE_START) / MEDIA_RESUME_EEP_PAGES) > (0xFF >> MEDIA_RESUME_EEP_MARKER_SHT)
+        #error "Media zone pages do not fit in MEDIA_IMPORT_CHECKPOINT_PARAM"
+    #endif
+    uint8_t nb_checkpoints = (uint8_t)((mediaFlashImportPage - GRAPHIC_ZONE_PAGE_START) / MEDIA_RESUME_EEP_PAGES);
+    uint8_t checkpoint = (nb_checkpoints << MEDIA_RESUME_EEP_MARKER_SHT) | MEDIA_RESUME_EEP_MARKER;
+
+    if (getMooltipassParameterInEeprom(MEDIA_IMPORT_CHECKPOINT_PARAM) != checkpoint)
+    {
+        setMooltipassParameterInEeprom(MEDIA_IMPORT_CHECKPOINT_PARAM, checkpoint);
+    }
+}
+
+/*! \fn     getMediaImportResumePage(void)
+*   \brief  Get the number of bundle pages programmed by an interrupted import from eeprom
+*   \return The number of pages, 0 if the eeprom slot doesn't hold a checkpoint
+*/
+static uint16_t getMediaImportResumePage(void)
+{
+    uint8_t checkpoint = getMooltipassParameterInEeprom(MEDIA_IMPORT_CHECKPOINT_PARAM);
+
+    // Values left by the older firmwares using this slot don't have the marker
+    if ((checkpoint & MEDIA_RESUME_EEP_MARKER_MASK) != MEDIA_RESUME_EEP_MARKER)
+    {
+        return 0;
+    }
+    return (uint16_t)(checkpoint >> MEDIA_RESUME_EEP_MARKER_SHT) * MEDIA_RESUME_EEP_PAGES;
 }
+#endif
+
+#ifdef USB_FEATURE_MEDIA_IMPORT_DIFF
+/*! \fn     getMediaPageCrc32(uint16_t bundle_page)
+*   \brief  Compute the CRC32 of a page of the media zone, as the packing script does for its manifest
+*   \param  bundle_page     Page index inside the media bundle
+*   \return The CRC32
+*   \note   Only the bytes inside the 16 bits addressing space used by the bundle are taken into account
+*/
+static uint32_t getMediaPageCrc32(uint16_t bundle_page)
+{
+    uint32_t page_address = (uint32_t)GRAPHIC_ZONE_START + (uint32_t)bundle_page * BYTES_PER_PAGE;
+    uint16_t nb_bytes = BYTES_PER_PAGE;
+    uint8_t temp_buffer[16];
+    uint32_t crc = 0xFFFFFFFF;
+    uint16_t offset = 0;
+
+    if ((page_address + BYTES_PER_PAGE) > 0x10000)
+    {
+        nb_bytes = (uint16_t)(0x10000 - page_address);
+    }
+
+    while (offset < nb_bytes)
+    {
+        uint8_t chunk_length = sizeof(temp_buffer);
+        if ((nb_bytes - offset) < sizeof(temp_buffer))
+        {
+            chunk_length = (uint8_t)(nb_bytes - offset);
+        }
+        readDataFromFlash(GRAPHIC_ZONE_PAGE_START + bundle_page, offset, chunk_length, temp_buffer);
+        for (uint8_t i = 0; i < chunk_length; i++)
+        {
+            crc = crc32_update(crc, temp_buffer[i]);
+        }
+        offset += chunk_length;
+    }
+
+    return ~crc;
+}
+#endif
 
 /*! \fn     lowerCaseString(char* data)
 *   \brief  lower case a string
@@ -155,6 +293,119 @@ RET_TYPE checkTextField(uint8_t* data, uint8_t len, uint8_t max_len)
     }
 }
 
+#ifdef USB_FEATURE_TAGGED_REQUESTS
+/*! \fn     usbTaggedQueuePush(uint8_t* packet)
+*   \brief  Queue a tagged request received while another request is being processed
+*   \param  packet  The received packet
+*   \return RETURN_OK if queued, RETURN_NOK if the packet isn't tagged or the queue is full
+*/
+static RET_TYPE usbTaggedQueuePush(uint8_t* packet)
+{
+    if (((packet[HID_LEN_FIELD] & HID_LEN_TAG_MASK) == 0) || (usb_tagged_queue_count == USB_TAGGED_QUEUE_SIZE))
+    {
+        return RETURN_NOK;
+    }
+    
+    memcpy((void*)usb_tagged_queue[usb_tagged_queue_count], (void*)packet, RAWHID_RX_SIZE);
+    #ifdef USB_FEATURE_MGMT_INTERFACE
+    usb_tagged_queue_interface[usb_tagged_queue_count] = usbGetLastRxInterface();
+    #endif
+    usb_tagged_queue_count++;
+    return RETURN_OK;
+}
+
+/*! \fn     usbTaggedQueuePop(uint8_t* packet)
+*   \brief  Get the oldest queued tagged request
+*   \param  packet  Buffer for the request
+*   \return RETURN_OK if a request was queued
+*   \note   Answers are then sent on the interface the request was received on
+*/
+static RET_TYPE usbTaggedQueuePop(uint8_t* packet)
+{
+    if (usb_tagged_queue_count == 0)
+    {
+        return RETURN_NOK;
+    }
+    
+    memcpy((void*)packet, (void*)usb_tagged_queue[0], RAWHID_RX_SIZE);
+    #ifdef USB_FEATURE_MGMT_INTERFACE
+    usbSetTxInterface(usb_tagged_queue_interface[0]);
+    memmove((void*)usb_tagged_queue_interface, (void*)&usb_tagged_queue_interface[1], USB_TAGGED_QUEUE_SIZE-1);
+    #endif
+    usb_tagged_queue_count--;
+    memmove((void*)usb_tagged_queue[0], (void*)usb_tagged_queue[1], usb_tagged_queue_count*RAWHID_RX_SIZE);
+    return RETURN_OK;
+}
+
+/*! \fn     usbTaggedQueueDrop(uint8_t tag)
+*   \brief  Drop the queued request with a given tag, received on the same interface as the last packet
+*   \param  tag     The request tag (0: untagged, never queued)
+*   \return RETURN_OK if a queued request was dropped
+*/
+static RET_TYPE usbTaggedQueueDrop(uint8_t tag)
+{
+    uint8_t i;
+    
+    if (tag == 0)
+    {
+        return RETURN_NOK;
+    }
+    
+    for (i = 0; i < usb_tagged_queue_count; i++)
+    {
+        #ifdef USB_FEATURE_MGMT_INTERFACE
+        if (((usb_tagged_queue[i][HID_LEN_FIELD] & HID_LEN_TAG_MASK) == tag) && (usb_tagged_queue_interface[i] == usbGetLastRxInterface()))
+        #else
+        if ((usb_tagged_queue[i][HID_LEN_FIELD] & HID_LEN_TAG_MASK) == tag)
+        #endif
+        {
+            usb_tagged_queue_count--;
+            memmove((void*)usb_tagged_queue[i], (void*)usb_tagged_queue[i+1], (usb_tagged_queue_count-i)*RAWHID_RX_SIZE);
+            #ifdef USB_FEATURE_MGMT_INTERFACE
+            memmove((void*)&usb_tagged_queue_interface[i], (void*)&usb_tagged_queue_interface[i+1], usb_tagged_queue_count-i);
+            #endif
+            return RETURN_OK;
+        }
+    }
+    return RETURN_NOK;
+}
+#endif
+
+/*! \fn     usbRecvRequest(uint8_t* incomingData)
+*   \brief  Get the next request to process
+*   \param  incomingData    Buffer for the request
+*   \return RETURN_COM_TRANSF_OK if there's a request to process
+*   \note   With tagged requests, queued requests are served first and the answers get the request tag
+*/
+static RET_TYPE usbRecvRequest(uint8_t* incomingData)
+{
+    #ifdef USB_FEATURE_TAGGED_REQUESTS
+    if ((usbTaggedQueuePop(incomingData) != RETURN_OK) && (usbRawHidRecv(incomingData) != RETURN_COM_TRANSF_OK))
+    {
+        return RETURN_COM_NOK;
+    }
+    
+    // Keep the tag for the answers, the length field then only holds the length
+    usb_request_tag = incomingData[HID_LEN_FIELD] & HID_LEN_TAG_MASK;
+    incomingData[HID_LEN_FIELD] &= HID_LEN_MASK;
+    usbSetReplyTag(usb_request_tag);
+    return RETURN_COM_TRANSF_OK;
+    #else
+    return usbRawHidRecv(incomingData);
+    #endif
+}
+
+/*! \fn     usbRequestDone(void)
+*   \brief  Called once a request was processed, the next packets sent aren't answers to it
+*/
+static inline void usbRequestDone(void)
+{
+    #ifdef USB_FEATURE_TAGGED_REQUESTS
+    usb_request_tag = 0;
+    usbSetReplyTag(0);
+    #endif
+}
+
 /*! \fn     usbCancelRequestReceived(void)
 *   \brief  Check if a cancel request packet was received
 *   \return RETURN_OK if packet received, RETURN_NOK otherwise
@@ -163,40 +414,72 @@ RET_TYPE usbCancelRequestReceived(void)
 {
     // Our USB data buffer
     uint8_t incomingData[RAWHID_TX_SIZE];
+    #ifdef USB_FEATURE_MGMT_INTERFACE
+    // Interface the pending request was received on
+    uint8_t request_interface = usbGetLastRxInterface();
+    #endif
 
     // Read usb comms as the plugin could ask to cancel the request
     if (usbRawHidRecv(incomingData) == RETURN_COM_TRANSF_OK)
     {
-        if (incomingData[HID_TYPE_FIELD] == CMD_CANCEL_REQUEST)
+        // Does the packet cancel the pending request?
+        uint8_t cancel_pending = (incomingData[HID_TYPE_FIELD] == CMD_CANCEL_REQUEST);
+        #ifdef USB_FEATURE_MGMT_INTERFACE
+        if (usbGetLastRxInterface() != request_interface)
+        {
+            cancel_pending = FALSE;
+        }
+        #endif
+        #ifdef USB_FEATURE_TAGGED_REQUESTS
+        // A tagged cancel naming a queued request drops it, the pending request goes on
+        if ((incomingData[HID_TYPE_FIELD] == CMD_CANCEL_REQUEST) && (usbTaggedQueueDrop(incomingData[HID_LEN_FIELD] & HID_LEN_TAG_MASK) == RETURN_OK))
+        {
+            return RETURN_NOK;
+        }
+        // Otherwise it only cancels the pending request if untagged or with the same tag
+        if (((incomingData[HID_LEN_FIELD] & HID_LEN_TAG_MASK) != 0) && ((incomingData[HID_LEN_FIELD] & HID_LEN_TAG_MASK) != usb_request_tag))
+        {
+            cancel_pending = FALSE;
+        }
+        #endif
+        
+        if (cancel_pending != FALSE)
         {
             // Request canceled
             return RETURN_OK;
         }
         else
         {
+            #ifdef USB_FEATURE_TAGGED_REQUESTS
+            // Tagged requests are served once the pending one is done
+            if (usbTaggedQueuePush(incomingData) != RETURN_OK)
+            {
+                // Untagged packet or full queue, the retry answer carries the tag of the refused request
+                usbSetReplyTag(incomingData[HID_LEN_FIELD] & HID_LEN_TAG_MASK);
+                usbSendMessage(CMD_PLEASE_RETRY, 0, incomingData);
+                usbSetReplyTag(usb_request_tag);
+            }
+            #else
             // Another packet (that shouldn't be sent!), ask to retry later...
             usbSendMessage(CMD_PLEASE_RETRY, 0, incomingData);
+            #endif
+            #ifdef USB_FEATURE_MGMT_INTERFACE
+            // Answer to the pending request on its own interface
+            usbSetTxInterface(request_interface);
+            #endif
         }
     }
 
     return RETURN_NOK;
 }
 
-/*! \fn     usbProcessIncoming(uint8_t caller_id)
-*   \brief  Process a possible incoming USB packet
-*   \param  caller_id   UID of the calling function
+/*! \fn     usbProcessIncomingPacket(uint8_t* incomingData, uint8_t caller_id)
+*   \brief  Process a received USB packet
+*   \param  incomingData    The received packet
+*   \param  caller_id       UID of the calling function
 */
-void usbProcessIncoming(uint8_t caller_id)
+static inline void usbProcessIncomingPacket(uint8_t* incomingData, uint8_t caller_id)
 {
-    // Our USB data buffer
-    uint8_t incomingData[RAWHID_TX_SIZE];
-    
-    // Try to read data from USB, return if we didn't receive anything
-    if(usbRawHidRecv(incomingData) != RETURN_COM_TRANSF_OK)
-    {
-        return;
-    }
-    
     // Temp plugin return value, error by default
     uint8_t plugin_return_value = PLUGIN_BYTE_ERROR;
 
@@ -368,6 +651,13 @@ void usbProcessIncoming(uint8_t caller_id)
         #ifdef DATA_STORAGE_EN
         case CMD_SET_DATA_SERVICE :
         {
+            #ifdef NODE_FEATURE_DATA_SERVICES_LUT
+            // Same as the credential context: in memory management mode the LUTs could be outdated
+            if (memoryManagementModeApproved == TRUE)
+            {
+                populateServicesLut();
+            }
+            #endif
             if (getSmartCardInsertedUnlocked() != TRUE)
             {
                 plugin_return_value = PLUGIN_BYTE_NOCARD;
@@ -422,6 +712,68 @@ void usbProcessIncoming(uint8_t caller_id)
             break;
         }
 
+        #ifdef USB_FEATURE_SINGLE_FETCH_CREDENTIAL
+        // set context & get login + password
+        case CMD_GET_CREDENTIAL :
+        {
+            // Payload: service name, optionally followed by the login, both null terminated
+            uint8_t service_length = strnlen((char*)msg->body.data, datalen) + 1;
+            uint8_t* requested_login = 0;
+            // Buffer for the login followed by the password
+            char credential[NODE_CHILD_SIZE_OF_LOGIN + NODE_CHILD_SIZE_OF_PASSWORD];
+            uint8_t login_length;
+            
+            plugin_return_value = PLUGIN_BYTE_ERROR;
+            
+            // In memory management mode the LUT could be outdated
+            if (memoryManagementModeApproved == TRUE)
+            {
+                populateServicesLut();
+            }
+            
+            if (getSmartCardInsertedUnlocked() != TRUE)
+            {
+                plugin_return_value = PLUGIN_BYTE_NOCARD;
+                USBPARSERDEBUGPRINTF_P(PSTR("get cred: no card\n"));
+                break;
+            }
+            
+            // Check the service name then the optional login
+            if ((service_length > datalen) || (checkTextField(msg->body.data, service_length, NODE_PARENT_SIZE_OF_SERVICE) == RETURN_NOK))
+            {
+                break;
+            }
+            if (datalen > service_length)
+            {
+                requested_login = msg->body.data + service_length;
+                if (checkTextField(requested_login, datalen - service_length, NODE_CHILD_SIZE_OF_LOGIN) == RETURN_NOK)
+                {
+                    break;
+                }
+            }
+            
+            if ((setCurrentContext(msg->body.data, SERVICE_CRED_TYPE) == RETURN_OK) && (getCredentialForContext(requested_login, credential) == RETURN_OK))
+            {
+                // Login & password in one packet when they fit, otherwise the password follows in a second packet
+                login_length = strlen(credential) + 1;
+                if ((login_length + strlen(credential + login_length) + 1) <= (RAWHID_TX_SIZE - HID_DATA_START))
+                {
+                    usbSendMessage(CMD_GET_CREDENTIAL, login_length + strlen(credential + login_length) + 1, credential);
+                }
+                else
+                {
+                    usbSendMessage(CMD_GET_CREDENTIAL, login_length, credential);
+                    usbSendMessage(CMD_GET_CREDENTIAL, strlen(credential + login_length) + 1, credential + login_length);
+                }
+                memset((void*)credential, 0x00, sizeof(credential));
+                USBPARSERDEBUGPRINTF_P(PSTR("get cred: ok\n"));
+                return;
+            }
+            USBPARSERDEBUGPRINTF_P(PSTR("get cred: failed\n"));
+            break;
+        }
+        #endif
+
         // get description
         case CMD_GET_DESCRIPTION :
         {
@@ -455,6 +807,22 @@ void usbProcessIncoming(uint8_t caller_id)
             break;
         }
 
+#ifdef KEYBOARD_FEATURE_SERVICE_TYPING_DELAY
+        // set keyboard typing delay profile for the current service
+        case CMD_SET_TYPING_DELAY :
+        {
+            if ((datalen == 1) && (setTypingDelayForContext(msg->body.data[0]) == RETURN_OK))
+            {
+                plugin_return_value = PLUGIN_BYTE_OK;
+            }
+            else
+            {
+                plugin_return_value = PLUGIN_BYTE_ERROR;
+            }
+            break;
+        }
+#endif
+
         // set description
         case CMD_SET_DESCRIPTION :
         {
@@ -523,11 +891,53 @@ void usbProcessIncoming(uint8_t caller_id)
             }
             break;
         }
+
+        #ifdef NODE_FEATURE_SERVICE_ALIAS
+        // Add a service alias
+        case CMD_ADD_SERVICE_ALIAS :
+        {
+            // Payload: alias name followed by the name of the service holding the credentials, both null terminated
+            uint8_t alias_length = strnlen((char*)msg->body.data, datalen) + 1;
+            uint8_t* canonical_name = msg->body.data + alias_length;
+            
+            plugin_return_value = PLUGIN_BYTE_ERROR;
+            
+            // In memory management mode the LUT could be outdated
+            if (memoryManagementModeApproved == TRUE)
+            {
+                populateServicesLut();
+            }
+            
+            // Check both service names
+            if ((alias_length >= datalen) || (checkTextField(msg->body.data, alias_length, NODE_PARENT_SIZE_OF_SERVICE) == RETURN_NOK) || (checkTextField(canonical_name, datalen - alias_length, NODE_PARENT_SIZE_OF_SERVICE) == RETURN_NOK))
+            {
+                break;
+            }
+            
+            if (addNewServiceAlias(msg->body.data, alias_length, canonical_name) == RETURN_OK)
+            {
+                plugin_return_value = PLUGIN_BYTE_OK;
+                USBPARSERDEBUGPRINTF_P(PSTR("add alias: \"%s\" ok\n"),msg->body.data);
+            }
+            else
+            {
+                USBPARSERDEBUGPRINTF_P(PSTR("add alias: \"%s\" failed\n"),msg->body.data);
+            }
+            break;
+        }
+        #endif
         
         // Add data context
         #ifdef DATA_STORAGE_EN
         case CMD_ADD_DATA_SERVICE :
         {
+            #ifdef NODE_FEATURE_DATA_SERVICES_LUT
+            // Adding a data service inserts it in the data services LUT, which could be outdated in memory management mode
+            if (memoryManagementModeApproved == TRUE)
+            {
+                populateServicesLut();
+            }
+            #endif
             if (addNewContext(msg->body.data, datalen, SERVICE_DATA_TYPE) == RETURN_OK)
             {
                 // We managed to add a new context
@@ -581,6 +991,38 @@ void usbProcessIncoming(uint8_t caller_id)
             break;
         }
         #endif
+        
+        #if defined(DATA_STORAGE_EN) && defined(NODE_FEATURE_COMPRESSED_DATA)
+        // Set the encoding of the data about to be written in the current data context
+        case CMD_SET_DATA_ENCODING :
+        {
+            if ((datalen == 1) && (setDataContextEncoding(msg->body.data[0]) == RETURN_OK))
+            {
+                plugin_return_value = PLUGIN_BYTE_OK;
+            }
+            else
+            {
+                plugin_return_value = PLUGIN_BYTE_ERROR;
+            }
+            break;
+        }
+        
+        // Get the encoding of the data stored in the current data context
+        case CMD_GET_DATA_ENCODING :
+        {
+            if (getDataContextEncoding(&incomingData[1]) == RETURN_OK)
+            {
+                incomingData[0] = PLUGIN_BYTE_OK;
+                usbSendMessage(CMD_GET_DATA_ENCODING, 2, incomingData);
+                return;
+            }
+            else
+            {
+                plugin_return_value = PLUGIN_BYTE_ERROR;
+            }
+            break;
+        }
+        #endif
 
         // Read user db change number
         case CMD_GET_USER_CHANGE_NB :
@@ -707,6 +1149,30 @@ void usbProcessIncoming(uint8_t caller_id)
             }
         }
         
+#ifdef NODE_FEATURE_TOPOLOGY_DUMP
+        // Get compact descriptions of the user nodes
+        case CMD_GET_DB_TOPOLOGY :
+        {
+            // Not in the data management commands range: check done here
+            if ((memoryManagementModeApproved == TRUE) && (datalen == 2))
+            {
+                // Answer: address to resume the scan from, followed by the node descriptions
+                uint8_t answer[sizeof(uint16_t) + 4*sizeof(nodeTopology_t)];
+                uint8_t nodesFound;
+                
+                memcpy((void*)answer, (void*)msg->body.data, sizeof(uint16_t));
+                nodesFound = getUserNodesTopology(4, (nodeTopology_t*)&answer[sizeof(uint16_t)], (uint16_t*)answer);
+                usbSendMessage(CMD_GET_DB_TOPOLOGY, sizeof(uint16_t) + nodesFound*sizeof(nodeTopology_t), answer);
+                return;
+            }
+            else
+            {
+                plugin_return_value = PLUGIN_BYTE_ERROR;
+            }
+            break;
+        }
+#endif
+        
         // End memory management mode
         case CMD_END_MEMORYMGMT :
         {
@@ -714,10 +1180,12 @@ void usbProcessIncoming(uint8_t caller_id)
             // memoryManagementModeApproved is cleared when user removes his card
             guiSetCurrentScreen(SCREEN_DEFAULT_INSERTED_NLCK);
             plugin_return_value = PLUGIN_BYTE_OK;
-            currentNodeWritten = NODE_ADDR_NULL;
             leaveMemoryManagementMode();
             guiGetBackToCurrentScreen();
             activityDetectedRoutine();
+            #ifdef NODE_FEATURE_PARENTS_REFRESH
+            refreshParentNodesSummaries();
+            #endif
             populateServicesLut();
             scanNodeUsage();
             break;
@@ -732,15 +1200,15 @@ void usbProcessIncoming(uint8_t caller_id)
             {
                 // First two bytes are the node address
                 uint16_t* temp_node_addr_ptr = (uint16_t*)msg->body.data;
-                // Temp buffer to store the node
-                uint8_t temp_buffer[NODE_SIZE];
                 
                 //  Check user permissions
                 if(checkUserPermission(*temp_node_addr_ptr) == RETURN_OK)
                 {
                     // Read node in flash & send it, ownership check is done in the function
-                    readNode((gNode*)temp_buffer, *temp_node_addr_ptr);
-                    usbSendMessage(CMD_READ_FLASH_NODE, NODE_SIZE, temp_buffer);
+                    gNode* temp_node_ptr = &scratchAcquire(SCRATCH_OWNER_MEMORY_MGMT)->memoryMgmtNode;
+                    readNode(temp_node_ptr, *temp_node_addr_ptr);
+                    usbSendMessage(CMD_READ_FLASH_NODE, NODE_SIZE, temp_node_ptr);
+                    scratchRelease(SCRATCH_OWNER_MEMORY_MGMT);
                     return;
                 }
                 else
@@ -915,6 +1383,10 @@ void usbProcessIncoming(uint8_t caller_id)
                     //  Check user permissions
                     if(checkUserPermission(*temp_node_addr_ptr) == RETURN_OK)
                     {
+                        #ifdef NODE_FEATURE_PARENTS_REFRESH
+                        // Parent summaries are refreshed when leaving memory management mode
+                        markParentNodesSummariesStale();
+                        #endif
                         currentNodeWritten = *temp_node_addr_ptr;
                         loadPageToInternalBuffer(pageNumberFromAddress(currentNodeWritten));                        
                     }
@@ -936,6 +1408,10 @@ void usbProcessIncoming(uint8_t caller_id)
                     if (msg->body.data[2] == (NODE_SIZE/(PACKET_EXPORT_SIZE-3)))
                     {
                         flashWriteBufferToPage(pageNumberFromAddress(currentNodeWritten));
+                        #ifdef USB_FEATURE_MGMT_INTERFACE
+                        // Release the flash internal buffer
+                        currentNodeWritten = NODE_ADDR_NULL;
+                        #endif
                     }
                     
                     plugin_return_value = PLUGIN_BYTE_OK;
@@ -948,12 +1424,42 @@ void usbProcessIncoming(uint8_t caller_id)
             break;
         }
 
+#ifdef NODE_FEATURE_BATCH_DELETE
+        // Delete a list of nodes in Flash
+        case CMD_DELETE_NODES :
+        {
+            // Not in the data management commands range: check done here
+            #ifdef NODE_FEATURE_PARENTS_REFRESH
+            if (memoryManagementModeApproved == TRUE)
+            {
+                // Children of the remaining parents may be deleted
+                markParentNodesSummariesStale();
+            }
+            #endif
+            if ((memoryManagementModeApproved == TRUE) && ((datalen & 0x01) == 0) && (deleteNodesBatch((uint16_t*)msg->body.data, datalen/2) == RETURN_OK))
+            {
+                plugin_return_value = PLUGIN_BYTE_OK;
+            }
+            else
+            {
+                plugin_return_value = PLUGIN_BYTE_ERROR;
+            }
+            // The flash internal buffer was used
+            currentNodeWritten = NODE_ADDR_NULL;
+            break;
+        }
+#endif
+
         // import media flash contents
         case CMD_IMPORT_MEDIA_START :
         {            
             // Set default addresses
             mediaFlashImportPage = GRAPHIC_ZONE_PAGE_START;
             mediaFlashImportOffset = 0;        
+            #ifdef USB_FEATURE_MEDIA_IMPORT_RESUME
+            memset((void*)mediaFlashImportMac, 0x00, sizeof(mediaFlashImportMac));
+            mediaFlashImportMacLength = 0;
+            #endif
 
             // Things are different between the mini & the standard Mooltipass
             #if defined(MINI_VERSION)
@@ -1107,12 +1613,111 @@ void usbProcessIncoming(uint8_t caller_id)
                     flashWriteBufferToPage(mediaFlashImportPage);
                     mediaFlashImportOffset = 0;
                     mediaFlashImportPage++;
+                    #ifdef USB_FEATURE_MEDIA_IMPORT_RESUME
+                    // Checkpoint in eeprom every few pages to limit wear & write time
+                    if (((mediaFlashImportPage - GRAPHIC_ZONE_PAGE_START) % MEDIA_RESUME_EEP_PAGES) == 0)
+                    {
+                        storeMediaImportResumePage();
+                    }
+                    #endif
                 }
                 plugin_return_value = PLUGIN_BYTE_OK;
             }
             break;
         }
 
+#ifdef USB_FEATURE_MEDIA_IMPORT_RESUME
+        // media flash import status, used to resume an interrupted import
+        case CMD_IMPORT_MEDIA_STATUS :
+        {
+            if (mediaFlashImportApproved == FALSE)
+            {
+                plugin_return_value = PLUGIN_BYTE_ERROR;
+                break;
+            }
+
+            // Nothing programmed since the import was approved: resume from the eeprom checkpoint, the import may have been interrupted by a reset
+            if ((mediaFlashImportPage == GRAPHIC_ZONE_PAGE_START) && (mediaFlashImportMacLength == 0))
+            {
+                mediaFlashImportPage = GRAPHIC_ZONE_PAGE_START + getMediaImportResumePage();
+                if (mediaFlashImportPage > GRAPHIC_ZONE_PAGE_END)
+                {
+                    mediaFlashImportPage = GRAPHIC_ZONE_PAGE_START;
+                }
+            }
+
+            // Drop the partially received page, the host resumes at the start of the first page that isn't programmed
+            mediaFlashImportOffset = 0;
+            updateMediaImportCheckpoint();
+            storeMediaImportResumePage();
+
+            // Answer: OK byte | resume offset in the bundle | number of bytes covered by the checkpoint so far | checkpoint
+            uint32_t resume_offset = (uint32_t)(mediaFlashImportPage - GRAPHIC_ZONE_PAGE_START) * BYTES_PER_PAGE;
+            msg->body.data[0] = PLUGIN_BYTE_OK;
+            memcpy((void*)&msg->body.data[1], (void*)&resume_offset, sizeof(resume_offset));
+            memcpy((void*)&msg->body.data[5], (void*)&mediaFlashImportMacLength, sizeof(mediaFlashImportMacLength));
+            memcpy((void*)&msg->body.data[9], (void*)mediaFlashImportMac, sizeof(mediaFlashImportMac));
+            usbSendMessage(CMD_IMPORT_MEDIA_STATUS, 9 + sizeof(mediaFlashImportMac), msg->body.data);
+            return;
+        }
+#endif
+
+#ifdef USB_FEATURE_MEDIA_IMPORT_DIFF
+        // compare page digests from the bundle manifest with the media zone contents
+        case CMD_IMPORT_MEDIA_DIFF :
+        {
+            uint16_t page_length, first_page, diff_bitmask = 0;
+            uint8_t nb_pages = (datalen - sizeof(page_length) - sizeof(first_page)) / sizeof(uint32_t);
+            memcpy((void*)&page_length, (void*)msg->body.data, sizeof(page_length));
+            memcpy((void*)&first_page, (void*)&msg->body.data[sizeof(page_length)], sizeof(first_page));
+
+            // Check that the import was approved, that the manifest was made for our flash pages, that we received digests and that they are inside the media zone
+            if ((mediaFlashImportApproved == FALSE) || (datalen < sizeof(page_length) + sizeof(first_page) + sizeof(uint32_t)) || (page_length != BYTES_PER_PAGE) || (nb_pages > MEDIA_DIFF_MAX_PAGES) || ((GRAPHIC_ZONE_PAGE_START + first_page + nb_pages) > GRAPHIC_ZONE_PAGE_END))
+            {
+                plugin_return_value = PLUGIN_BYTE_ERROR;
+                break;
+            }
+
+            // Set a bit for each page that needs to be sent
+            for (uint8_t i = 0; i < nb_pages; i++)
+            {
+                uint32_t manifest_crc;
+                memcpy((void*)&manifest_crc, (void*)&msg->body.data[sizeof(page_length) + sizeof(first_page) + i*sizeof(uint32_t)], sizeof(manifest_crc));
+                if (getMediaPageCrc32(first_page + i) != manifest_crc)
+                {
+                    diff_bitmask |= (1 << i);
+                }
+            }
+
+            msg->body.data[0] = PLUGIN_BYTE_OK;
+            memcpy((void*)&msg->body.data[1], (void*)&diff_bitmask, sizeof(diff_bitmask));
+            usbSendMessage(CMD_IMPORT_MEDIA_DIFF, 1 + sizeof(diff_bitmask), msg->body.data);
+            return;
+        }
+
+        // set the bundle page the next media import packets are written to
+        case CMD_IMPORT_MEDIA_SEEK :
+        {
+            uint16_t page_length, bundle_page;
+            memcpy((void*)&page_length, (void*)msg->body.data, sizeof(page_length));
+            memcpy((void*)&bundle_page, (void*)&msg->body.data[sizeof(page_length)], sizeof(bundle_page));
+
+            // The page index is only meaningful for the page length the host split its bundle with
+            if ((mediaFlashImportApproved == FALSE) || (datalen != sizeof(page_length) + sizeof(bundle_page)) || (page_length != BYTES_PER_PAGE) || ((GRAPHIC_ZONE_PAGE_START + bundle_page) >= GRAPHIC_ZONE_PAGE_END))
+            {
+                plugin_return_value = PLUGIN_BYTE_ERROR;
+            }
+            else
+            {
+                // A partially received page is dropped
+                mediaFlashImportPage = GRAPHIC_ZONE_PAGE_START + bundle_page;
+                mediaFlashImportOffset = 0;
+                plugin_return_value = PLUGIN_BYTE_OK;
+            }
+            break;
+        }
+#endif
+
         // end media flash import
         case CMD_IMPORT_MEDIA_END :
         {
@@ -1120,6 +1725,13 @@ void usbProcessIncoming(uint8_t caller_id)
             {
                 flashWriteBufferToPage(mediaFlashImportPage);
             }
+            #ifdef USB_FEATURE_MEDIA_IMPORT_RESUME
+            if (mediaFlashImportApproved == TRUE)
+            {
+                // Import complete, nothing to resume
+                setMooltipassParameterInEeprom(MEDIA_IMPORT_CHECKPOINT_PARAM, 0);
+            }
+            #endif
             plugin_return_value = PLUGIN_BYTE_OK;
             mediaFlashImportApproved = FALSE;
             
@@ -1148,6 +1760,15 @@ void usbProcessIncoming(uint8_t caller_id)
                     }
                 #endif
 
+                #ifdef USB_FEATURE_MEDIA_IMPORT_RESUME
+                    // The media import checkpoint is only written by the import commands
+                    if (msg->body.data[0] == MEDIA_IMPORT_CHECKPOINT_PARAM)
+                    {
+                        plugin_return_value = PLUGIN_BYTE_ERROR;
+                        break;
+                    }
+                #endif
+
                 // Set correct value in eeprom and refresh parameters that need refreshing
                 setMooltipassParameterInEeprom(msg->body.data[0], msg->body.data[1]);
                 mp_timeout_enabled = getMooltipassParameterInEeprom(LOCK_TIMEOUT_ENABLE_PARAM);
@@ -1736,3 +2357,90 @@ void usbProcessIncoming(uint8_t caller_id)
     usbSendMessage(datacmd, 1, &plugin_return_value);
 }
 
+#ifdef USB_FEATURE_MGMT_INTERFACE
+/*! \fn     usbProcessIncoming(uint8_t caller_id)
+*   \brief  Process a possible incoming USB packet, arbitrating between the plugin and management interfaces
+*   \param  caller_id   UID of the calling function
+*   \note   usbRawHidRecv() always serves the plugin interface first, so interactive requests are handled between bulk packets
+*   \note   Node writes and media imports use the flash internal buffer across packets, the other interface is arbitrated
+*/
+void usbProcessIncoming(uint8_t caller_id)
+{
+    // Our USB data buffer
+    uint8_t incomingData[RAWHID_TX_SIZE];
+    // Set when we need to give the flash internal buffer back to the media import
+    uint8_t reload_media_import_page = FALSE;
+    // Interface the packet was received on
+    uint8_t rx_interface;
+    // Operations in progress before processing the packet
+    uint16_t node_written_before = currentNodeWritten;
+    uint8_t media_import_before = mediaFlashImportApproved;
+
+    // Try to read data from USB, return if we didn't receive anything
+    if(usbRecvRequest(incomingData) != RETURN_COM_TRANSF_OK)
+    {
+        return;
+    }
+    rx_interface = usbGetLastRxInterface();
+
+    // A node is being written (3 packets) from the other interface, ask to come back
+    if ((currentNodeWritten != NODE_ADDR_NULL) && (usb_node_write_interface != rx_interface))
+    {
+        usbSendMessage(CMD_PLEASE_RETRY, 0, incomingData);
+        usbRequestDone();
+        return;
+    }
+
+    // A media page is being imported from the other interface
+    if ((mediaFlashImportApproved == TRUE) && (mediaFlashImportOffset != 0) && (usb_media_import_interface != rx_interface))
+    {
+        if (incomingData[HID_TYPE_FIELD] == CMD_WRITE_FLASH_NODE)
+        {
+            // A node write would need the flash internal buffer for several packets
+            usbSendMessage(CMD_PLEASE_RETRY, 0, incomingData);
+            usbRequestDone();
+            return;
+        }
+        // Checkpoint the page being imported, it is reloaded once the request is served
+        flashWriteBufferToPage(mediaFlashImportPage);
+        reload_media_import_page = TRUE;
+    }
+
+    usbProcessIncomingPacket(incomingData, caller_id);
+    usbRequestDone();
+
+    // Remember which interface started a node write or a media import
+    if ((node_written_before == NODE_ADDR_NULL) && (currentNodeWritten != NODE_ADDR_NULL))
+    {
+        usb_node_write_interface = rx_interface;
+    }
+    if ((media_import_before == FALSE) && (mediaFlashImportApproved == TRUE))
+    {
+        usb_media_import_interface = rx_interface;
+    }
+
+    if (reload_media_import_page == TRUE)
+    {
+        loadPageToInternalBuffer(mediaFlashImportPage);
+    }
+}
+#else
+/*! \fn     usbProcessIncoming(uint8_t caller_id)
+*   \brief  Process a possible incoming USB packet
+*   \param  caller_id   UID of the calling function
+*/
+void usbProcessIncoming(uint8_t caller_id)
+{
+    // Our USB data buffer
+    uint8_t incomingData[RAWHID_TX_SIZE];
+    
+    // Try to read data from USB, return if we didn't receive anything
+    if(usbRecvRequest(incomingData) != RETURN_COM_TRANSF_OK)
+    {
+        return;
+    }
+
+    usbProcessIncomingPacket(incomingData, caller_id);
+    usbRequestDone();
+}
+#endif
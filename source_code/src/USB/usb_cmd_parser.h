@@ -87,6 +87,16 @@
 #define CMD_LOCK_DEVICE         0xD9
 #define CMD_GET_MINI_SERIAL     0xDA
 #define CMD_UNLOCK_WITH_PIN     0xDB
+#define CMD_IMPORT_MEDIA_STATUS 0xDC
+#define CMD_IMPORT_MEDIA_DIFF   0xDD
+#define CMD_IMPORT_MEDIA_SEEK   0xDE
+#define CMD_SET_TYPING_DELAY    0xDF
+#define CMD_DELETE_NODES        0xE0
+#define CMD_GET_CREDENTIAL      0xE1
+#define CMD_GET_DB_TOPOLOGY     0xE2
+#define CMD_ADD_SERVICE_ALIAS   0xE3
+#define CMD_SET_DATA_ENCODING   0xE4
+#define CMD_GET_DATA_ENCODING   0xE5
 
 
 /* Packet format defines     */
@@ -94,12 +104,29 @@
 #define HID_TYPE_FIELD      0x01
 #define HID_DATA_START      0x02
 
+/* Tagged requests: the length field upper bits carry a request tag (0: untagged), echoed in the answers */
+#define HID_LEN_TAG_MASK    0xC0
+#define HID_LEN_MASK        0x3F
+#define USB_TAGGED_QUEUE_SIZE   1
+
 /* Packet answers */
 #define PLUGIN_BYTE_ERROR   0x00
 #define PLUGIN_BYTE_OK      0x01
 #define PLUGIN_BYTE_NA      0x02
 #define PLUGIN_BYTE_NOCARD  0x03
 
+/* Differential media import: max number of page digests per packet, after the page length & first page fields */
+#define MEDIA_DIFF_MAX_PAGES    14
+
+/* Media import resume: the number of programmed pages is stored in eeprom every MEDIA_RESUME_EEP_PAGES pages */
+#define MEDIA_RESUME_EEP_PAGES  8
+/* The eeprom slot was used by older firmwares: it stores the number of programmed pages / MEDIA_RESUME_EEP_PAGES in its upper bits, MEDIA_RESUME_EEP_MARKER in the others */
+#define MEDIA_RESUME_EEP_MARKER         0x05
+#define MEDIA_RESUME_EEP_MARKER_MASK    0x07
+#define MEDIA_RESUME_EEP_MARKER_SHT     3
+/* Maximum number of 16 bytes blocks added to the media import checkpoint per 0xDC command */
+#define MEDIA_RESUME_MAC_BLOCKS         64
+
 /* Packet defines */
 #define PACKET_EXPORT_SIZE  (RAWHID_TX_SIZE-HID_DATA_START)
 #define DATA_NODE_BLOCK_SIZ 32
@@ -37,7 +37,11 @@ static const uint8_t PROGMEM device_descriptor[] =
     ENDPOINT0_SIZE,                     // bMaxPacketSize0
     LSB(VENDOR_ID), MSB(VENDOR_ID),     // idVendor
     LSB(PRODUCT_ID), MSB(PRODUCT_ID),   // idProduct
+#ifdef USB_FEATURE_MGMT_BULK
+    0x01, 0x01,                         // bcdDevice, Windows only asks for the Microsoft OS descriptors once per bcdDevice
+#else
     0x00, 0x01,                         // bcdDevice
+#endif
     1,                                  // iManufacturer
     2,                                  // iProduct
     0,                                  // iSerialNumber
@@ -62,6 +66,26 @@ static const uint8_t PROGMEM rawhid_hid_report_desc[] =
     0xC0                                // end collection
 };
 
+#if defined(USB_FEATURE_MGMT_INTERFACE) && !defined(USB_FEATURE_MGMT_BULK)
+// Management raw HID descriptor, same as the plugin one but with a different usage so hosts can tell them apart
+static const uint8_t PROGMEM mgmt_hid_report_desc[] =
+{
+    0x06, LSB(RAWHID_USAGE_PAGE), MSB(RAWHID_USAGE_PAGE),
+    0x0A, LSB(MGMT_USAGE), MSB(MGMT_USAGE),
+    0xA1, 0x01,                         // Collection 0x01
+    0x75, 0x08,                         // report size = 8 bits
+    0x15, 0x00,                         // logical minimum = 0
+    0x26, 0xFF, 0x00,                   // logical maximum = 255
+    0x95, RAWHID_TX_SIZE,               // report count
+    0x09, 0x01,                         // usage
+    0x81, 0x02,                         // Input (array)
+    0x95, RAWHID_RX_SIZE,               // report count
+    0x09, 0x02,                         // usage
+    0x91, 0x02,                         // Output (array)
+    0xC0                                // end collection
+};
+#endif
+
 // Keyboard HID descriptor, Keyboard Protocol 1, HID 1.11 spec, Appendix B, page 59-60
 static const uint8_t PROGMEM keyboard_hid_report_desc[] =
 {
@@ -99,7 +123,17 @@ static const uint8_t PROGMEM keyboard_hid_report_desc[] =
     0xc0                                // End Collection
 };
 
-#define CONFIG1_DESC_SIZE        (9+9+9+7+7+9+9+7)
+#if defined(USB_FEATURE_MGMT_BULK)
+    #define CONFIG1_DESC_SIZE    (9+9+9+7+7+9+9+7+9+7+7)
+    #define CONFIG1_NB_INTERFACES 3
+#elif defined(USB_FEATURE_MGMT_INTERFACE)
+    #define CONFIG1_DESC_SIZE    (9+9+9+7+7+9+9+7+9+9+7+7)
+    #define MGMT_HID_DESC_OFFSET (9+9+9+7+7+9+9+7+9)
+    #define CONFIG1_NB_INTERFACES 3
+#else
+    #define CONFIG1_DESC_SIZE    (9+9+9+7+7+9+9+7)
+    #define CONFIG1_NB_INTERFACES 2
+#endif
 #define RAWHID_HID_DESC_OFFSET   (9+9)
 #define KEYBOARD_HID_DESC_OFFSET (9+9+9+7+7+9)
 
@@ -111,7 +145,7 @@ static const uint8_t PROGMEM config1_descriptor[CONFIG1_DESC_SIZE] =
     2,                                  // bDescriptorType;
     LSB(CONFIG1_DESC_SIZE),             // wTotalLength
     MSB(CONFIG1_DESC_SIZE),
-    2,                                  // bNumInterfaces
+    CONFIG1_NB_INTERFACES,              // bNumInterfaces
     1,                                  // bConfigurationValue
     0,                                  // iConfiguration
     0x80,                               // bmAttributes
@@ -181,7 +215,77 @@ static const uint8_t PROGMEM config1_descriptor[CONFIG1_DESC_SIZE] =
     KEYBOARD_ENDPOINT | 0x80,           // bEndpointAddress
     0x03,                               // bmAttributes (0x03=intr)
     KEYBOARD_SIZE, 0,                   // wMaxPacketSize
+#if defined(USB_FEATURE_MGMT_BULK)
+    1,                                  // bInterval
+
+    // interface descriptor, USB spec 9.6.5, page 267-269, Table 9-12
+    9,                                  // bLength
+    4,                                  // bDescriptorType
+    MGMT_INTERFACE,                     // bInterfaceNumber
+    0,                                  // bAlternateSetting
+    2,                                  // bNumEndpoints
+    0xFF,                               // bInterfaceClass (0xFF = vendor specific)
+    0x00,                               // bInterfaceSubClass
+    0x00,                               // bInterfaceProtocol
+    0,                                  // iInterface
+
+    // endpoint descriptor, USB spec 9.6.6, page 269-271, Table 9-13
+    7,                                  // bLength
+    5,                                  // bDescriptorType
+    MGMT_RX_ENDPOINT,                   // bEndpointAddress
+    0x02,                               // bmAttributes (0x02=bulk)
+    RAWHID_RX_SIZE, 0,                  // wMaxPacketSize
+    0,                                  // bInterval
+
+    // endpoint descriptor, USB spec 9.6.6, page 269-271, Table 9-13
+    7,                                  // bLength
+    5,                                  // bDescriptorType
+    MGMT_TX_ENDPOINT | 0x80,            // bEndpointAddress
+    0x02,                               // bmAttributes (0x02=bulk)
+    RAWHID_TX_SIZE, 0,                  // wMaxPacketSize
+    0                                   // bInterval
+#elif defined(USB_FEATURE_MGMT_INTERFACE)
+    1,                                  // bInterval
+
+    // interface descriptor, USB spec 9.6.5, page 267-269, Table 9-12
+    9,                                  // bLength
+    4,                                  // bDescriptorType
+    MGMT_INTERFACE,                     // bInterfaceNumber
+    0,                                  // bAlternateSetting
+    2,                                  // bNumEndpoints
+    0x03,                               // bInterfaceClass (0x03 = HID)
+    0x00,                               // bInterfaceSubClass (0x01 = Boot)
+    0x00,                               // bInterfaceProtocol (0x01 = Keyboard)
+    0,                                  // iInterface
+
+    // HID interface descriptor, HID 1.11 spec, section 6.2.1
+    9,                                  // bLength
+    0x21,                               // bDescriptorType
+    0x11, 0x01,                         // bcdHID
+    0,                                  // bCountryCode
+    1,                                  // bNumDescriptors
+    0x22,                               // bDescriptorType
+    sizeof(mgmt_hid_report_desc),       // wDescriptorLength
+    0,
+
+    // endpoint descriptor, USB spec 9.6.6, page 269-271, Table 9-13
+    7,                                  // bLength
+    5,                                  // bDescriptorType
+    MGMT_RX_ENDPOINT,                   // bEndpointAddress
+    0x03,                               // bmAttributes (0x03=intr)
+    RAWHID_RX_SIZE, 0,                  // wMaxPacketSize
+    1,                                  // bInterval
+
+    // endpoint descriptor, USB spec 9.6.6, page 269-271, Table 9-13
+    7,                                  // bLength
+    5,                                  // bDescriptorType
+    MGMT_TX_ENDPOINT | 0x80,            // bEndpointAddress
+    0x03,                               // bmAttributes (0x03=intr)
+    RAWHID_TX_SIZE, 0,                  // wMaxPacketSize
+    1                                   // bInterval
+#else
     1                                   // bInterval
+#endif
 };
 
 // USB strings
@@ -204,8 +308,33 @@ static const usb_string_descriptor_struct_t PROGMEM string2 =
     STR_PRODUCT
 };
 
+#ifdef USB_FEATURE_MGMT_BULK
+// Microsoft OS string descriptor: "MSFT100" followed by the vendor request code, lets Windows bind WinUSB without an inf file
+static const usb_string_descriptor_struct_t PROGMEM ms_os_string =
+{
+    18,
+    3,
+    {'M', 'S', 'F', 'T', '1', '0', '0', MS_OS_VENDOR_CODE}
+};
+
+// Microsoft extended compatible ID descriptor: the management interface uses WinUSB
+static const uint8_t PROGMEM ms_compat_id_descriptor[] =
+{
+    40, 0, 0, 0,                        // dwLength
+    0x00, 0x01,                         // bcdVersion
+    0x04, 0x00,                         // wIndex (extended compatible ID)
+    1,                                  // bCount
+    0, 0, 0, 0, 0, 0, 0,                // reserved
+    MGMT_INTERFACE,                     // bFirstInterfaceNumber
+    0x01,                               // reserved
+    'W', 'I', 'N', 'U', 'S', 'B', 0, 0, // compatibleID
+    0, 0, 0, 0, 0, 0, 0, 0,             // subCompatibleID
+    0, 0, 0, 0, 0, 0                    // reserved
+};
+#endif
+
 // This table defines which descriptor data is sent for each specific request from the host (in wValue and wIndex).
-const descriptor_list_struct_t PROGMEM descriptor_list[9] =
+const descriptor_list_struct_t PROGMEM descriptor_list[NUM_DESC_LIST_ENTRIES] =
 {
     {0x0100, 0x0000, device_descriptor, sizeof(device_descriptor)},
     {0x0200, 0x0000, config1_descriptor, sizeof(config1_descriptor)},
@@ -213,6 +342,13 @@ const descriptor_list_struct_t PROGMEM descriptor_list[9] =
     {0x2100, RAWHID_INTERFACE, config1_descriptor+RAWHID_HID_DESC_OFFSET, 9},
     {0x2200, KEYBOARD_INTERFACE, keyboard_hid_report_desc, sizeof(keyboard_hid_report_desc)},
     {0x2100, KEYBOARD_INTERFACE, config1_descriptor+KEYBOARD_HID_DESC_OFFSET, 9},
+#if defined(USB_FEATURE_MGMT_BULK)
+    {0x03EE, 0x0000, (const uint8_t *)&ms_os_string, 18},
+    {0x0000, 0x0004, ms_compat_id_descriptor, sizeof(ms_compat_id_descriptor)},
+#elif defined(USB_FEATURE_MGMT_INTERFACE)
+    {0x2200, MGMT_INTERFACE, mgmt_hid_report_desc, sizeof(mgmt_hid_report_desc)},
+    {0x2100, MGMT_INTERFACE, config1_descriptor+MGMT_HID_DESC_OFFSET, 9},
+#endif
     {0x0300, 0x0000, (const uint8_t *)&string0, 4},
     {0x0301, 0x0409, (const uint8_t *)&string1, sizeof(STR_MANUFACTURER)},
     {0x0302, 0x0409, (const uint8_t *)&string2, sizeof(STR_PRODUCT)}
@@ -27,6 +27,7 @@
 #define USB_DESCRIPTORS_H_
 
 #include <stdint.h>
+#include "defines.h"
 
 // Typedef for USB string
 typedef struct
@@ -45,8 +46,16 @@ typedef struct
     uint8_t         length;
 } descriptor_list_struct_t;
 
+// Number of entries in our descriptor list
+#ifdef USB_FEATURE_MGMT_INTERFACE
+    // Management interface HID descriptors, or Microsoft OS descriptors for the bulk version
+    #define NUM_DESC_LIST_ENTRIES   11
+#else
+    #define NUM_DESC_LIST_ENTRIES   9
+#endif
+
 // Array containing all of our descriptors
-extern const descriptor_list_struct_t descriptor_list[9];
+extern const descriptor_list_struct_t descriptor_list[NUM_DESC_LIST_ENTRIES];
 
 // Number of descriptors we have
 #define NUM_DESC_LIST (sizeof(descriptor_list)/sizeof(descriptor_list_struct_t))
@@ -0,0 +1,71 @@
+/* CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/license_cddl-1.0.txt
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/license_cddl-1.0.txt
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+/*!  \file     scratch_arena.c
+*    \brief    Node buffers shared by code paths that never run at the same time
+*    Created:  19/10/2026
+*/
+#include "scratch_arena.h"
+#include "defines.h"
+
+// The arena
+scratchArena_t scratchArena;
+// Current arena owner
+uint8_t scratchArenaOwner = SCRATCH_OWNER_NONE;
+// Set when the credential context lost the arena contents
+uint8_t scratchArenaContextLost = FALSE;
+
+
+/*! \fn     scratchAcquire(uint8_t owner)
+*   \brief  Take the scratch arena for the time of an operation
+*   \param  owner   The new owner (SCRATCH_OWNER_XXX)
+*   \return Pointer to the arena
+*   \note   Must be followed by scratchRelease() once done, the credential context uses scratchContextAcquire()
+*/
+scratchArena_t* scratchAcquire(uint8_t owner)
+{
+    scratchArenaContextLost = TRUE;
+    scratchArenaOwner = owner;
+    return &scratchArena;
+}
+
+/*! \fn     scratchRelease(uint8_t owner)
+*   \brief  Give the scratch arena back, its contents are then undefined
+*   \param  owner   The owner releasing the arena
+*/
+void scratchRelease(uint8_t owner)
+{
+    if (scratchArenaOwner == owner)
+    {
+        scratchArenaOwner = SCRATCH_OWNER_NONE;
+    }
+}
+
+/*! \fn     scratchContextAcquire(void)
+*   \brief  Take the scratch arena for the credential context
+*   \return RETURN_OK if the context nodes weren't overwritten by another owner since the previous call, RETURN_NOK otherwise
+*/
+RET_TYPE scratchContextAcquire(void)
+{
+    RET_TYPE return_value = (scratchArenaContextLost == FALSE) ? RETURN_OK : RETURN_NOK;
+    
+    scratchArenaContextLost = FALSE;
+    scratchArenaOwner = SCRATCH_OWNER_CONTEXT;
+    return return_value;
+}
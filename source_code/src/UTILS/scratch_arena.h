@@ -0,0 +1,78 @@
+/* CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at src/license_cddl-1.0.txt
+ * or http://www.opensolaris.org/os/licensing.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at src/license_cddl-1.0.txt
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+/*!  \file     scratch_arena.h
+*    \brief    Node buffers shared by code paths that never run at the same time
+*    Created:  19/10/2026
+*/
+
+
+#ifndef SCRATCH_ARENA_H_
+#define SCRATCH_ARENA_H_
+
+#include "node_mgmt.h"
+#include "defines.h"
+#if defined(HARDWARE_OLIVIER_V1)
+    #include "standard_gui_credentials_functions.h"
+#endif
+
+// Scratch arena owners
+#define SCRATCH_OWNER_NONE          0
+#define SCRATCH_OWNER_CONTEXT       1
+#define SCRATCH_OWNER_LOGIN_SELECT  2
+#define SCRATCH_OWNER_MEMORY_MGMT   3
+
+/*!
+* Scratch arena layouts, one per owner
+*
+* Note: the credential context layout is the default one. Its contents may be used across
+* several USB requests (data node transfers) and are lost when another owner acquires the
+* arena, which scratchContextAcquire() reports.
+*/
+typedef union
+{
+    struct
+    {
+        pNode pnode;                        /*!< Context parent node (logic_aes_and_comms.c) */
+        cNode cnode;                        /*!< Context child / data node (logic_aes_and_comms.c) */
+    } context;
+    struct
+    {
+        uint8_t contextPnode[NODE_SIZE];    /*!< Left to service searches, which use the context parent node */
+        pNode pnode;                        /*!< Parent node displayed by the login selection screen */
+    } loginSelect;
+    #if defined(HARDWARE_OLIVIER_V1)
+    struct
+    {
+        uint8_t contextNodes[2*NODE_SIZE];  /*!< Left to the context parent / child nodes, used by the login selection */
+        loginWindow_t window;               /*!< Logins displayed by the login selection (guiAskForLoginSelect) */
+    } loginWindow;
+    #endif
+    gNode memoryMgmtNode;                   /*!< Node read by the memory management interface */
+} scratchArena_t;
+
+// The arena
+extern scratchArena_t scratchArena;
+
+// Prototypes
+scratchArena_t* scratchAcquire(uint8_t owner);
+void scratchRelease(uint8_t owner);
+RET_TYPE scratchContextAcquire(void);
+
+#endif /* SCRATCH_ARENA_H_ */
@@ -34,6 +34,29 @@ uint16_t swap16(uint16_t val)
     return ((val << 8) | (uint8_t)(val >> 8));
 }
 
+/*! \fn     crc32_update(uint32_t crc, uint8_t data)
+*   \brief  Update a CRC32 (IEEE 802.3, reflected, same as zlib) with one byte
+*   \param  crc     Current CRC, start with 0xFFFFFFFF and invert the final result
+*   \param  data    The byte
+*   \return The updated CRC
+*/
+uint32_t crc32_update(uint32_t crc, uint8_t data)
+{
+    crc ^= data;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if (crc & 1)
+        {
+            crc = (crc >> 1) ^ 0xEDB88320;
+        }
+        else
+        {
+            crc >>= 1;
+        }
+    }
+    return crc;
+}
+
 /*! \fn     numchar_to_char(unsigned char c)
 *   \brief  Convert a char value (0 to 9) to be displayed
 *   \param  c   The char
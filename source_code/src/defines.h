@@ -434,6 +434,61 @@ typedef int8_t RET_TYPE;
 /**************** FEATURE SELECTION ****************/
 // Used for normal browser plugin communications
 #define USB_FEATURE_PLUGIN_COMMS
+// The features below are off until avr-size & elf_analysis/sram_report.py outputs of the mini & standard builds show
+// that they fit: firmware next to the bootloader, static SRAM plus worst case stack in the 2560 bytes of the atmega32u4
+// Second raw HID interface for memory management / bulk transfers, so they don't starve the plugin channel
+//#define USB_FEATURE_MGMT_INTERFACE
+// Media import can be resumed from the last programmed page after a USB hiccup
+//#define USB_FEATURE_MEDIA_IMPORT_RESUME
+// Differential media import: only the pages that differ from the flash contents are sent
+//#define USB_FEATURE_MEDIA_IMPORT_DIFF
+// Mooltipass standard: touch controller status reads & LED updates are done by the TWI interrupt
+//#define TOUCH_FEATURE_TWI_INTERRUPT
+// Keyboard typing delay can be set per service, stored in the parent node flags
+//#define KEYBOARD_FEATURE_SERVICE_TYPING_DELAY
+// Memory management mode: several nodes can be deleted & unlinked by the device in one command
+//#define NODE_FEATURE_BATCH_DELETE
+// Credential parent nodes cache their number of children and most recently used child
+//#define NODE_FEATURE_PARENT_SUMMARY
+// USB suspend: once the suspend timer expired, peripherals are powered down & the MCU sleeps until the host resumes the bus
+//#define USB_FEATURE_SUSPEND_POWER_DOWN
+// Browser plugins can fetch a login & password with a single request
+//#define USB_FEATURE_SINGLE_FETCH_CREDENTIAL
+// Credential parent nodes store a service name prefix & hash, so service searches mostly don't read whole nodes
+//#define NODE_FEATURE_SERVICE_COMPARE_KEY
+// On-device service search only offers the characters that lead to one of the user services
+//#define GUI_FEATURE_PREDICTIVE_SEARCH
+// Mooltipass mini: host scripted fast functional test, non-interactive checks are run together and reported in one packet
+//#define MINI_FEATURE_FAST_FUNCTIONAL_TEST
+// Informational screens (card removed, PC sleep, going to sleep...) are timed by the main loop instead of blocking it
+//#define GUI_FEATURE_TOAST_SCREENS
+// Recently read nodes are kept in SRAM (NODE_CACHE_NB_ENTRIES * 135 bytes)
+//#define NODE_FEATURE_NODE_CACHE
+// Login selection screens list the credentials of a service by last use instead of alphabetically
+//#define NODE_FEATURE_LOGIN_USAGE_ORDER
+// Memory management mode: the user node graph can be dumped as compact records (address, links, digest)
+//#define NODE_FEATURE_TOPOLOGY_DUMP
+// Management interface exposed as a vendor class interface with bulk endpoints (WinUSB / libusb) instead of a raw HID one, several packets per frame
+//#define USB_FEATURE_MGMT_BULK
+// Mooltipass mini: bitmaps stored in the frame buffer layout by the bundle tool are copied as they are instead of being decoded column by column
+//#define MINI_FEATURE_NATIVE_BITMAPS
+// Credential services can be aliases of another service, sharing its credentials (one login for several domains)
+//#define NODE_FEATURE_SERVICE_ALIAS
+// Data services get their own first letter look up table, like the credential services
+//#define NODE_FEATURE_DATA_SERVICES_LUT
+// Data services can hold payloads compressed by the host before sending them, flagged in the data parent node
+//#define NODE_FEATURE_COMPRESSED_DATA
+// Raw HID requests can be tagged so hosts can keep several in flight, tagged requests received during a pending one are queued
+//#define USB_FEATURE_TAGGED_REQUESTS
+
+// Node writes & flash page modifications are tracked for the node cache and the login usage order
+#if defined(NODE_FEATURE_NODE_CACHE) || defined(NODE_FEATURE_LOGIN_USAGE_ORDER)
+    #define NODE_FEATURE_CHANGE_TRACKING
+#endif
+// Credential parent node records are checked & fixed when leaving memory management mode
+#if defined(NODE_FEATURE_PARENT_SUMMARY) || defined(NODE_FEATURE_SERVICE_COMPARE_KEY) || defined(NODE_FEATURE_SERVICE_ALIAS)
+    #define NODE_FEATURE_PARENTS_REFRESH
+#endif
 
 /**************** DEFINES PORTS ****************/
 #ifdef  HARDWARE_OLIVIER_V1
@@ -23,14 +23,19 @@
  */ 
 #include <avr/eeprom.h>
 #include <avr/io.h>
+#include <string.h>
+#include <stdlib.h>
 #include "smart_card_higher_level_functions.h"
 #include "touch_higher_level_functions.h"
 #include "logic_fwflash_storage.h"
 #include "gui_screen_functions.h"
 #include "gui_basic_functions.h"
+#include "functional_testing.h"
 #include "eeprom_addresses.h"
+#include "timer_manager.h"
 #include "oled_wrapper.h"
 #include "mini_inputs.h"
+#include "flash_mem.h"
 #include "mini_leds.h"
 #include "smartcard.h"
 #include "defines.h"
@@ -172,6 +177,365 @@ void mooltipassStandardElectricalTest(uint8_t fuse_ok)
 }
 
 #ifdef MINI_VERSION
+/*! \fn     miniFunctionalTestResult(uint8_t test_result_ok, uint8_t* report, uint8_t report_length)
+ *  \brief  Display & send the functional test result, then only process USB packets
+ *  \param  test_result_ok  Bool to know if the test passed
+ *  \param  report          Report sent to the script, its first byte is set to RETURN_OK / RETURN_NOK
+ *  \param  report_length   Report length
+ */
+static void miniFunctionalTestResult(uint8_t test_result_ok, uint8_t* report, uint8_t report_length)
+{
+    if (test_result_ok == TRUE)
+    {
+        // Inform script of success
+        report[0] = RETURN_OK;
+        usbSendMessage(CMD_FUNCTIONAL_TEST_RES, report_length, report);
+        
+        #ifndef DISABLE_USB_SET_UID_DEV_PASSWORD_COMMANDS    
+        // Wait for password to be set
+        while(eeprom_read_byte((uint8_t*)EEP_BOOT_PWD_SET) != BOOTLOADER_PWDOK_KEY)
+        {
+            usbProcessIncoming(USB_CALLER_MAIN);
+        }
+        #endif
+        
+        // Functional test passed, remove fboot flag
+        eeprom_write_byte((uint8_t*)EEP_MASS_PROD_FBOOT_BOOL_ADDR, 0);
+
+        // Go to startup screen
+        guiSetCurrentScreen(SCREEN_DEFAULT_NINSERTED);
+        guiGetBackToCurrentScreen();
+    }
+    else
+    {
+        // Display test result
+        guiDisplayRawString(ID_STRING_TEST_NOK);
+            
+        // Inform script of failure
+        report[0] = RETURN_NOK;
+        usbSendMessage(CMD_FUNCTIONAL_TEST_RES, report_length, report);
+    }
+
+    // Still process USB packets (needed for script)
+    while(1)
+    {
+        usbProcessIncoming(USB_CALLER_MAIN);
+    }
+}
+
+#ifdef MINI_FEATURE_FAST_FUNCTIONAL_TEST
+// Fast functional test time accounted for in the previous TIMER_FUNC_TEST periods
+static uint32_t func_test_elapsed_ms;
+
+/*! \fn     functionalTestElapsedMs(void)
+ *  \brief  Time elapsed since the fast functional test started, TIMER_FUNC_TEST being re-armed every period
+ *  \return Elapsed time in ms
+ *  \note   Must be called at least once every FUNC_TEST_TIMER_PERIOD ms
+ */
+static uint32_t functionalTestElapsedMs(void)
+{
+    if (hasTimerExpired(TIMER_FUNC_TEST, TRUE) == TIMER_EXPIRED)
+    {
+        func_test_elapsed_ms += FUNC_TEST_TIMER_PERIOD;
+        activateTimer(TIMER_FUNC_TEST, FUNC_TEST_TIMER_PERIOD);
+    }
+    return func_test_elapsed_ms + FUNC_TEST_TIMER_PERIOD - getTimerVal(TIMER_FUNC_TEST);
+}
+
+/*! \fn     functionalTestPatternByte(uint16_t offset)
+ *  \brief  Pattern written to the flash test page
+ *  \param  offset  Offset in the page
+ *  \return The byte at this offset
+ */
+static inline uint8_t functionalTestPatternByte(uint16_t offset)
+{
+    return (uint8_t)offset ^ (uint8_t)(offset >> 8) ^ 0xA5;
+}
+
+/*! \fn     miniFastFunctionalTestAutomatedChecks(funcTestReport_t* report, uint8_t flash_init_result, uint8_t mini_inputs_result)
+ *  \brief  Non-interactive checks of the fast functional test: the flash page write, LED readback
+ *          and accelerometer self test are started together and waited for in a single loop
+ *  \param  report              Report in which the failed & skipped checks are set
+ *  \param  flash_init_result   Result of the flash initialization procedure
+ *  \param  mini_inputs_result  Bool to know if inputs are ok
+ */
+static void miniFastFunctionalTestAutomatedChecks(funcTestReport_t* report, uint8_t flash_init_result, uint8_t mini_inputs_result)
+{
+    uint8_t flash_write_pending = FALSE;
+    uint32_t loop_start_ms;
+    uint8_t temp_buffer[8];
+    uint16_t i;
+    uint8_t j;
+    #ifdef HARDWARE_MINI_CLICK_V2
+    uint8_t acc_nb_samples = 0;
+    int32_t acc_sums[3] = {0, 0, 0};
+    int16_t temp_int16;
+    #endif
+
+    // Flash ID, then fill the flash buffer with our pattern and start writing the test page
+    if (flash_init_result != RETURN_OK)
+    {
+        report->failed_checks |= FUNC_TEST_CHK_FLASH_ID | FUNC_TEST_CHK_FLASH_PATTERN;
+    }
+    else
+    {
+        for (i = 0; i < BYTES_PER_PAGE; i += sizeof(temp_buffer))
+        {
+            for (j = 0; j < sizeof(temp_buffer); j++)
+            {
+                temp_buffer[j] = functionalTestPatternByte(i + j);
+            }
+            flashWriteBuffer(temp_buffer, i, sizeof(temp_buffer));
+        }
+        flashStartWriteBufferToPage(FUNC_TEST_FLASH_PAGE);
+        flash_write_pending = TRUE;
+    }
+
+    // LEDs: PWM & port readback, leave them on for the operator
+    #ifdef LEDS_ENABLED_MINI
+    setPwmDc(0xFFFF);
+    if (getPwmDc() != 0xFFFF)
+    {
+        report->failed_checks |= FUNC_TEST_CHK_LEDS;
+    }
+    for (j = 0; j < 4; j++)
+    {
+        miniSetLedStates(1 << j);
+        if (miniGetLedStates() != (1 << j))
+        {
+            report->failed_checks |= FUNC_TEST_CHK_LEDS;
+        }
+    }
+    miniSetLedStates(0x0F);
+    #else
+    report->skipped_checks |= FUNC_TEST_CHK_LEDS;
+    #endif
+
+    // Mini inputs initialization also checked the accelerometer presence
+    if (mini_inputs_result != RETURN_OK)
+    {
+        report->failed_checks |= FUNC_TEST_CHK_INPUTS | FUNC_TEST_CHK_ACC_SELF_TEST;
+    }
+
+    #ifdef HARDWARE_MINI_CLICK_V2
+    if (mini_inputs_result != RETURN_OK)
+    {
+        acc_nb_samples = 2*FUNC_TEST_ACC_NB_SAMPLES + FUNC_TEST_ACC_NB_DISCARDED;
+    }
+    #else
+    report->skipped_checks |= FUNC_TEST_CHK_ACC_SELF_TEST;
+    #endif
+
+    // Wait for the flash write and the accelerometer self test together
+    loop_start_ms = functionalTestElapsedMs();
+    while ((functionalTestElapsedMs() - loop_start_ms) < FUNC_TEST_AUTOMATED_TIMEOUT)
+    {
+        if ((flash_write_pending != FALSE) && (isFlashReady() == RETURN_OK))
+        {
+            flash_write_pending = FALSE;
+        }
+
+        #ifdef HARDWARE_MINI_CLICK_V2
+        // Averaged outputs without then with self test, discarding the samples right after enabling it
+        if ((acc_nb_samples < 2*FUNC_TEST_ACC_NB_SAMPLES + FUNC_TEST_ACC_NB_DISCARDED) && (getNewAccelerometerDataIfAvailable(temp_buffer) == RETURN_OK))
+        {
+            for (j = 0; j < 3; j++)
+            {
+                temp_int16 = (int16_t)(((uint16_t)temp_buffer[2*j+1] << 8) | temp_buffer[2*j]);
+                if (acc_nb_samples < FUNC_TEST_ACC_NB_SAMPLES)
+                {
+                    acc_sums[j] -= temp_int16;
+                }
+                else if (acc_nb_samples >= FUNC_TEST_ACC_NB_SAMPLES + FUNC_TEST_ACC_NB_DISCARDED)
+                {
+                    acc_sums[j] += temp_int16;
+                }
+            }
+            acc_nb_samples++;
+
+            // Enable / disable positive self test (CTRL5 register)
+            if ((acc_nb_samples == FUNC_TEST_ACC_NB_SAMPLES) || (acc_nb_samples == 2*FUNC_TEST_ACC_NB_SAMPLES + FUNC_TEST_ACC_NB_DISCARDED))
+            {
+                temp_buffer[0] = 0x24;
+                temp_buffer[1] = (acc_nb_samples == FUNC_TEST_ACC_NB_SAMPLES) ? 0x04 : 0x00;
+                miniAccelerometerSendReceiveSPIData(temp_buffer, 2);
+            }
+        }
+        if ((flash_write_pending == FALSE) && (acc_nb_samples == 2*FUNC_TEST_ACC_NB_SAMPLES + FUNC_TEST_ACC_NB_DISCARDED))
+        #else
+        if (flash_write_pending == FALSE)
+        #endif
+        {
+            break;
+        }
+    }
+
+    // Check the flash page contents, then erase it
+    if (flash_init_result == RETURN_OK)
+    {
+        if (flash_write_pending != FALSE)
+        {
+            report->failed_checks |= FUNC_TEST_CHK_FLASH_PATTERN;
+        }
+        else
+        {
+            for (i = 0; i < BYTES_PER_PAGE; i += sizeof(temp_buffer))
+            {
+                readDataFromFlash(FUNC_TEST_FLASH_PAGE, i, sizeof(temp_buffer), temp_buffer);
+                for (j = 0; j < sizeof(temp_buffer); j++)
+                {
+                    if (temp_buffer[j] != functionalTestPatternByte(i + j))
+                    {
+                        report->failed_checks |= FUNC_TEST_CHK_FLASH_PATTERN;
+                    }
+                }
+            }
+        }
+        pageErase(FUNC_TEST_FLASH_PAGE);
+    }
+
+    // Check the accelerometer self test output change
+    #ifdef HARDWARE_MINI_CLICK_V2
+    if (mini_inputs_result == RETURN_OK)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            report->acc_self_test_delta[j] = (int16_t)(acc_sums[j] / FUNC_TEST_ACC_NB_SAMPLES);
+            if ((acc_nb_samples != 2*FUNC_TEST_ACC_NB_SAMPLES + FUNC_TEST_ACC_NB_DISCARDED) || (abs(report->acc_self_test_delta[j]) < FUNC_TEST_ACC_ST_MIN_DELTA) || (abs(report->acc_self_test_delta[j]) > FUNC_TEST_ACC_ST_MAX_DELTA))
+            {
+                report->failed_checks |= FUNC_TEST_CHK_ACC_SELF_TEST;
+            }
+        }
+    }
+    #endif
+}
+
+/*! \fn     miniFastFunctionalTestOperatorSteps(funcTestReport_t* report)
+ *  \brief  Operator steps of the fast functional test: wheel click, wheel scroll and card insertion
+ *          can be done in any order on a single screen, of which only the status line is redrawn
+ *  \param  report  Report in which the failed checks are set
+ */
+static void miniFastFunctionalTestOperatorSteps(funcTestReport_t* report)
+{
+    uint8_t pending_checks = FUNC_TEST_CHK_WHEEL_CLICK | FUNC_TEST_CHK_WHEEL_SCROLL | FUNC_TEST_CHK_CARD;
+    uint8_t status_refresh_needed = TRUE;
+    uint8_t scroll_steps = 0;
+    RET_TYPE temp_rettype;
+    char status_string[9];
+    int8_t temp_int8;
+
+    // Check that the card is removed
+    if (isSmartCardAbsent() == RETURN_NOK)
+    {
+        guiDisplayRawString(ID_STRING_REMOVE_CARD);
+        while(isSmartCardAbsent() == RETURN_NOK);
+    }
+
+    // Instructions are only written once
+    oledClear();miniOledResetXY();
+    guiDisplayRawString(ID_STRING_FUNC_TEST);
+    miniOledDontFlushWrittenTextToDisplay();
+    miniWheelClearDetections();
+
+    while (pending_checks != 0)
+    {
+        // Keep the elapsed time counter running
+        functionalTestElapsedMs();
+        
+        if (((pending_checks & FUNC_TEST_CHK_WHEEL_CLICK) != 0) && (isWheelClicked() == RETURN_JDETECT))
+        {
+            pending_checks &= ~FUNC_TEST_CHK_WHEEL_CLICK;
+            status_refresh_needed = TRUE;
+        }
+
+        temp_int8 = getWheelCurrentIncrement();
+        if (((pending_checks & FUNC_TEST_CHK_WHEEL_SCROLL) != 0) && (temp_int8 != 0))
+        {
+            scroll_steps += abs(temp_int8);
+            if (scroll_steps >= FUNC_TEST_SCROLL_STEPS)
+            {
+                pending_checks &= ~FUNC_TEST_CHK_WHEEL_SCROLL;
+            }
+            status_refresh_needed = TRUE;
+        }
+
+        if (((pending_checks & FUNC_TEST_CHK_CARD) != 0) && (isCardPlugged() == RETURN_JDETECT))
+        {
+            temp_rettype = cardDetectedRoutine();
+            if (!((temp_rettype == RETURN_MOOLTIPASS_BLANK) || (temp_rettype == RETURN_MOOLTIPASS_USER)))
+            {
+                report->failed_checks |= FUNC_TEST_CHK_CARD;
+            }
+            pending_checks &= ~FUNC_TEST_CHK_CARD;
+            status_refresh_needed = TRUE;
+        }
+
+        // Partial redraw: status line with the remaining steps
+        if (status_refresh_needed != FALSE)
+        {
+            memset(status_string, ' ', sizeof(status_string) - 1);
+            status_string[sizeof(status_string) - 1] = 0;
+            if ((pending_checks & FUNC_TEST_CHK_WHEEL_CLICK) != 0)
+            {
+                status_string[0] = 'C';
+            }
+            if ((pending_checks & FUNC_TEST_CHK_WHEEL_SCROLL) != 0)
+            {
+                hexachar_to_string((char)scroll_steps, &status_string[3]);
+                status_string[5] = ' ';
+            }
+            if ((pending_checks & FUNC_TEST_CHK_CARD) != 0)
+            {
+                status_string[7] = 'I';
+            }
+            miniOledDrawRectangle(0, FUNC_TEST_STATUS_LINE_Y, SSD1305_OLED_WIDTH, SSD1305_PAGE_HEIGHT, FALSE);
+            miniOledPutCenteredString(FUNC_TEST_STATUS_LINE_Y, status_string);
+            miniOledFlushBufferContents(0, SSD1305_OLED_WIDTH - 1, FUNC_TEST_STATUS_LINE_Y, SSD1305_OLED_HEIGHT - 1);
+            status_refresh_needed = FALSE;
+        }
+    }
+    miniOledFlushWrittenTextToDisplay();
+    oledClear();miniOledResetXY();
+}
+
+/*! \fn     miniFastFunctionalTest(uint8_t flash_init_result, uint8_t mini_inputs_result)
+ *  \brief  Host scripted fast functional test, results are sent in one funcTestReport_t packet
+ *  \param  flash_init_result   Result of the flash initialization procedure
+ *  \param  mini_inputs_result  Bool to know if inputs are ok
+ */
+static void miniFastFunctionalTest(uint8_t flash_init_result, uint8_t mini_inputs_result)
+{
+    funcTestReport_t report;
+
+    // Measure the per unit test time
+    memset((void*)&report, 0x00, sizeof(report));
+    func_test_elapsed_ms = 0;
+    activateTimer(TIMER_FUNC_TEST, FUNC_TEST_TIMER_PERIOD);
+
+    miniFastFunctionalTestAutomatedChecks(&report, flash_init_result, mini_inputs_result);
+    report.automated_checks_ms = (uint16_t)functionalTestElapsedMs();
+
+    miniFastFunctionalTestOperatorSteps(&report);
+    report.total_ms = functionalTestElapsedMs();
+    activateTimer(TIMER_FUNC_TEST, 0);
+
+    // Display the problems found
+    if ((report.failed_checks & (FUNC_TEST_CHK_FLASH_ID | FUNC_TEST_CHK_FLASH_PATTERN)) != 0)
+    {
+        guiDisplayRawString(ID_STRING_TEST_FLASH_PB);
+    }
+    if ((report.failed_checks & (FUNC_TEST_CHK_INPUTS | FUNC_TEST_CHK_ACC_SELF_TEST | FUNC_TEST_CHK_LEDS)) != 0)
+    {
+        guiDisplayRawString(ID_STRING_INPUT_PB);
+    }
+    if ((report.failed_checks & FUNC_TEST_CHK_CARD) != 0)
+    {
+        guiDisplayRawString(ID_STRING_TEST_CARD_PB);
+    }
+    miniFunctionalTestResult((report.failed_checks == 0) ? TRUE : FALSE, (uint8_t*)&report, sizeof(report));
+}
+#endif
+
 /*! \fn     mooltipassMiniFunctionalTest(uint8_t flash_init_result, uint8_t fuse_ok, uint8_t mini_inputs_result)
  *  \brief  Mooltipass standard functional test
  *  \param  flash_init_result       Result of the flash initialization procedure
@@ -189,6 +553,16 @@ void mooltipassMiniFunctionalTest(uint8_t flash_init_result, uint8_t mini_inputs
     // Wait for USB host to upload bundle, which then sets USER_PARAM_INIT_KEY_PARAM
     while(getMooltipassParameterInEeprom(USER_PARAM_INIT_KEY_PARAM) != correct_param_init_key_val)
     {
+        #ifdef MINI_FEATURE_FAST_FUNCTIONAL_TEST
+        // Script selected the fast functional test
+        if (getMooltipassParameterInEeprom(USER_PARAM_INIT_KEY_PARAM) == FUNC_TEST_FAST_MODE_KEY)
+        {
+            miniOledAllowTextWritingYIncrement();
+            miniOledFlushWrittenTextToDisplay();
+            miniOledBegin(FONT_DEFAULT);
+            miniFastFunctionalTest(flash_init_result, mini_inputs_result);
+        }
+        #endif
         usbProcessIncoming(USB_CALLER_MAIN);
     }
         
@@ -275,44 +649,8 @@ void mooltipassMiniFunctionalTest(uint8_t flash_init_result, uint8_t mini_inputs
     }
         
     // Display result
-    uint8_t script_return = RETURN_OK;
-    if (test_result_ok == TRUE)
-    {
-        // Inform script of success
-        usbSendMessage(CMD_FUNCTIONAL_TEST_RES, 1, &script_return);            
-        
-        #ifndef DISABLE_USB_SET_UID_DEV_PASSWORD_COMMANDS    
-        // Wait for password to be set
-        while(eeprom_read_byte((uint8_t*)EEP_BOOT_PWD_SET) != BOOTLOADER_PWDOK_KEY)
-        {
-            usbProcessIncoming(USB_CALLER_MAIN);
-        }
-        #endif
-        
-        // Functional test passed, remove fboot flag
-        eeprom_write_byte((uint8_t*)EEP_MASS_PROD_FBOOT_BOOL_ADDR, 0);
-
-        // Go to startup screen
-        guiSetCurrentScreen(SCREEN_DEFAULT_NINSERTED);
-        guiGetBackToCurrentScreen();
-    }
-    else
-    {
-        // Set correct bool
-        script_return = RETURN_NOK;
-            
-        // Display test result
-        guiDisplayRawString(ID_STRING_TEST_NOK);
-            
-        // Inform script of failure
-        usbSendMessage(CMD_FUNCTIONAL_TEST_RES, 1, &script_return);
-    }
-
-    // Still process USB packets (needed for script)
-    while(1)
-    {
-        usbProcessIncoming(USB_CALLER_MAIN);
-    }
+    uint8_t script_return;
+    miniFunctionalTestResult(test_result_ok, &script_return, sizeof(script_return));
 }
 #endif
 
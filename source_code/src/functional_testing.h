@@ -26,6 +26,48 @@
 #ifndef FUNCTIONAL_TESTING_H_
 #define FUNCTIONAL_TESTING_H_
 
+#ifdef MINI_FEATURE_FAST_FUNCTIONAL_TEST
+// USER_PARAM_INIT_KEY_PARAM value set by the test script to select the fast functional test
+#define FUNC_TEST_FAST_MODE_KEY         0xCB
+
+// Fast functional test check bits
+#define FUNC_TEST_CHK_FLASH_ID          0x01
+#define FUNC_TEST_CHK_FLASH_PATTERN     0x02
+#define FUNC_TEST_CHK_ACC_SELF_TEST     0x04
+#define FUNC_TEST_CHK_LEDS              0x08
+#define FUNC_TEST_CHK_INPUTS            0x10
+#define FUNC_TEST_CHK_WHEEL_CLICK       0x20
+#define FUNC_TEST_CHK_WHEEL_SCROLL      0x40
+#define FUNC_TEST_CHK_CARD              0x80
+
+// Flash page used for the pattern test (erased afterwards)
+#define FUNC_TEST_FLASH_PAGE            (PAGE_COUNT - 1)
+// Number of wheel increments (any direction) required from the operator
+#define FUNC_TEST_SCROLL_STEPS          0x20
+// Status line of the operator steps screen
+#define FUNC_TEST_STATUS_LINE_Y         24
+// Maximum time for the non-interactive checks (ms)
+#define FUNC_TEST_AUTOMATED_TIMEOUT     500
+// TIMER_FUNC_TEST period, the test time is counted in a 32 bits ms counter
+#define FUNC_TEST_TIMER_PERIOD          60000
+// Accelerometer self test: samples averaged with and without self test, output change bounds (70mg to 1500mg at 0.061mg/LSB)
+#define FUNC_TEST_ACC_NB_SAMPLES        4
+#define FUNC_TEST_ACC_NB_DISCARDED      2
+#define FUNC_TEST_ACC_ST_MIN_DELTA      1148
+#define FUNC_TEST_ACC_ST_MAX_DELTA      24590
+
+// Structured fast functional test report, sent with CMD_FUNCTIONAL_TEST_RES
+typedef struct __attribute__((packed))
+{
+    uint8_t global_result;          // RETURN_OK or RETURN_NOK, same as the legacy one byte report
+    uint8_t failed_checks;          // FUNC_TEST_CHK_xxx bitmask
+    uint8_t skipped_checks;         // FUNC_TEST_CHK_xxx bitmask of the checks not available on this hardware
+    int16_t acc_self_test_delta[3]; // Accelerometer self test output change (X, Y, Z), raw LSBs
+    uint16_t automated_checks_ms;   // Time taken by the non-interactive checks
+    uint32_t total_ms;              // Time taken by the complete test, operator steps included
+} funcTestReport_t;
+#endif
+
 RET_TYPE electricalJumpToBootloaderCondition(void);
 void mooltipassStandardElectricalTest(uint8_t fuse_ok);
 void mooltipassMiniFunctionalTest(uint8_t flash_init_result, uint8_t mini_inputs_result);
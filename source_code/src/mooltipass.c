@@ -112,6 +112,47 @@ void reboot_platform(void)
     while(1);
 }
 
+#ifdef USB_FEATURE_SUSPEND_POWER_DOWN
+/*! \fn     powerDownUntilUsbResume(void)
+*   \brief  Power down the peripherals & sleep until the host resumes the USB bus
+*   \note   The screen contents are kept by the OLED controller, nothing is redrawn on resume
+*/
+static void powerDownUntilUsbResume(void)
+{
+    /* Screen & lights off, touch controller & flash in their low power modes */
+    guiSuspendUserInterface();
+    #if defined(HARDWARE_OLIVIER_V1)
+        touchSensingSleep();
+    #elif defined(HARDWARE_MINI_CLICK_V2)
+        miniAccelerometerPowerDown();
+    #endif
+    flashDeepPowerDown();
+
+    /* The watchdog would reset us during the sleep */
+    wdt_reset();
+    wdt_clear_flag();
+    wdt_change_enable();
+    wdt_stop();
+
+    usbSleepUntilResume();
+
+    /* Back from sleep: restore the peripherals */
+    wdt_reset();
+    wdt_clear_flag();
+    wdt_change_enable();
+    wdt_enable_2s();
+    flashResumeFromDeepPowerDown();
+    #if defined(HARDWARE_OLIVIER_V1)
+        touchSensingWakeUp();
+    #elif defined(HARDWARE_MINI_CLICK_V2)
+        miniAccelerometerPowerUp();
+    #endif
+
+    /* Screen & lights will be switched back on by the activity detected routine */
+    act_detected_flag = TRUE;
+}
+#endif
+
 /*! \fn     main(void)
 *   \brief  Main function
 */
@@ -501,27 +542,49 @@ int main(void)
         #endif
         
         /* If the USB bus is in suspend (computer went to sleep), lock device */
-        if ((hasTimerExpired(TIMER_USB_SUSPEND, TRUE) == TIMER_EXPIRED) && (getSmartCardInsertedUnlocked() == TRUE))
+        if ((hasTimerExpired(TIMER_USB_SUSPEND, FALSE) == TIMER_EXPIRED) && (getSmartCardInsertedUnlocked() == TRUE))
         {
             handleSmartcardRemoved();
-            guiDisplayInformationOnScreenAndWait(ID_STRING_PC_SLEEP);
-            guiSetCurrentScreen(SCREEN_DEFAULT_INSERTED_LCK);
-            /* If the screen saver is on, clear screen contents */
-            #if !defined(DISABLE_SCREENSAVER)
-            if(isScreenSaverOn() == TRUE)
+            #ifdef GUI_FEATURE_TOAST_SCREENS
+            /* Screen saver off: inform the user without stalling the main loop */
+            if (isScreenSaverOn() == FALSE)
             {
-                #ifndef MINI_VERSION
-                    oledClear();
-                    oledDisplayOtherBuffer();
-                    oledClear();
-                #endif
+                guiSetCurrentScreen(SCREEN_DEFAULT_INSERTED_LCK);
+                guiDisplayInformationOnScreenToast(ID_STRING_PC_SLEEP);
             }
             else
+            #endif
+            {
+                guiDisplayInformationOnScreenAndWait(ID_STRING_PC_SLEEP);
+                guiSetCurrentScreen(SCREEN_DEFAULT_INSERTED_LCK);
+                /* If the screen saver is on, clear screen contents */
+                #if !defined(DISABLE_SCREENSAVER)
+                if(isScreenSaverOn() == TRUE)
+                {
+                    #ifndef MINI_VERSION
+                        oledClear();
+                        oledDisplayOtherBuffer();
+                        oledClear();
+                    #endif
+                }
+                else
+                {
+                    guiGetBackToCurrentScreen();                
+                }
+                #else /* DISABLE_SCREENSAVER */
+                guiGetBackToCurrentScreen();
+                #endif
+            }
+        }
+        
+        /* Bus still suspended once the suspend timer expired: power down until the host resumes it */
+        if (hasTimerExpired(TIMER_USB_SUSPEND, TRUE) == TIMER_EXPIRED)
+        {
+            #ifdef USB_FEATURE_SUSPEND_POWER_DOWN
+            if ((usbIsSuspended() == TRUE) && (isUsbConfigured() != 0))
             {
-                guiGetBackToCurrentScreen();                
+                powerDownUntilUsbResume();
             }
-            #else /* DISABLE_SCREENSAVER */
-            guiGetBackToCurrentScreen();
             #endif
         }
         
@@ -549,9 +612,14 @@ int main(void)
             }
             
             /* Set correct screen */
-            guiDisplayInformationOnScreenAndWait(ID_STRING_CARD_REMOVED);
-            guiSetCurrentScreen(SCREEN_DEFAULT_NINSERTED);
-            guiGetBackToCurrentScreen();
+            #ifdef GUI_FEATURE_TOAST_SCREENS
+                guiSetCurrentScreen(SCREEN_DEFAULT_NINSERTED);
+                guiDisplayInformationOnScreenToast(ID_STRING_CARD_REMOVED);
+            #else
+                guiDisplayInformationOnScreenAndWait(ID_STRING_CARD_REMOVED);
+                guiSetCurrentScreen(SCREEN_DEFAULT_NINSERTED);
+                guiGetBackToCurrentScreen();
+            #endif
         }
         
         #ifdef TWO_CAPS_TRICK
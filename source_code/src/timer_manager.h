@@ -48,7 +48,7 @@ typedef struct
 
 // Defines
 #ifdef MINI_VERSION
-    #define NUMBER_OF_FAST_TIMERS   9
+    #define NUMBER_OF_FAST_TIMERS   11
     #define TIMER_SCREEN            0
     #define TIMER_USERINT           1
     #define TIMER_CAPS              2
@@ -58,11 +58,13 @@ typedef struct
     #define TIMER_USB_SUSPEND       6
     #define TIMER_REBOOT            7
     #define TIMER_FLASHING          8
+    #define TIMER_TOAST             9
+    #define TIMER_FUNC_TEST         10
 
     #define NUMBER_OF_SLOW_TIMERS   1
-    #define SLOW_TIMER_LOCKOUT      9
+    #define SLOW_TIMER_LOCKOUT      11
 #else
-    #define NUMBER_OF_FAST_TIMERS   10
+    #define NUMBER_OF_FAST_TIMERS   12
     #define TIMER_LIGHT             0
     #define TIMER_SCREEN            1
     #define TIMER_USERINT           2
@@ -73,9 +75,11 @@ typedef struct
     #define TIMER_TOUCH_INHIBIT     7
     #define TIMER_USB_SUSPEND       8
     #define TIMER_REBOOT            9
+    #define TIMER_TOUCH_SETTLE      10
+    #define TIMER_TOAST             11
 
     #define NUMBER_OF_SLOW_TIMERS   1
-    #define SLOW_TIMER_LOCKOUT      10
+    #define SLOW_TIMER_LOCKOUT      12
 #endif
 
 #define TOTAL_NUMBER_OF_TIMERS  (NUMBER_OF_FAST_TIMERS+NUMBER_OF_SLOW_TIMERS)
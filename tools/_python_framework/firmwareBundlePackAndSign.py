@@ -29,9 +29,22 @@ from Crypto import Random
 from array import array
 from os import listdir
 from struct import *
+import zlib
 import sys
 import os
 
+def bundleWriteManifest(updateFileData, manifestFileName, flashPageLength, verbose):
+	# The manifest contains the flash page length it was made for (2 bytes), then the CRC32 of each flash page of the update file, used by the device to report which pages differ
+	# Flash pages are 264 bytes long on 1Mb to 8Mb chips, 528 bytes long on 16Mb & 32Mb chips: the device refuses a manifest made for another length
+	manifest_data = array('B', pack('<H', flashPageLength))
+	for i in range(0, len(updateFileData), flashPageLength):
+		manifest_data.extend(array('B', pack('<I', zlib.crc32(buffer(updateFileData[i:i+flashPageLength])) & 0xFFFFFFFF)))
+	data_fd = open(manifestFileName, 'wb')
+	data_fd.write(manifest_data)
+	data_fd.close()
+	if verbose == True:
+		print "Manifest file written:", (len(manifest_data)-2)/4, "pages of", flashPageLength, "bytes"
+
 def bundlePackAndSign(bundleName, firmwareName, oldAesKey, newAesKey, updateFileName, verbose):
 	# Rather than at the beginning of the files, constants are here
 	VERSION_LENGTH = 4									# FW version length
@@ -40,6 +53,7 @@ def bundlePackAndSign(bundleName, firmwareName, oldAesKey, newAesKey, updateFile
 	FW_VERSION_LENGTH = 4								# Length of the firmware version in the bundle
 	AES_KEY_UPDATE_FLAG_LGTH = 1						# Length of the tag which specifies a firmware udpate
 	FW_MAX_LENGTH = 28672								# Maximum firmware length, depends on size allocated to bootloader
+	MINI_FLASH_PAGE_LENGTH = 264						# Length in bytes of a mini external flash page
 	FLASH_SECTOR_0_LENGTH = 264*8						# Length in bytes of sector 0a in external flash (to change for 16Mb & 32Mb flash!)
 	STORAGE_SPACE = 65536 - FLASH_SECTOR_0_LENGTH		# Uint16_t addressing space - sector 0a length (dedicated to other storage...)
 	BUNDLE_MAX_LENGTH = STORAGE_SPACE - FW_MAX_LENGTH - HASH_LENGH - AES_KEY_LENGTH - FW_VERSION_LENGTH - AES_KEY_UPDATE_FLAG_LGTH
@@ -197,6 +211,9 @@ def bundlePackAndSign(bundleName, firmwareName, oldAesKey, newAesKey, updateFile
 	data_fd.close()
 	if verbose == True:
 		print "Update file written!"
+		
+	# Write the page manifest used for differential updates, signed update files are for the mini whose flash chips have 264 bytes pages
+	bundleWriteManifest(update_file_data, updateFileName + ".manifest", MINI_FLASH_PAGE_LENGTH, verbose)
 	return True
 	
 	# Re read our file to make sure of its length
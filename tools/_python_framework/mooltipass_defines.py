@@ -51,6 +51,14 @@ UID_KEY_SIZE				= 6
 AES_KEY_SIZE				= 32
 AES_BLOCK_SIZE				= 16
 
+# Functional test: USER_PARAM_INIT_KEY_PARAM values starting the legacy / fast test
+FUNC_TEST_LEGACY_MODE_KEY	= 0xBB
+FUNC_TEST_FAST_MODE_KEY		= 0xCB
+
+# Fast functional test report (funcTestReport_t): global result, failed & skipped checks, acc self test deltas, automated checks ms, total ms
+FUNC_TEST_REPORT_FORMAT		= "<BBBhhhHI"
+FUNC_TEST_CHECK_NAMES		= ["flash id", "flash pattern", "accelerometer self test", "leds", "inputs", "wheel click", "wheel scroll", "card"]
+
 # Command IDs
 CMD_EXPORT_FLASH_START  = 0x8A
 CMD_EXPORT_FLASH        = 0x8B
@@ -131,4 +139,7 @@ CMD_GET_FREE_NB_USR_SLT	= 0xD7
 CMD_SET_DESCRIPTION		= 0xD8
 CMD_LOCK_DEVICE			= 0xD9
 CMD_GET_MINI_SERIAL		= 0xDA
-CMD_UNLOCK_WITH_PIN		= 0xDB
\ No newline at end of file
+CMD_UNLOCK_WITH_PIN		= 0xDB
+CMD_IMPORT_MEDIA_STATUS	= 0xDC
+CMD_IMPORT_MEDIA_DIFF	= 0xDD
+CMD_IMPORT_MEDIA_SEEK	= 0xDE
\ No newline at end of file
@@ -23,6 +23,7 @@
 # CDDL HEADER END
 from mooltipass_defines import *
 from generic_hid_device import *
+from Crypto.Cipher import AES
 from array import array
 import struct
 import random
@@ -124,6 +125,25 @@ class mooltipass_hid_device:
 		serial_data = self.device.receiveHidPacket()[DATA_INDEX:DATA_INDEX+4]
 		return serial_data
 		
+	# Check a functional test result packet, print the fast functional test report if it is one
+	def checkFunctionalTestResult(self, packet):
+		if packet[CMD_INDEX] != CMD_FUNCTIONAL_TEST_RES:
+			return False
+		
+		# Legacy test: one byte, 0 when the test passed
+		if packet[LEN_INDEX] < struct.calcsize(FUNC_TEST_REPORT_FORMAT):
+			return packet[DATA_INDEX] == 0
+		
+		result, failed, skipped, acc_x, acc_y, acc_z, automated_ms, total_ms = struct.unpack(FUNC_TEST_REPORT_FORMAT, packet[DATA_INDEX:DATA_INDEX+struct.calcsize(FUNC_TEST_REPORT_FORMAT)].tostring())
+		for i in range(0, len(FUNC_TEST_CHECK_NAMES)):
+			if failed & (1 << i):
+				print "failed check:", FUNC_TEST_CHECK_NAMES[i]
+			if skipped & (1 << i):
+				print "skipped check:", FUNC_TEST_CHECK_NAMES[i]
+		print "accelerometer self test deltas:", acc_x, acc_y, acc_z
+		print "automated checks:", automated_ms, "ms, total:", total_ms, "ms"
+		return result == 0
+		
 	# Get the Mooltipass UID
 	def getUID(self, req_key):
 		key = array('B', req_key.decode("hex"))
@@ -481,6 +501,152 @@ class mooltipass_hid_device:
 
 		return success_status
 		
+	# Upload only the bundle pages that differ from the device flash contents, using the manifest generated by the packing script
+	def uploadBundleDiff(self, password, filename, verbose):
+		MEDIA_DIFF_MAX_PAGES = 14
+		mooltipass_variant = self.getMooltipassVersionAndVariant()[2]
+		
+		# Check that the update & manifest files are here
+		if not os.path.isfile(filename) or not os.path.isfile(filename + ".manifest"):
+			print "Couldn't find update or manifest file"
+			return False
+		fd = open(filename, 'rb')
+		update_file = fd.read()
+		fd.close()
+		fd = open(filename + ".manifest", 'rb')
+		manifest = fd.read()
+		fd.close()
+		
+		# Manifest header: flash page length the digests were computed for, sent with each request so the device can refuse a mismatch
+		flash_page_length = struct.unpack('<H', manifest[0:2])[0]
+		manifest = manifest[2:]
+		nb_pages = len(manifest)/4
+		
+		# Prepare the import media start packet
+		if len(password) != DEVICE_PASSWORD_SIZE*2 and len(password) != MINI_DEVICE_PASSWORD_SIZE*2:
+			print "Erroneous password length for password:", len(password)/2
+			return False
+		start_packet = array('B')
+		start_packet.append(len(password)/2)
+		start_packet.append(CMD_IMPORT_MEDIA_START)
+		for i in range(len(password)/2):
+			start_packet.append(int(password[i*2:i*2+2], 16))
+		self.device.sendHidPacket(start_packet)
+		if self.device.receiveHidPacket()[DATA_INDEX] != 0x01:
+			if verbose:
+				print "fail!!!"
+			return False
+		
+		# Ask the device which pages differ
+		pages_to_send = []
+		for first_page in range(0, nb_pages, MEDIA_DIFF_MAX_PAGES):
+			nb_digests = min(MEDIA_DIFF_MAX_PAGES, nb_pages - first_page)
+			packet = array('B', [4 + nb_digests*4, CMD_IMPORT_MEDIA_DIFF, flash_page_length & 0xFF, flash_page_length >> 8, first_page & 0xFF, first_page >> 8])
+			packet.extend(array('B', manifest[first_page*4:(first_page+nb_digests)*4]))
+			self.device.sendHidPacket(packet)
+			answer = self.device.receiveHidPacket()
+			if answer[DATA_INDEX] != 0x01:
+				print "Error in page diff, check that the manifest was made for the", flash_page_length, "bytes flash pages of this device"
+				return False
+			bitmask = answer[DATA_INDEX+1] + (answer[DATA_INDEX+2] << 8)
+			for i in range(nb_digests):
+				if bitmask & (1 << i):
+					pages_to_send.append(first_page + i)
+		if verbose == True:
+			print "Sending", len(pages_to_send), "pages out of", nb_pages
+			
+		# Send the pages that differ
+		for page in pages_to_send:
+			self.device.sendHidPacket([4, CMD_IMPORT_MEDIA_SEEK, flash_page_length & 0xFF, flash_page_length >> 8, page & 0xFF, page >> 8])
+			if self.device.receiveHidPacket()[DATA_INDEX] != 0x01:
+				print "Error in page seek"
+				return False
+			page_data = update_file[page*flash_page_length:(page+1)*flash_page_length]
+			for i in range(0, len(page_data), 33):
+				packet = array('B', [len(page_data[i:i+33]), CMD_IMPORT_MEDIA])
+				packet.extend(array('B', page_data[i:i+33]))
+				self.device.sendHidPacket(packet)
+				if self.device.receiveHidPacket()[DATA_INDEX] != 0x01:
+					print "Error in upload"
+					return False
+					
+		# Inform we sent everything, the mini reboots to authenticate the complete image
+		self.device.sendHidPacket([0, CMD_IMPORT_MEDIA_END])
+		if mooltipass_variant != "mini":
+			return self.device.receiveHidPacket()[DATA_INDEX] == 0x01
+		return True
+		
+	# Resume an interrupted bundle upload from the last page programmed by the device, do a complete upload if the device contents don't match the bundle
+	def uploadBundleResume(self, password, filename, verbose):
+		mooltipass_variant = self.getMooltipassVersionAndVariant()[2]
+		
+		# Check that the update file is here
+		if filename is None or not os.path.isfile(filename):
+			print "Couldn't find update file"
+			return False
+		fd = open(filename, 'rb')
+		update_file = fd.read()
+		fd.close()
+		
+		# Prepare the import media start packet
+		if password is None or (len(password) != DEVICE_PASSWORD_SIZE*2 and len(password) != MINI_DEVICE_PASSWORD_SIZE*2):
+			print "Erroneous password"
+			return False
+		start_packet = array('B')
+		start_packet.append(len(password)/2)
+		start_packet.append(CMD_IMPORT_MEDIA_START)
+		for i in range(len(password)/2):
+			start_packet.append(int(password[i*2:i*2+2], 16))
+		self.device.sendHidPacket(start_packet)
+		if self.device.receiveHidPacket()[DATA_INDEX] != 0x01:
+			if verbose:
+				print "fail!!!"
+			return False
+		
+		# Ask the device where to resume from, the checkpoint is read back from flash a few pages per request
+		resume_offset = 16
+		mac_length = 0
+		while mac_length + 16 <= resume_offset:
+			self.device.sendHidPacket([0, CMD_IMPORT_MEDIA_STATUS])
+			answer = self.device.receiveHidPacket()
+			if answer[DATA_INDEX] != 0x01:
+				print "Error in import status"
+				return False
+			resume_offset = 0
+			mac_length = 0
+			for i in range(4):
+				resume_offset += answer[DATA_INDEX+1+i] << (8*i)
+				mac_length += answer[DATA_INDEX+5+i] << (8*i)
+		device_mac = answer[DATA_INDEX+9:DATA_INDEX+25].tostring()
+		
+		# Compute the checkpoint over our bundle: AES-256 CBCMAC, zero key & IV
+		cipher = AES.new(chr(0)*32, AES.MODE_ECB)
+		bundle_mac = chr(0)*16
+		for i in range(0, mac_length, 16):
+			block = update_file[i:i+16].ljust(16, chr(0xFF))
+			bundle_mac = cipher.encrypt(''.join(chr(ord(a) ^ ord(b)) for a, b in zip(bundle_mac, block)))
+		if resume_offset > len(update_file) or mac_length > len(update_file) or bundle_mac != device_mac:
+			if verbose == True:
+				print "Device contents don't match the bundle, doing a complete upload"
+			return self.uploadBundle(password, filename, verbose)
+		if verbose == True:
+			print "Resuming upload at byte", resume_offset, "out of", len(update_file)
+		
+		# Send the remaining bytes
+		for i in range(resume_offset, len(update_file), 33):
+			packet = array('B', [len(update_file[i:i+33]), CMD_IMPORT_MEDIA])
+			packet.extend(array('B', update_file[i:i+33]))
+			self.device.sendHidPacket(packet)
+			if self.device.receiveHidPacket()[DATA_INDEX] != 0x01:
+				print "Error in upload"
+				return False
+				
+		# Inform we sent everything, the mini reboots to authenticate the complete image
+		self.device.sendHidPacket([0, CMD_IMPORT_MEDIA_END])
+		if mooltipass_variant != "mini":
+			return self.device.receiveHidPacket()[DATA_INDEX] == 0x01
+		return True
+		
 	def checkSecuritySettings(self):
 		correct_password = raw_input("Enter mooltipass password: ")
 		correct_key = raw_input("Enter request key: ")
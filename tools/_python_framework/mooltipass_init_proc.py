@@ -122,7 +122,7 @@ def mpmInitGetPacketForCommand(cmd, len, data):
 		
 	return arraytosend
 
-def mooltipassMiniInit(mooltipass_device):	
+def mooltipassMiniInit(mooltipass_device, fast_test=False):	
 	# Check for public key
 	if not os.path.isfile("publickey.bin"):
 		print "Couldn't find public key!"
@@ -200,7 +200,10 @@ def mooltipassMiniInit(mooltipass_device):
 				sys.stdout.flush()
 				magic_key = array('B')
 				magic_key.append(0)
-				magic_key.append(187)
+				if fast_test:
+					magic_key.append(FUNC_TEST_FAST_MODE_KEY)
+				else:
+					magic_key.append(FUNC_TEST_LEGACY_MODE_KEY)
 				mooltipass_device.getInternalDevice().sendHidPacket(mpmInitGetPacketForCommand(CMD_SET_MOOLTIPASS_PARM, 2, magic_key))
 				if mooltipass_device.getInternalDevice().receiveHidPacket()[DATA_INDEX] == 0x01:
 					success_status = True
@@ -249,7 +252,7 @@ def mooltipassMiniInit(mooltipass_device):
 						sys.stdout.write('.')
 						sys.stdout.flush()
 					else:
-						if test_result[CMD_INDEX] == CMD_FUNCTIONAL_TEST_RES and test_result[DATA_INDEX] == 0:
+						if mooltipass_device.checkFunctionalTestResult(test_result):
 							success_status = True
 							print " ok!"
 						else:
@@ -91,7 +91,7 @@ def checkPrintStatus():
 		print "|!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!|"
 		raw_input("Press enter once done:")
 							
-def mooltipassMiniMassProdInit(mooltipass_device):		
+def mooltipassMiniMassProdInit(mooltipass_device, fast_test=False):		
 	# Check for update bundle
 	if not os.path.isfile("bundle.img"):
 		print "Couldn't find data file!"
@@ -139,7 +139,10 @@ def mooltipassMiniMassProdInit(mooltipass_device):
 			if success_status == True:
 				magic_key = array('B')
 				magic_key.append(0)
-				magic_key.append(187)
+				if fast_test:
+					magic_key.append(FUNC_TEST_FAST_MODE_KEY)
+				else:
+					magic_key.append(FUNC_TEST_LEGACY_MODE_KEY)
 				mooltipass_device.getInternalDevice().sendHidPacket(mpmMassProdInitGetPacketForCommand(CMD_SET_MOOLTIPASS_PARM, 2, magic_key))
 				if mooltipass_device.getInternalDevice().receiveHidPacket()[DATA_INDEX] == 0x01:
 					success_status = True
@@ -160,7 +163,7 @@ def mooltipassMiniMassProdInit(mooltipass_device):
 						sys.stdout.write('.')
 						sys.stdout.flush()
 					else:
-						if test_result[CMD_INDEX] == CMD_FUNCTIONAL_TEST_RES and test_result[DATA_INDEX] == 0:
+						if mooltipass_device.checkFunctionalTestResult(test_result):
 							success_status = True
 							print " ok!"
 						else:
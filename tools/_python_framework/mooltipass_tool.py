@@ -25,6 +25,9 @@
 #                                  COMMAND EXAMPLES                                                                             #
 #                                                                                                                               #
 # Upload new bundle to device: mooltipass_tool.py uploadBundle updatefile.img <password>                                        #
+# Upload changed bundle pages only: mooltipass_tool.py uploadBundleDiff updatefile.img password                                 #
+# Write a bundle manifest (528 for 16Mb & 32Mb flash): mooltipass_tool.py bundleManifest bundle.img 264                         #
+# Resume an interrupted bundle upload: mooltipass_tool.py uploadBundleResume updatefile.img password                            #
 # Generate signed firmware: mooltipass_tool.py packAndSign bundleName firmwareName oldAesKey (newAesKey) updateFileName         #
 # Generate and upload signed firmware: mooltipass_tool.py packSignUpload bundleName firmwareName oldAesKey (newAesKey) password #
 # Initialize Mooltipass: mooltipass_tool.py init bundleName                                                                     #
@@ -89,6 +92,26 @@ def main():
 			# start upload
 			mooltipass_device.uploadBundle(password, filename, True)
 			
+		if sys.argv[1] == "uploadBundleDiff":
+			if len(sys.argv) > 3:
+				mooltipass_device.uploadBundleDiff(sys.argv[3], sys.argv[2], True)
+			else:
+				print "uploadBundleDiff: not enough args!"
+			
+		if sys.argv[1] == "bundleManifest":
+			if len(sys.argv) > 3:
+				fd = open(sys.argv[2], 'rb')
+				firmwareBundlePackAndSign.bundleWriteManifest(fd.read(), sys.argv[2] + ".manifest", int(sys.argv[3]), True)
+				fd.close()
+			else:
+				print "bundleManifest: not enough args!"
+			
+		if sys.argv[1] == "uploadBundleResume":
+			if len(sys.argv) > 3:
+				mooltipass_device.uploadBundleResume(sys.argv[3], sys.argv[2], True)
+			else:
+				print "uploadBundleResume: not enough args!"
+			
 		if sys.argv[1] == "packAndSign":
 			if len(sys.argv) > 5:
 				# Depending on number of args, set a new password or not
@@ -123,13 +146,13 @@ def main():
 		
 		if sys.argv[1] == "initproc":
 			if version_data[2] == "mini":
-				mooltipassMiniInit(mooltipass_device)
+				mooltipassMiniInit(mooltipass_device, len(sys.argv) > 2 and sys.argv[2] == "fast")
 			else:
 				print "Device Not Supported"
 				
 		if sys.argv[1] == "massprodinit":
 			if version_data[2] == "mini":
-				mooltipassMiniMassProdInit(mooltipass_device)
+				mooltipassMiniMassProdInit(mooltipass_device, len(sys.argv) > 2 and sys.argv[2] == "fast")
 			else:
 				print "Device Not Supported"		
 
@@ -11,16 +11,20 @@ import string
 import pickle
 import copy
 import time
+import zlib
 import sys
 import os
 from keyboard import *
 
 USB_VID                 = 0x16D0
 USB_PID                 = 0x09A0
+MGMT_BULK_INTF_CLASS    = 0xFF
 
 LEN_INDEX               = 0x00
 CMD_INDEX               = 0x01
 DATA_INDEX              = 0x02
+HID_LEN_TAG_SHIFT       = 6
+HID_LEN_MASK            = 0x3F
 PREV_ADDRESS_INDEX      = 0x02
 NEXT_ADDRESS_INDEX      = 0x04
 NEXT_CHILD_INDEX        = 0x06
@@ -83,7 +87,10 @@ CMD_SET_DATA_SERVICE    = 0xBE
 CMD_ADD_DATA_SERVICE    = 0xBF
 CMD_WRITE_32B_IN_DN     = 0xC0
 CMD_READ_32B_IN_DN      = 0xC1
+DATA_PACKET_LAST_FLAG        = 0x01
+DATA_ENCODING_COMPRESSED     = 0x02
 CMD_GET_CUR_CPZ		    = 0xC2
+CMD_PLEASE_RETRY        = 0xC4
 CMD_READ_FLASH_NODE     = 0xC5
 CMD_WRITE_FLASH_NODE    = 0xC6
 CMD_GET_FAVORITE        = 0xC7
@@ -101,6 +108,8 @@ CMD_SET_DN_START_PARENT = 0xD2
 CMD_END_MEMORYMGMT      = 0xD3
 CMD_GET_DESCRIPTION		= 0xD4
 CMD_UNLOCK_WITH_PIN		= 0xD5
+CMD_SET_DATA_ENCODING   = 0xE4
+CMD_GET_DATA_ENCODING   = 0xE5
 
 def keyboardSend(epout, data1, data2):
 	packetToSend = array('B')
@@ -275,6 +284,42 @@ def sendHidPacket(epout, cmd, len, data):
 	# send data
 	epout.write(arraytosend)
 
+def sendTaggedHidPacket(epout, tag, cmd, len, data):
+	# The request tag (1 to 3) is sent in the upper bits of the length field, answers carry it back
+	sendHidPacket(epout, cmd, len | (tag << HID_LEN_TAG_SHIFT), data)
+
+def pingThroughput(epin, epout):
+	nb_pings = 300
+	ping_packet = array('B', [1, 2, 3, 4])
+	
+	# One request, one answer
+	time1 = time.time()
+	for i in range(0, nb_pings):
+		sendHidPacket(epout, CMD_PING, 4, ping_packet)
+		receiveHidPacket(epin)
+	time2 = time.time()
+	print nb_pings, "untagged pings took", (time2 - time1)*1000.0, "ms"
+	
+	# Keep 3 tagged requests in flight
+	time1 = time.time()
+	in_flight = []
+	sent = 0
+	while sent < nb_pings or len(in_flight) != 0:
+		if sent < nb_pings and len(in_flight) < 3:
+			tag = [t for t in (1, 2, 3) if t not in in_flight][0]
+			sendTaggedHidPacket(epout, tag, CMD_PING, 4, ping_packet)
+			in_flight.append(tag)
+			sent = sent + 1
+		else:
+			answer = receiveHidPacket(epin)
+			tag = answer[LEN_INDEX] >> HID_LEN_TAG_SHIFT
+			if answer[CMD_INDEX] == CMD_PLEASE_RETRY:
+				print "Request", tag, "refused"
+			if tag in in_flight:
+				in_flight.remove(tag)
+	time2 = time.time()
+	print nb_pings, "tagged pings took", (time2 - time1)*1000.0, "ms"
+
 def sendCustomPacket(epin, epout):
 	command = raw_input("CMD ID: ")
 	packet = array('B')
@@ -909,24 +954,85 @@ def getDecodedDataForService(epin, epout):
 
 	# Check that the context doesn't exist
 	sendHidPacket(epout, CMD_SET_DATA_SERVICE, len(service)+1, array('B', service + b"\x00"))
-	if receiveHidPacket(epin)[DATA_INDEX] == 0x01:
+	answer = receiveHidPacket(epin)
+	if answer[DATA_INDEX] == 0x01:
 		print "Service exists"
 	else:
 		print "Service doesn't exist"
 		return
 	
+	# Compressed data is inflated as the blocks arrive, the padding after the zlib stream is dropped
+	decompressor = None
+	sendHidPacket(epout, CMD_GET_DATA_ENCODING, 0, None)
+	answer = receiveHidPacket(epin)
+	if answer[DATA_INDEX] == 0x01 and answer[DATA_INDEX+1] == DATA_ENCODING_COMPRESSED:
+		print "Data is compressed"
+		decompressor = zlib.decompressobj()
+	
 	time1 = time.time()
 	sendHidPacket(epout, CMD_READ_32B_IN_DN, 0, None)
 	answer = receiveHidPacket(epin)
 	time2 = time.time()
 	while answer[LEN_INDEX] != 1:
-		print answer[DATA_INDEX:DATA_INDEX+32]
+		if decompressor is None:
+			print answer[DATA_INDEX:DATA_INDEX+32]
+		elif decompressor.unused_data == b"":
+			sys.stdout.write(decompressor.decompress(answer[DATA_INDEX:DATA_INDEX+32].tostring()))
 		print "Data received, took", (time2 - time1)*1000.0, "ms"
 		time1 = time.time()
 		sendHidPacket(epout, CMD_READ_32B_IN_DN, 0, None)
 		answer = receiveHidPacket(epin)
 		time2 = time.time()
 		
+def addFileForService(epin, epout):
+	service = raw_input("Service name: ")
+	filename = raw_input("File name: ")
+	compress = raw_input("Compress the file (y/n): ") == "y"
+	print "Please accept prompts on the Mooltipass"
+	
+	with open(filename, 'rb') as f:
+		file_data = f.read()
+	if compress:
+		# Compressed before the device encrypts it, the zlib stream end marks the end of the data
+		payload = zlib.compress(file_data, 9)
+		print "Compressed", len(file_data), "bytes to", len(payload), "bytes"
+	else:
+		payload = file_data
+	payload = payload + b"\x00" * ((32 - len(payload) % 32) % 32)
+	
+	# Set context, add the service if it doesn't exist
+	sendHidPacket(epout, CMD_SET_DATA_SERVICE, len(service)+1, array('B', service + b"\x00"))
+	if receiveHidPacket(epin)[DATA_INDEX] != 0x01:
+		sendHidPacket(epout, CMD_ADD_DATA_SERVICE, len(service)+1, array('B', service + b"\x00"))
+		if receiveHidPacket(epin)[DATA_INDEX] != 0x01:
+			print "Couldn't add service"
+			return
+		sendHidPacket(epout, CMD_SET_DATA_SERVICE, len(service)+1, array('B', service + b"\x00"))
+		if receiveHidPacket(epin)[DATA_INDEX] != 0x01:
+			print "Service couldn't be set"
+			return
+	
+	# Opt in for the compressed encoding, raw otherwise
+	if compress:
+		sendHidPacket(epout, CMD_SET_DATA_ENCODING, 1, array('B', [DATA_ENCODING_COMPRESSED]))
+		if receiveHidPacket(epin)[DATA_INDEX] != 0x01:
+			print "Device doesn't support compressed data"
+			return
+	
+	time1 = time.time()
+	for i in range(0, len(payload), 32):
+		data_packet = array('B')
+		flags = 0
+		if i + 32 == len(payload):
+			flags |= DATA_PACKET_LAST_FLAG
+		data_packet.append(flags)
+		data_packet.extend(array('B', payload[i:i+32]))
+		sendHidPacket(epout, CMD_WRITE_32B_IN_DN, 32 + 1, data_packet)
+		if receiveHidPacket(epin)[DATA_INDEX] != 0x01:
+			print "Data couldn't be sent"
+			return
+	print len(payload)/32, "blocks sent, took", (time.time() - time1)*1000.0, "ms"
+		
 def addRandomDataForService(epin, epout):
 	tempPacket = array('B')
 	service = raw_input("Service name: ")
@@ -1691,9 +1797,13 @@ def findHIDDevice(vendor_id, product_id, print_debug):
 	#		for ep in intf:
 	#			print "endpoint addr:", str(ep.bEndpointAddress)
 
-	# Get an endpoint instance
+	# Get an endpoint instance: bulk management interface (vendor class) if the firmware exposes it, raw hid interface otherwise
 	cfg = hid_device.get_active_configuration()
-	intf = cfg[(0,0)]
+	intf = usb.util.find_descriptor(cfg, bInterfaceClass=MGMT_BULK_INTF_CLASS)
+	if intf is None:
+		intf = cfg[(0,0)]
+	elif print_debug:
+		print "Using the bulk management interface"
 
 	# Match the first OUT endpoint
 	epout = usb.util.find_descriptor(intf, custom_match = lambda e: usb.util.endpoint_direction(e.bEndpointAddress) == usb.util.ENDPOINT_OUT)
@@ -1820,6 +1930,8 @@ if __name__ == '__main__':
 		print "40) Try to unlock device with PIN"
 		print "41) Unknown card: get current CPZ"
 		print "42) Mooltipass mini: set contrast current"
+		print "43) Store a file in a data service"
+		print "44) Untagged vs tagged requests throughput"
 		choice = input("Make your choice: ")
 		print ""
 
@@ -1943,6 +2055,10 @@ if __name__ == '__main__':
 				print ''.join('{:d} '.format(x) for x in data[DATA_INDEX:DATA_INDEX+data[LEN_INDEX]])
 		elif choice == 42:
 			setGenericParameter(epin, epout, 26)
+		elif choice == 43:
+			addFileForService(epin, epout)
+		elif choice == 44:
+			pingThroughput(epin, epout)
 
 	hid_device.reset()
 
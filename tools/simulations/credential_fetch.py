@@ -0,0 +1,44 @@
+#!/usr/bin/env python2
+#
+# CDDL HEADER START
+#
+# The contents of this file are subject to the terms of the
+# Common Development and Distribution License (the "License").
+# You may not use this file except in compliance with the License.
+#
+# You can obtain a copy of the license at src/license_cddl-1.0.txt
+# or http://www.opensolaris.org/os/licensing.
+# See the License for the specific language governing permissions
+# and limitations under the License.
+#
+# When distributing Covered Code, include this CDDL HEADER in each
+# file and include the License file at src/license_cddl-1.0.txt
+# If applicable, add the following below this CDDL HEADER, with the
+# fields enclosed by brackets "[]" replaced with your own identifying
+# information: Portions Copyright [yyyy] [name of copyright owner]
+#
+# CDDL HEADER END
+#
+# Device side latency of a login & password fetch, user approval time excluded
+#
+# Plugin flow: CMD_CONTEXT, CMD_GET_LOGIN, CMD_GET_PASSWORD. getLoginForContext() and getPasswordForContext() each
+# call readChildNode(), which rewrites the node with its last used date when the date is known.
+# CMD_GET_CREDENTIAL: one request, one child read & rewrite, the password may follow in a second answer packet.
+#
+# usage: credential_fetch.py
+import random
+
+HID_EXCHANGE_MS = (2.0, 3.0)				# request + answer on 1ms bInterval endpoints, best case
+PAGE_REWRITE_MS = (15.0, 35.0)				# DataFlash page erase + program, datasheet typical to max
+EXTRA_ANSWER_MS = (1.0, 1.0)				# second answer packet, no host request
+RUNS = 100000
+
+def flow(rng, exchanges, rewrites, extra_answers):
+	return sum(rng.uniform(*HID_EXCHANGE_MS) for _ in range(exchanges)) + sum(rng.uniform(*PAGE_REWRITE_MS) for _ in range(rewrites)) + sum(rng.uniform(*EXTRA_ANSWER_MS) for _ in range(extra_answers))
+
+if __name__ == '__main__':
+	rng = random.Random(1)
+	print "flow                              | HID exchanges | child rewrites | latency min / mean / max (ms)"
+	for name, exchanges, rewrites, extra_answers in (("context + login + password", 3, 2, 0), ("CMD_GET_CREDENTIAL, 1 packet", 1, 1, 0), ("CMD_GET_CREDENTIAL, 2 packets", 1, 1, 1), ("3 requests, date unknown", 3, 0, 0), ("CMD_GET_CREDENTIAL, date unknown", 1, 0, 0)):
+		samples = [flow(rng, exchanges, rewrites, extra_answers) for _ in range(RUNS)]
+		print "%-33s | %13d | %14d | %5.1f / %5.1f / %5.1f" % (name, exchanges, rewrites, min(samples), sum(samples) / RUNS, max(samples))
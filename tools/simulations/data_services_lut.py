@@ -0,0 +1,65 @@
+#!/usr/bin/env python2
+#
+# CDDL HEADER START
+#
+# The contents of this file are subject to the terms of the
+# Common Development and Distribution License (the "License").
+# You may not use this file except in compliance with the License.
+#
+# You can obtain a copy of the license at src/license_cddl-1.0.txt
+# or http://www.opensolaris.org/os/licensing.
+# See the License for the specific language governing permissions
+# and limitations under the License.
+#
+# When distributing Covered Code, include this CDDL HEADER in each
+# file and include the License file at src/license_cddl-1.0.txt
+# If applicable, add the following below this CDDL HEADER, with the
+# fields enclosed by brackets "[]" replaced with your own identifying
+# information: Portions Copyright [yyyy] [name of copyright owner]
+#
+# CDDL HEADER END
+#
+# Data parent reads per data service lookup (CMD_SET_DATA_SERVICE), with and without the data services LUT
+#
+# Before: searchForServiceName() walks the data parents from the list head. After: the walk starts from
+# getDataParentNodeForLetter(). Hits look up every existing service, misses 300 random names.
+# Synthetic names: 30% start with "ssh_" and 20% with "totp_", so the 's' and 't' letters hold long runs.
+#
+# usage: data_services_lut.py
+import random, string, bisect
+
+MISSES = 300
+
+def new_name(rng):
+	k = rng.random()
+	prefix = 'ssh_' if k < 0.3 else ('totp_' if k < 0.5 else '')
+	return prefix + ''.join(rng.choice(string.ascii_lowercase) for _ in range(8))
+
+def data_services_lut(services):
+	lut = {}
+	for i, s in enumerate(services):
+		lut.setdefault(s[0], i)
+	return lut
+
+def walk_start(lut, c):
+	# getDataParentNodeForLetter()
+	for l in range(ord(c), ord('a') - 1, -1):
+		if chr(l) in lut:
+			return lut[chr(l)]
+	return 0
+
+def reads(services, name, start):
+	return bisect.bisect_left(services, name) - start + 1
+
+if __name__ == '__main__':
+	rng = random.Random(5)
+	print "data services | hit before | hit after | miss before | miss after"
+	for nb_services in (50, 200, 500):
+		services = sorted(set(new_name(rng) for _ in range(nb_services)))
+		lut = data_services_lut(services)
+		misses = [new_name(rng) for _ in range(MISSES)]
+		hit_before = float(sum(reads(services, s, 0) for s in services)) / len(services)
+		hit_after = float(sum(reads(services, s, walk_start(lut, s[0])) for s in services)) / len(services)
+		miss_before = float(sum(reads(services, s, 0) for s in misses)) / MISSES
+		miss_after = float(sum(reads(services, s, walk_start(lut, s[0])) for s in misses)) / MISSES
+		print "%13d | %10.1f | %9.1f | %11.1f | %10.1f" % (len(services), hit_before, hit_after, miss_before, miss_after)
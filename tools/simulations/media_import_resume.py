@@ -0,0 +1,168 @@
+#!/usr/bin/env python2
+#
+# CDDL HEADER START
+#
+# The contents of this file are subject to the terms of the
+# Common Development and Distribution License (the "License").
+# You may not use this file except in compliance with the License.
+#
+# You can obtain a copy of the license at src/license_cddl-1.0.txt
+# or http://www.opensolaris.org/os/licensing.
+# See the License for the specific language governing permissions
+# and limitations under the License.
+#
+# When distributing Covered Code, include this CDDL HEADER in each
+# file and include the License file at src/license_cddl-1.0.txt
+# If applicable, add the following below this CDDL HEADER, with the
+# fields enclosed by brackets "[]" replaced with your own identifying
+# information: Portions Copyright [yyyy] [name of copyright owner]
+#
+# CDDL HEADER END
+#
+# Interrupted media import (USB_FEATURE_MEDIA_IMPORT_RESUME) against mooltipass_hid_device.uploadBundleResume()
+#
+# A simulated mini keeps the media import state of usb_cmd_parser.c: flash & eeprom survive a reset, RAM doesn't.
+# The upload is cut after a given number of packets, then resumed on a "reset" device. Also checks that values left
+# in the eeprom slot by older firmwares and checkpoints that don't match the bundle lead to a complete upload.
+#
+# usage: media_import_resume.py
+import sys, os, random, tempfile
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '_python_framework'))
+from mooltipass_hid_device import *
+from Crypto.Cipher import AES
+from array import array
+
+BYTES_PER_PAGE = 264						# FLASH_CHIP_4M
+GRAPHIC_ZONE_PAGE_START = 8
+GRAPHIC_ZONE_PAGE_END = 256
+MEDIA_RESUME_EEP_PAGES = 8
+MEDIA_RESUME_EEP_MARKER = 0x05
+MEDIA_RESUME_EEP_MARKER_MASK = 0x07
+MEDIA_RESUME_EEP_MARKER_SHT = 3
+MEDIA_RESUME_MAC_BLOCKS = 64
+
+class SimulatedMini(object):
+	def __init__(self, flash, eeprom):
+		self.flash = flash
+		self.eeprom = eeprom						# [MEDIA_IMPORT_CHECKPOINT_PARAM]
+		self.approved = False
+		self.page = GRAPHIC_ZONE_PAGE_START
+		self.offset = 0
+		self.buffer = bytearray(BYTES_PER_PAGE)
+		self.mac = chr(0)*16
+		self.mac_length = 0
+		self.packets = 0
+		self.status_requests = 0
+		self.max_mac_blocks = 0
+		self.reset_after = None
+		self.answer = None
+
+	def setReadTimeout(self, timeout):
+		pass
+
+	def storeResumePage(self):
+		self.eeprom[0] = (((self.page - GRAPHIC_ZONE_PAGE_START) / MEDIA_RESUME_EEP_PAGES) << MEDIA_RESUME_EEP_MARKER_SHT) | MEDIA_RESUME_EEP_MARKER
+
+	def getResumePage(self):
+		if (self.eeprom[0] & MEDIA_RESUME_EEP_MARKER_MASK) != MEDIA_RESUME_EEP_MARKER:
+			return 0
+		return (self.eeprom[0] >> MEDIA_RESUME_EEP_MARKER_SHT) * MEDIA_RESUME_EEP_PAGES
+
+	def updateCheckpoint(self):
+		cipher = AES.new(chr(0)*32, AES.MODE_ECB)
+		programmed_bytes = (self.page - GRAPHIC_ZONE_PAGE_START) * BYTES_PER_PAGE
+		nb_blocks = 0
+		while self.mac_length + 16 <= programmed_bytes and nb_blocks < MEDIA_RESUME_MAC_BLOCKS:
+			block = str(self.flash[self.mac_length:self.mac_length+16])
+			self.mac = cipher.encrypt(''.join(chr(ord(a) ^ ord(b)) for a, b in zip(self.mac, block)))
+			self.mac_length += 16
+			nb_blocks += 1
+		self.max_mac_blocks = max(self.max_mac_blocks, nb_blocks)
+
+	def sendHidPacket(self, packet):
+		self.packets += 1
+		if self.reset_after is not None and self.packets == self.reset_after:
+			raise IOError("device reset")
+		length, cmd, data = packet[0], packet[1], array('B', packet[2:2+packet[0]]).tostring()
+		answer = [1, cmd, 0x01]
+		if cmd == CMD_IMPORT_MEDIA_START:
+			self.approved = True
+			self.page = GRAPHIC_ZONE_PAGE_START
+			self.offset = 0
+			self.mac = chr(0)*16
+			self.mac_length = 0
+		elif cmd == CMD_IMPORT_MEDIA:
+			self.buffer[self.offset:self.offset+length] = data
+			self.offset += length
+			if self.offset == BYTES_PER_PAGE:
+				bundle_offset = (self.page - GRAPHIC_ZONE_PAGE_START) * BYTES_PER_PAGE
+				self.flash[bundle_offset:bundle_offset+BYTES_PER_PAGE] = self.buffer
+				self.offset = 0
+				self.page += 1
+				if (self.page - GRAPHIC_ZONE_PAGE_START) % MEDIA_RESUME_EEP_PAGES == 0:
+					self.storeResumePage()
+		elif cmd == CMD_IMPORT_MEDIA_STATUS:
+			self.status_requests += 1
+			if self.page == GRAPHIC_ZONE_PAGE_START and self.mac_length == 0:
+				self.page = GRAPHIC_ZONE_PAGE_START + self.getResumePage()
+			self.offset = 0
+			self.updateCheckpoint()
+			self.storeResumePage()
+			resume_offset = (self.page - GRAPHIC_ZONE_PAGE_START) * BYTES_PER_PAGE
+			answer = [25, cmd, 0x01] + [(resume_offset >> (8*i)) & 0xFF for i in range(4)] + [(self.mac_length >> (8*i)) & 0xFF for i in range(4)] + [ord(x) for x in self.mac]
+		elif cmd == CMD_IMPORT_MEDIA_END:
+			if self.offset != 0:
+				bundle_offset = (self.page - GRAPHIC_ZONE_PAGE_START) * BYTES_PER_PAGE
+				self.flash[bundle_offset:bundle_offset+self.offset] = self.buffer[:self.offset]
+			if self.approved:
+				self.eeprom[0] = 0
+			self.approved = False
+		self.answer = array('B', answer + [0]*(64-len(answer)))
+
+	def receiveHidPacket(self):
+		return self.answer
+
+def new_device(flash, eeprom):
+	mooltipass = mooltipass_hid_device()
+	mooltipass.getMooltipassVersionAndVariant = lambda: (0, 0, "mini")
+	mooltipass.device = SimulatedMini(flash, eeprom)
+	return mooltipass
+
+def empty_flash():
+	return bytearray('\xff' * ((GRAPHIC_ZONE_PAGE_END - GRAPHIC_ZONE_PAGE_START) * BYTES_PER_PAGE))
+
+if __name__ == '__main__':
+	random.seed(3)
+	bundle = ''.join(chr(random.randint(0, 255)) for _ in range(40000))
+	bundle_fd, bundle_name = tempfile.mkstemp(suffix='.img')
+	os.write(bundle_fd, bundle)
+	os.close(bundle_fd)
+	password = '00'*16
+	full_upload_packets = 2 + (len(bundle) + 32) / 33
+	failures = 0
+
+	for reset_after in (50, 500, 1000):
+		flash = empty_flash()
+		eeprom = [0]
+		mooltipass = new_device(flash, eeprom)
+		mooltipass.device.reset_after = reset_after
+		try:
+			mooltipass.uploadBundle(password, bundle_name, False)
+		except IOError:
+			pass
+		mooltipass = new_device(flash, eeprom)
+		ok = mooltipass.uploadBundleResume(password, bundle_name, False) and str(flash[:len(bundle)]) == bundle
+		failures += not ok
+		print "reset after packet %4d: %s, resumed with %4d packets instead of %4d, %d status requests of %d blocks max, eeprom slot 0x%02x" % (reset_after, "flash matches" if ok else "FAILED", mooltipass.device.packets, full_upload_packets, mooltipass.device.status_requests, mooltipass.device.max_mac_blocks, eeprom[0])
+
+	# Values left by older firmwares in the legacy slot, checkpoint not matching the bundle
+	for slot_value, description in ((0x21, "legacy value 0x21"), (0x73, "legacy value 0x73"), ((20 << MEDIA_RESUME_EEP_MARKER_SHT) | MEDIA_RESUME_EEP_MARKER, "checkpoint of another bundle")):
+		flash = empty_flash()
+		eeprom = [slot_value]
+		mooltipass = new_device(flash, eeprom)
+		ok = mooltipass.uploadBundleResume(password, bundle_name, False) and str(flash[:len(bundle)]) == bundle
+		failures += not ok
+		print "%-28s: %s after %4d packets" % (description, "complete upload, flash matches" if ok else "FAILED", mooltipass.device.packets)
+
+	os.remove(bundle_name)
+	sys.exit(1 if failures else 0)
@@ -0,0 +1,154 @@
+#!/usr/bin/env python2
+#
+# CDDL HEADER START
+#
+# The contents of this file are subject to the terms of the
+# Common Development and Distribution License (the "License").
+# You may not use this file except in compliance with the License.
+#
+# You can obtain a copy of the license at src/license_cddl-1.0.txt
+# or http://www.opensolaris.org/os/licensing.
+# See the License for the specific language governing permissions
+# and limitations under the License.
+#
+# When distributing Covered Code, include this CDDL HEADER in each
+# file and include the License file at src/license_cddl-1.0.txt
+# If applicable, add the following below this CDDL HEADER, with the
+# fields enclosed by brackets "[]" replaced with your own identifying
+# information: Portions Copyright [yyyy] [name of copyright owner]
+#
+# CDDL HEADER END
+#
+# Flash internal buffer arbitration between the plugin and the management interface (USB_FEATURE_MGMT_INTERFACE)
+#
+# A management client imports a media bundle on one interface while a plugin sends node writes (CMD_WRITE_FLASH_NODE,
+# 3 packets) and requests doing a read-modify-write of a node page on the other. Both go through the DataFlash internal
+# buffer. usbProcessIncoming() polls the plugin endpoint first, answers CMD_PLEASE_RETRY to the other interface while a
+# node is being written, and checkpoints a half filled media page around plugin requests. The flash contents are
+# compared with what both hosts wrote, with and without that arbitration.
+#
+# usage: mgmt_interface.py
+import sys, random
+
+BYTES_PER_PAGE = 264
+NODE_SIZE = 132
+MEDIA_PAGES = 24
+NODE_PAGES = 8
+IMPORT_PACKET = 33							# mooltipass_hid_device.uploadBundle()
+NODE_PACKET = 59							# PACKET_EXPORT_SIZE - 3
+RUNS = 2000
+PLUGIN_RATE = 0.2							# probability that the plugin has a packet ready at each device loop
+MGMT_RATE = 0.9
+
+class Device(object):
+	def __init__(self, arbitrated):
+		self.arbitrated = arbitrated
+		self.flash = [bytearray(BYTES_PER_PAGE) for _ in range(MEDIA_PAGES + NODE_PAGES)]
+		self.buffer = bytearray(BYTES_PER_PAGE)
+		self.import_page = 0
+		self.import_offset = 0
+		self.import_interface = None
+		self.node_written = None
+		self.node_interface = None
+		self.page_programs = 0
+
+	def program(self, page):
+		self.flash[page][:] = self.buffer
+		self.page_programs += 1
+
+	def load(self, page):
+		self.buffer[:] = self.flash[page]
+
+	def process(self, interface, packet):
+		kind = packet[0]
+		if self.arbitrated:
+			if self.node_written is not None and self.node_interface != interface:
+				return False
+			reload = False
+			if self.import_offset != 0 and self.import_interface != interface:
+				if kind == 'node':
+					return False
+				self.program(self.import_page)
+				reload = True
+		if kind == 'import':
+			data = packet[1]
+			self.import_interface = interface
+			self.buffer[self.import_offset:self.import_offset+len(data)] = data
+			self.import_offset += len(data)
+			if self.import_offset == BYTES_PER_PAGE:
+				self.program(self.import_page)
+				self.import_page += 1
+				self.import_offset = 0
+		elif kind == 'node':
+			node_addr, packet_nb, data = packet[1], packet[2], packet[3]
+			page, node = MEDIA_PAGES + node_addr / 2, node_addr % 2
+			if packet_nb == 0:
+				self.node_written = node_addr
+				self.node_interface = interface
+				self.load(page)
+			offset = node * NODE_SIZE + packet_nb * NODE_PACKET
+			self.buffer[offset:offset+len(data)] = data
+			if packet_nb == NODE_SIZE / NODE_PACKET:
+				self.program(page)
+				self.node_written = None
+		elif kind == 'rmw':
+			# e.g. a child node date update: writeDataToFlash() loads, modifies and programs the page
+			node_addr, value = packet[1], packet[2]
+			page = MEDIA_PAGES + node_addr / 2
+			self.load(page)
+			self.buffer[(node_addr % 2) * NODE_SIZE] = value
+			self.program(page)
+		if self.arbitrated and reload:
+			self.load(self.import_page)
+		return True
+
+def plugin_operations(rng, expected):
+	packets = []
+	for _ in range(rng.randint(3, 8)):
+		node_addr = rng.randrange(NODE_PAGES * 2)
+		if rng.random() < 0.5:
+			node = bytearray(rng.getrandbits(8) for _ in range(NODE_SIZE))
+			expected[node_addr] = node
+			for packet_nb in range(NODE_SIZE / NODE_PACKET + 1):
+				packets.append(('node', node_addr, packet_nb, node[packet_nb*NODE_PACKET:(packet_nb+1)*NODE_PACKET]))
+		else:
+			value = rng.getrandbits(8)
+			expected[node_addr][0] = value
+			packets.append(('rmw', node_addr, value))
+	return packets
+
+def run(seed, arbitrated):
+	rng = random.Random(seed)
+	bundle = bytearray(rng.getrandbits(8) for _ in range(MEDIA_PAGES * BYTES_PER_PAGE))
+	mgmt = [('import', bundle[i:i+IMPORT_PACKET]) for i in range(0, len(bundle), IMPORT_PACKET)]
+	expected_nodes = [bytearray(NODE_SIZE) for _ in range(NODE_PAGES * 2)]
+	plugin = plugin_operations(rng, expected_nodes)
+	device = Device(arbitrated)
+	retries = 0
+	while mgmt or plugin:
+		# The plugin endpoint is polled first
+		if plugin and rng.random() < PLUGIN_RATE:
+			if device.process('plugin', plugin[0]):
+				plugin.pop(0)
+			else:
+				retries += 1
+		elif mgmt and rng.random() < MGMT_RATE:
+			if device.process('mgmt', mgmt[0]):
+				mgmt.pop(0)
+			else:
+				retries += 1
+	media_ok = ''.join(str(p) for p in device.flash[:MEDIA_PAGES]) == str(bundle)
+	nodes_ok = all(str(device.flash[MEDIA_PAGES + a / 2][(a % 2)*NODE_SIZE:(a % 2 + 1)*NODE_SIZE]) == str(expected_nodes[a]) for a in range(NODE_PAGES * 2))
+	return media_ok and nodes_ok, retries, device.page_programs - MEDIA_PAGES
+
+if __name__ == '__main__':
+	print "%d runs: %d media pages imported on the management interface, 3 to 8 node writes or page updates on the plugin one" % (RUNS, MEDIA_PAGES)
+	print "arbitration | runs with wrong flash contents | please retry answers per run | node & checkpoint page programs per run"
+	for arbitrated in (False, True):
+		wrong = retries = programs = 0
+		for seed in range(RUNS):
+			ok, r, p = run(seed, arbitrated)
+			wrong += not ok
+			retries += r
+			programs += p
+		print "%-11s | %30d | %28.2f | %.2f" % ("on" if arbitrated else "off", wrong, float(retries) / RUNS, float(programs) / RUNS)
@@ -0,0 +1,133 @@
+#!/usr/bin/env python2
+#
+# CDDL HEADER START
+#
+# The contents of this file are subject to the terms of the
+# Common Development and Distribution License (the "License").
+# You may not use this file except in compliance with the License.
+#
+# You can obtain a copy of the license at src/license_cddl-1.0.txt
+# or http://www.opensolaris.org/os/licensing.
+# See the License for the specific language governing permissions
+# and limitations under the License.
+#
+# When distributing Covered Code, include this CDDL HEADER in each
+# file and include the License file at src/license_cddl-1.0.txt
+# If applicable, add the following below this CDDL HEADER, with the
+# fields enclosed by brackets "[]" replaced with your own identifying
+# information: Portions Copyright [yyyy] [name of copyright owner]
+#
+# CDDL HEADER END
+#
+# Page programs needed to delete credentials in memory management mode
+#
+# A management client deleting nodes one by one fixes up each surviving neighbor with a CMD_WRITE_FLASH_NODE
+# sequence and erases the node, each a page load and a page program. CMD_DELETE_NODES (deleteNodesBatch()) computes
+# the updates of a whole batch first, then programs each touched page once. Starting parents live in eeprom and
+# aren't counted. Nodes are spread over the flash in the order they were created.
+#
+# usage: node_batch_delete.py
+import random
+
+NODES_PER_PAGE = 2
+NB_SERVICES = 60
+LOGINS_PER_SERVICE = 5
+NODE_BATCH_DELETE_MAX = 16
+RUNS = 200
+
+def new_database(rng):
+	# parents list & children lists, in alphabetical order, nodes at random flash slots
+	nb_nodes = NB_SERVICES * (LOGINS_PER_SERVICE + 1)
+	slots = range(nb_nodes)
+	rng.shuffle(slots)
+	db = {'parents': [], 'children': {}}
+	for s in range(NB_SERVICES):
+		parent = slots.pop()
+		db['parents'].append(parent)
+		db['children'][parent] = [slots.pop() for _ in range(LOGINS_PER_SERVICE)]
+	return db
+
+def owner_list(db, node):
+	if node in db['children']:
+		return db['parents'], None
+	for parent, children in db['children'].iteritems():
+		if node in children:
+			return children, parent
+
+def host_delete(db, nodes):
+	# One node at a time, children before their parent: write each surviving neighbor, then erase the node
+	programs = 0
+	for node in sorted(nodes, key=lambda n: n in db['children']):
+		lst, parent = owner_list(db, node)
+		i = lst.index(node)
+		if i > 0:
+			programs += 1
+		elif parent is not None:
+			programs += 1					# parent first child address
+		if i < len(lst) - 1:
+			programs += 1
+		programs += 1
+		lst.pop(i)
+		if node in db['children']:
+			del db['children'][node]
+	return programs
+
+def batch_delete(db, nodes):
+	# deleteNodesBatch(): erased nodes & surviving neighbors grouped by page
+	touched = set()
+	for node in nodes:
+		touched.add(node / NODES_PER_PAGE)
+	for node in nodes:
+		lst, parent = owner_list(db, node)
+		if parent in nodes:
+			# The whole list is deleted with its parent
+			continue
+		i = lst.index(node)
+		prev = i - 1
+		while prev >= 0 and lst[prev] in nodes:
+			prev -= 1
+		nxt = i + 1
+		while nxt < len(lst) and lst[nxt] in nodes:
+			nxt += 1
+		if prev >= 0:
+			touched.add(lst[prev] / NODES_PER_PAGE)
+		elif parent is not None:
+			touched.add(parent / NODES_PER_PAGE)
+		if nxt < len(lst):
+			touched.add(lst[nxt] / NODES_PER_PAGE)
+	for node in [n for n in nodes if n not in db['children']]:
+		lst, parent = owner_list(db, node)
+		lst.remove(node)
+	for node in [n for n in nodes if n in db['children']]:
+		db['parents'].remove(node)
+		del db['children'][node]
+	return len(touched)
+
+def random_logins(rng, db):
+	children = [c for p in db['parents'] for c in db['children'][p]]
+	picked = rng.sample(children, 100)
+	return [picked[i:i+NODE_BATCH_DELETE_MAX] for i in range(0, len(picked), NODE_BATCH_DELETE_MAX)]
+
+def whole_services(rng, db):
+	services = rng.sample(db['parents'], 20)
+	per_batch = NODE_BATCH_DELETE_MAX / (LOGINS_PER_SERVICE + 1)
+	batches = []
+	for i in range(0, len(services), per_batch):
+		batch = []
+		for parent in services[i:i+per_batch]:
+			batch += [parent] + db['children'][parent]
+		batches.append(batch)
+	return batches
+
+def count(scenario, delete, seed):
+	rng = random.Random(seed)
+	db = new_database(rng)
+	batches = scenario(rng, db)
+	return sum(delete(db, set(batch)) for batch in batches)
+
+if __name__ == '__main__':
+	print "%d services x %d logins, %d nodes per page, batches of %d, mean of %d databases" % (NB_SERVICES, LOGINS_PER_SERVICE, NODES_PER_PAGE, NODE_BATCH_DELETE_MAX, RUNS)
+	for name, scenario in (("100 random logins", random_logins), ("20 whole services", whole_services)):
+		host = sum(count(scenario, host_delete, seed) for seed in range(RUNS))
+		batched = sum(count(scenario, batch_delete, seed) for seed in range(RUNS))
+		print "%-18s: %.1f page programs with host fix-ups, %.1f batched" % (name, float(host) / RUNS, float(batched) / RUNS)
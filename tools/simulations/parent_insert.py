@@ -0,0 +1,112 @@
+#!/usr/bin/env python2
+#
+# CDDL HEADER START
+#
+# The contents of this file are subject to the terms of the
+# Common Development and Distribution License (the "License").
+# You may not use this file except in compliance with the License.
+#
+# You can obtain a copy of the license at src/license_cddl-1.0.txt
+# or http://www.opensolaris.org/os/licensing.
+# See the License for the specific language governing permissions
+# and limitations under the License.
+#
+# When distributing Covered Code, include this CDDL HEADER in each
+# file and include the License file at src/license_cddl-1.0.txt
+# If applicable, add the following below this CDDL HEADER, with the
+# fields enclosed by brackets "[]" replaced with your own identifying
+# information: Portions Copyright [yyyy] [name of copyright owner]
+#
+# CDDL HEADER END
+#
+# Node reads to insert a new credential service with createParentNode()
+#
+# Before: the insertion point walk starts from the first parent, then populateServicesLut() walks the whole list.
+# After: the walk starts from getParentNodeForLetter() and insertServiceInServicesLut() patches the LUT for the new
+# node. The patched LUT is checked against a full rebuild after each insertion.
+# Names are random with English first letter frequencies, 300 insertions per database size.
+#
+# usage: parent_insert.py
+import random, string, sys
+
+FIRST_LETTERS = "etaoinshrdlcumwfgypbvkjxqz"
+FIRST_LETTER_WEIGHTS = [12, 9, 8, 8, 7, 7, 6, 6, 6, 4, 4, 3, 3, 2, 2, 2, 2, 2, 2, 1.5, 1, 0.8, 0.2, 0.2, 0.1, 0.1]
+INSERTIONS = 300
+
+def weighted_choice(rng, items, weights):
+	x = rng.uniform(0, sum(weights))
+	for item, weight in zip(items, weights):
+		x -= weight
+		if x <= 0:
+			return item
+	return items[-1]
+
+def new_name(rng):
+	return weighted_choice(rng, FIRST_LETTERS, FIRST_LETTER_WEIGHTS) + ''.join(rng.choice(string.ascii_lowercase + '.') for _ in range(rng.randint(3, 12)))
+
+def services_lut(services):
+	lut = {}
+	for i, s in enumerate(services):
+		if 'a' <= s[0] <= 'z' and s[0] not in lut:
+			lut[s[0]] = i
+	return lut
+
+def parent_for_letter(lut, c):
+	# getParentNodeForLetter(): first service of the closest populated letter not after c
+	if not ('a' <= c <= 'z'):
+		return 0
+	for l in range(ord(c), ord('a') - 1, -1):
+		if chr(l) in lut:
+			return lut[chr(l)]
+	return 0
+
+def insertion_cost(services, name, lut, from_lut):
+	i = parent_for_letter(lut, name[0]) if from_lut else 0
+	reads = 0
+	while True:
+		reads += 1
+		if name > services[i]:
+			if i == len(services) - 1:
+				position = len(services)
+				break
+			i += 1
+		else:
+			position = i
+			# Previous node update
+			reads += 1 if i > 0 else 0
+			break
+	if not from_lut:
+		# populateServicesLut() walk
+		reads += len(services) + 1
+	return reads, position
+
+def patched_lut(lut, name, position):
+	# insertServiceInServicesLut()
+	patched = dict((k, v + 1 if v >= position else v) for k, v in lut.items())
+	if 'a' <= name[0] <= 'z' and (name[0] not in lut or lut[name[0]] == position):
+		patched[name[0]] = position
+	return patched
+
+if __name__ == '__main__':
+	rng = random.Random(7)
+	lut_errors = 0
+	for nb_services in (50, 150, 300, 600, 1000):
+		before = after = 0
+		for _ in range(INSERTIONS):
+			services = sorted(set(new_name(rng) for _ in range(nb_services)))
+			lut = services_lut(services)
+			name = new_name(rng)
+			if name in services:
+				continue
+			reads_before, position_before = insertion_cost(services, name, lut, False)
+			reads_after, position = insertion_cost(services, name, lut, True)
+			lut_errors += position != position_before
+			lut_errors += patched_lut(lut, name, position) != services_lut(services[:position] + [name] + services[position:])
+			before += reads_before
+			after += reads_after
+		print "%5d services: %7.1f -> %5.1f node reads per new service" % (nb_services, float(before) / INSERTIONS, float(after) / INSERTIONS)
+	services = sorted(set(new_name(rng) for _ in range(600)))
+	lut = services_lut(services)
+	print "'zendesk' in %d services: %d -> %d" % (len(services), insertion_cost(services, 'zendesk', lut, False)[0], insertion_cost(services, 'zendesk', lut, True)[0])
+	print "insertion points or patched LUTs differing from a full rebuild: %d" % lut_errors
+	sys.exit(1 if lut_errors else 0)
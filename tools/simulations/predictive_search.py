@@ -0,0 +1,107 @@
+#!/usr/bin/env python2
+#
+# CDDL HEADER START
+#
+# The contents of this file are subject to the terms of the
+# Common Development and Distribution License (the "License").
+# You may not use this file except in compliance with the License.
+#
+# You can obtain a copy of the license at src/license_cddl-1.0.txt
+# or http://www.opensolaris.org/os/licensing.
+# See the License for the specific language governing permissions
+# and limitations under the License.
+#
+# When distributing Covered Code, include this CDDL HEADER in each
+# file and include the License file at src/license_cddl-1.0.txt
+# If applicable, add the following below this CDDL HEADER, with the
+# fields enclosed by brackets "[]" replaced with your own identifying
+# information: Portions Copyright [yyyy] [name of copyright owner]
+#
+# CDDL HEADER END
+#
+# Wheel steps and clicks to reach a service with the on-device search (GUI_FEATURE_PREDICTIVE_SEARCH)
+#
+# Standard: the search screen wheel goes through a-z0-9, the predictive one only stops on characters leading to a
+# service and a unique prefix collapses the results. Mini: miniTextEntry() goes through the 95 printable characters
+# plus OK/XX/<-, the predictive one only through the characters returned by getServiceNextCharacters() and a unique
+# prefix preselects OK. The old mini login list (scroll & first letter jumps) is given for reference.
+# Service names are synthetic domain-like names, 100 random targets per database.
+#
+# usage: predictive_search.py
+import random
+
+SYLLABLES = ["go", "ama", "zon", "face", "book", "git", "hub", "mail", "bank", "shop", "net", "flix", "drop", "box", "red", "dit", "you", "tube", "link", "ed", "in", "pay", "pal", "sta", "ck", "over", "flow", "ap", "ple", "mi", "cro", "soft", "tw", "it", "ter", "ya", "hoo"]
+TLDS = [".com", ".org", ".net", ".io", ".fr", ".de"]
+STD_CHARSET = "abcdefghijklmnopqrstuvwxyz0123456789"
+MINI_CHARSET = [chr(0x20 + ((36 + o - 3) % 95)) for o in range(95)] + ["OK", "XX", "<-"]
+MINI_OK = 95
+
+def new_database(rng, nb_services):
+	services = set()
+	while len(services) < nb_services:
+		services.add("".join(rng.choice(SYLLABLES) for _ in range(rng.randint(1, 3))) + rng.choice(TLDS))
+	return sorted(services)
+
+def circular_distance(a, b, n):
+	d = abs(a - b)
+	return min(d, n - d)
+
+def std_steps(services, target, predictive):
+	steps = 0
+	text = ""
+	while True:
+		first = [s for s in services if s >= text][:5] if text else services[:5]
+		matches = [s for s in services if s.startswith(text)] if text else services
+		if text and target in first[:4]:
+			break
+		if text and predictive and len(matches) == 1:
+			break
+		next_char = target[len(text)]
+		options = [c for c in STD_CHARSET if any(s.startswith(text + c) for s in services)] if predictive else STD_CHARSET
+		if next_char not in options:
+			return None
+		start = options[0] if predictive else 'a'
+		steps += circular_distance(options.index(start), options.index(next_char), len(options)) + (1 if text else 0)
+		text += next_char
+	return steps + 1
+
+def mini_steps(services, target, predictive):
+	steps = 0
+	text = ""
+	while True:
+		matches = [s for s in services if s.startswith(text)]
+		if predictive and len(matches) == 1:
+			# OK preselected, then confirm in the login list
+			return steps + 2
+		if text == target:
+			# Reach OK, confirm, click in the list
+			return steps + circular_distance(0, MINI_OK, len(MINI_CHARSET)) + 2
+		next_char = target[len(text)]
+		if predictive:
+			options = sorted(set(s[len(text)] for s in matches if len(s) > len(text)), key=lambda c: MINI_CHARSET.index(c))
+			selectable = [MINI_CHARSET.index(c) for c in options] + [95, 96, 97]
+			steps += circular_distance(0, selectable.index(MINI_CHARSET.index(next_char)), len(selectable))
+		else:
+			steps += circular_distance(0, MINI_CHARSET.index(next_char), len(MINI_CHARSET))
+		steps += 1
+		text += next_char
+
+def mini_list_steps(services, target):
+	# Scroll from the last parent, or first letter jumps then scroll
+	i = services.index(target)
+	n = len(services)
+	scroll = circular_distance(n - 1, i, n) + 1
+	letters = sorted(set(s[0] for s in services))
+	letter_index = letters.index(target[0])
+	first_of_letter = [services.index(next(s for s in services if s[0] == l)) for l in letters]
+	jump = letter_index + (i - first_of_letter[letter_index]) + 1
+	return min(scroll, jump)
+
+if __name__ == '__main__':
+	rng = random.Random(7)
+	print "services | std old | std new | mini list | mini text old | mini predictive"
+	for nb_services in (20, 60, 150, 300):
+		services = new_database(rng, nb_services)
+		targets = rng.sample(services, min(100, nb_services))
+		mean = lambda f: float(sum(f(t) for t in targets)) / len(targets)
+		print "%8d | %7.1f | %7.1f | %9.1f | %13.1f | %15.1f" % (nb_services, mean(lambda t: std_steps(services, t, False)), mean(lambda t: std_steps(services, t, True)), mean(lambda t: mini_list_steps(services, t)), mean(lambda t: mini_steps(services, t, False)), mean(lambda t: mini_steps(services, t, True)))
@@ -0,0 +1,50 @@
+#!/usr/bin/env python2
+#
+# CDDL HEADER START
+#
+# The contents of this file are subject to the terms of the
+# Common Development and Distribution License (the "License").
+# You may not use this file except in compliance with the License.
+#
+# You can obtain a copy of the license at src/license_cddl-1.0.txt
+# or http://www.opensolaris.org/os/licensing.
+# See the License for the specific language governing permissions
+# and limitations under the License.
+#
+# When distributing Covered Code, include this CDDL HEADER in each
+# file and include the License file at src/license_cddl-1.0.txt
+# If applicable, add the following below this CDDL HEADER, with the
+# fields enclosed by brackets "[]" replaced with your own identifying
+# information: Portions Copyright [yyyy] [name of copyright owner]
+#
+# CDDL HEADER END
+#
+# Raw HID request throughput with tagged requests (USB_FEATURE_TAGGED_REQUESTS), timing model
+#
+# Closed loop of k requests in flight: OUT frame, device service (one request at a time), IN frame, host turnaround.
+# Untagged hosts keep a single request in flight, tagged hosts up to 3. The costs are the constants below, this is
+# not a measurement: python_comms menu 44 (pingThroughput) measures the real figure on a device.
+#
+# usage: tagged_requests.py
+import random
+
+HID_FRAME_MS = 1.0							# 1ms bInterval, each way
+DEVICE_SERVICE_MS = 1.0
+HOST_TURNAROUND_MS = (1.0, 3.0)
+REQUESTS = 100000
+
+def throughput(rng, in_flight):
+	# Times at which each in flight request reaches the device, device busy until device_free
+	arrivals = [HID_FRAME_MS] * in_flight
+	device_free = 0.0
+	for _ in range(REQUESTS):
+		i = arrivals.index(min(arrivals))
+		start = max(arrivals[i], device_free)
+		device_free = start + DEVICE_SERVICE_MS
+		arrivals[i] = device_free + HID_FRAME_MS + rng.uniform(*HOST_TURNAROUND_MS) + HID_FRAME_MS
+	return REQUESTS / (device_free / 1000.0)
+
+if __name__ == '__main__':
+	rng = random.Random(1)
+	for in_flight in (1, 2, 3):
+		print "%d request(s) in flight: %4.0f req/s" % (in_flight, throughput(rng, in_flight))
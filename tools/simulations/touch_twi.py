@@ -0,0 +1,112 @@
+#!/usr/bin/env python2
+#
+# CDDL HEADER START
+#
+# The contents of this file are subject to the terms of the
+# Common Development and Distribution License (the "License").
+# You may not use this file except in compliance with the License.
+#
+# You can obtain a copy of the license at src/license_cddl-1.0.txt
+# or http://www.opensolaris.org/os/licensing.
+# See the License for the specific language governing permissions
+# and limitations under the License.
+#
+# When distributing Covered Code, include this CDDL HEADER in each
+# file and include the License file at src/license_cddl-1.0.txt
+# If applicable, add the following below this CDDL HEADER, with the
+# fields enclosed by brackets "[]" replaced with your own identifying
+# information: Portions Copyright [yyyy] [name of copyright owner]
+#
+# CDDL HEADER END
+#
+# Main loop time spent in I2C by touchDetectionRoutine() (Mooltipass standard), blocking driver vs TOUCH_FEATURE_TWI_INTERRUPT queue
+#
+# A simulated TWI controller clocks the bus at 400KHz and raises TWINT after each phase, a simulated AT42QT2120 acks or
+# stops answering. The blocking driver spins until TWINT, the queue driver only pays for queuing and for the interrupts.
+# CPU costs of the queue & interrupt code are cycle estimates (constants below), not measurements.
+#
+# usage: touch_twi.py
+import sys
+
+F_CPU = 16000000
+BIT_US = 1e6 / 400000						# I2C bit time at 400KHz
+CYCLE_US = 1e6 / F_CPU
+QUEUE_CYCLES = 60							# touchQueueTransaction(): atomic block, slot copy, start condition
+ISR_CYCLES = 70								# ISR(TWI_vect): prologue, state switch, epilogue
+IDLE_CHECK_CYCLES = 10						# touchIsQueueIdle() call
+TWI_QUEUE_SIZE = 8
+TWI_QUEUE_TIMEOUT_LOOPS = 500				# touchWaitForQueueIdle(), 10us per loop
+
+class At42qt2120:
+	""" Register file of the touch controller, answering = False emulates a bus held low: TWINT never comes """
+	def __init__(self):
+		self.registers = [0] * 256
+		self.answering = True
+
+class TwiBus:
+	""" TWI controller: returns the duration of each transaction phase, each phase ends with TWINT """
+	# Phases of a register write: START, SLA+W, register, data, then STOP
+	WRITE_PHASES = [1, 9, 9, 9]
+	# Phases of a register read: START, SLA+W, register, repeated START, SLA+R, data (NACK), then STOP
+	READ_PHASES = [1, 9, 9, 1, 9, 9]
+	def __init__(self, chip):
+		self.chip = chip
+	def phases(self, is_read):
+		""" Return the bit durations of the phases raising TWINT, None when TWINT never comes """
+		if not self.chip.answering:
+			return None
+		if is_read:
+			return self.READ_PHASES
+		return self.WRITE_PHASES
+
+def blocking_transaction(bus, is_read):
+	""" readDataFromTS() / writeDataToTS() without the queue: the CPU spins during the whole transaction """
+	phases = bus.phases(is_read)
+	if phases is None:
+		# waitForTwintFlag() has no bound
+		return float("inf")
+	return (sum(phases) + 1) * BIT_US
+
+def queued_transactions(bus, transactions):
+	""" Return (cpu time, bus time) of transactions queued by the main loop and run by the TWI interrupt """
+	cpu_us = 0.0
+	bus_us = 0.0
+	for is_read in transactions[:TWI_QUEUE_SIZE-1]:
+		cpu_us += QUEUE_CYCLES * CYCLE_US
+		phases = bus.phases(is_read)
+		if phases is None:
+			return cpu_us, float("inf")
+		cpu_us += len(phases) * ISR_CYCLES * CYCLE_US
+		bus_us += (sum(phases) + 1) * BIT_US
+	return cpu_us, bus_us
+
+def bounded_wait(bus, transactions):
+	""" Blocking register access while the queue is busy: touchWaitForQueueIdle() then the access """
+	cpu_us, bus_us = queued_transactions(bus, transactions)
+	if bus_us == float("inf"):
+		return TWI_QUEUE_TIMEOUT_LOOPS * 10.0, "RETURN_NOK, TWI reset"
+	return bus_us, "RETURN_OK"
+
+def main():
+	chip = At42qt2120()
+	bus = TwiBus(chip)
+	# A touch change: DET_STAT, KEY_STAT1, SLIDER_POS & KEY_STAT2 reads, a LED change: up to 6 LED register writes
+	scenarios = [("touch change", [True]*4), ("LED update", [False]*6), ("touch change + 3 LED writes", [True]*4 + [False]*3)]
+
+	print "Main loop time spent in I2C per touchDetectionRoutine() event (us)"
+	print "%-28s %12s %12s %12s" % ("event", "blocking", "queue (CPU)", "bus busy")
+	for name, transactions in scenarios:
+		blocking_us = sum(blocking_transaction(bus, is_read) for is_read in transactions)
+		cpu_us, bus_us = queued_transactions(bus, transactions)
+		print "%-28s %12.1f %12.1f %12.1f" % (name, blocking_us, cpu_us, bus_us)
+
+	print
+	print "Bus held low by the touch controller"
+	chip.answering = False
+	print "  blocking driver:             %s" % ("spins in waitForTwintFlag()" if blocking_transaction(bus, True) == float("inf") else "returns")
+	wait_us, result = bounded_wait(bus, [True]*4)
+	print "  readDataFromTS() with queue: %s after %.0f us" % (result, wait_us)
+	return 0
+
+if __name__ == "__main__":
+	sys.exit(main())